@@ -0,0 +1,87 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+// Compile-time CAT command catalogue.
+// Every set-command we send is "<prefix><fixed-width digits>;", so the
+// prefix, digit count and total length are known at compile time and the
+// encoder only has to drop digits into a buffer - no snprintf, no strlen.
+
+constexpr size_t catStrLen(const char *s)
+{
+    return *s ? 1 + catStrLen(s + 1) : 0;
+}
+
+// ---- catalogue ----
+struct CatCmdFA   { static constexpr const char *prefix() { return "FA"; }   enum : uint8_t { DIGITS = 11 }; }; // VFO A, Hz
+struct CatCmdMD   { static constexpr const char *prefix() { return "MD"; }   enum : uint8_t { DIGITS = 1 };  }; // mode code
+struct CatCmdZZAG { static constexpr const char *prefix() { return "ZZAG"; } enum : uint8_t { DIGITS = 3 };  }; // AF gain %
+struct CatCmdZZFI { static constexpr const char *prefix() { return "ZZFI"; } enum : uint8_t { DIGITS = 2 };  }; // filter preset
+struct CatCmdZZPC { static constexpr const char *prefix() { return "ZZPC"; } enum : uint8_t { DIGITS = 3 };  }; // RF power %
+struct CatCmdZZTX { static constexpr const char *prefix() { return "ZZTX"; } enum : uint8_t { DIGITS = 1 };  }; // MOX
+
+// Encoder for one catalogue entry.
+// Keeps its own send buffer; encode() rewrites only the digits that differ
+// from the previous value (a 1 Hz FA step touches one or two characters).
+template <typename Cmd>
+class CatEncoder
+{
+public:
+    static constexpr uint8_t PREFIX_LEN = (uint8_t)catStrLen(Cmd::prefix());
+    static constexpr uint8_t DIGITS = Cmd::DIGITS;
+    static constexpr uint8_t LEN = PREFIX_LEN + DIGITS + 1; // incl. ';'
+
+    CatEncoder()
+    {
+        memcpy(_buf, Cmd::prefix(), PREFIX_LEN);
+        memset(_buf + PREFIX_LEN, '0', DIGITS);
+        _buf[LEN - 1] = ';';
+        _buf[LEN] = '\0';
+    }
+
+    // Encode `value` (high digits beyond DIGITS are dropped) -> "<prefix>digits;"
+    const char *encode(uint32_t value)
+    {
+        uint32_t now = value, before = _last;
+        for (int8_t i = PREFIX_LEN + DIGITS - 1; i >= PREFIX_LEN; i--)
+        {
+            uint8_t d = now % 10;
+            if (d != before % 10)
+                _buf[i] = char('0' + d);
+            now /= 10;
+            before /= 10;
+            if (now == before)
+                break; // remaining high digits are unchanged
+        }
+        _last = value;
+        return _buf;
+    }
+
+    // Stateless variant: full encode into any buffer with >= LEN bytes (no NUL)
+    static size_t write(char *dst, uint32_t value)
+    {
+        memcpy(dst, Cmd::prefix(), PREFIX_LEN);
+        for (int8_t i = PREFIX_LEN + DIGITS - 1; i >= PREFIX_LEN; i--)
+        {
+            dst[i] = char('0' + value % 10);
+            value /= 10;
+        }
+        dst[LEN - 1] = ';';
+        return LEN;
+    }
+
+    // Same, NUL-terminated (dst needs LEN + 1 bytes) - handy for logs
+    static const char *text(char *dst, uint32_t value)
+    {
+        dst[write(dst, value)] = '\0';
+        return dst;
+    }
+
+    const char *c_str() const { return _buf; }
+    static constexpr size_t length() { return LEN; }
+
+private:
+    char _buf[LEN + 1];
+    uint32_t _last = 0; // matches the all-zero digits set up in the constructor
+};
@@ -0,0 +1,148 @@
+#include "HB9IIUCatParser.h"
+#include <string.h>
+
+// Opcode table: longest prefixes first so "ZZ.." never matches a 2-letter op
+struct CatOpInfo
+{
+    const char *prefix;
+    uint8_t prefixLen;
+    CatOp op;
+};
+
+static const CatOpInfo CAT_OPS[] = {
+    {"ZZAG", 4, CAT_OP_ZZAG},
+    {"ZZFI", 4, CAT_OP_ZZFI},
+    {"ZZPC", 4, CAT_OP_ZZPC},
+    {"ZZTX", 4, CAT_OP_ZZTX},
+    {"FA", 2, CAT_OP_FA},
+    {"MD", 2, CAT_OP_MD},
+    {"AI", 2, CAT_OP_AI},
+    {"?", 1, CAT_OP_ERROR},
+};
+static const size_t NUM_CAT_OPS = sizeof(CAT_OPS) / sizeof(CAT_OPS[0]);
+
+const char *catOpName(CatOp op)
+{
+    for (size_t i = 0; i < NUM_CAT_OPS; i++)
+        if (CAT_OPS[i].op == op)
+            return CAT_OPS[i].prefix;
+    return "??";
+}
+
+size_t CatParser::writable(uint8_t *&dst)
+{
+    size_t used = _head - _tail;
+    size_t idx = _head & (RING_SIZE - 1);
+    size_t contiguous = RING_SIZE - idx;
+    size_t space = RING_SIZE - used;
+    dst = &_ring[idx];
+    return space < contiguous ? space : contiguous;
+}
+
+void CatParser::commit(size_t n)
+{
+    _head += n;
+}
+
+size_t CatParser::write(const uint8_t *data, size_t len)
+{
+    size_t done = 0;
+    while (done < len)
+    {
+        uint8_t *dst;
+        size_t room = writable(dst);
+        if (room == 0)
+            break;
+        size_t n = len - done < room ? len - done : room;
+        memcpy(dst, data + done, n);
+        commit(n);
+        done += n;
+    }
+    return done;
+}
+
+void CatParser::reset()
+{
+    _head = _tail = 0;
+    _state = IN_FRAME;
+    _accLen = 0;
+}
+
+bool CatParser::next(CatFrame &out)
+{
+    while (_tail != _head)
+    {
+        char c = (char)_ring[_tail & (RING_SIZE - 1)];
+        _tail++;
+
+        switch (_state)
+        {
+        case IN_FRAME:
+            if (c == ';')
+            {
+                if (_accLen == 0)
+                    break; // stray ';'
+                finishFrame(out);
+                return true;
+            }
+            if (c == '\r' || c == '\n')
+                break;
+            if (_accLen < sizeof(_acc) - 2) // room for ';' + NUL
+            {
+                _acc[_accLen++] = c;
+            }
+            else
+            {
+                _state = DISCARD;
+                _malformed++;
+            }
+            break;
+
+        case DISCARD:
+            if (c == ';')
+            {
+                _state = IN_FRAME;
+                _accLen = 0;
+            }
+            break;
+        }
+    }
+    return false; // only a partial frame (or nothing) buffered
+}
+
+void CatParser::finishFrame(CatFrame &out)
+{
+    memcpy(out.text, _acc, _accLen);
+    out.text[_accLen] = ';';
+    out.text[_accLen + 1] = '\0';
+    out.len = _accLen + 1;
+
+    out.op = CAT_OP_OTHER;
+    out.hasValue = false;
+    out.value = 0;
+
+    uint8_t pos = 0;
+    for (size_t i = 0; i < NUM_CAT_OPS; i++)
+    {
+        const CatOpInfo &info = CAT_OPS[i];
+        if (_accLen >= info.prefixLen && memcmp(_acc, info.prefix, info.prefixLen) == 0)
+        {
+            out.op = info.op;
+            pos = info.prefixLen;
+            break;
+        }
+    }
+
+    // digits after the opcode, parsed straight from the buffer
+    if (out.op != CAT_OP_OTHER && pos < _accLen)
+    {
+        int32_t v = 0;
+        uint8_t i = pos;
+        while (i < _accLen && _acc[i] >= '0' && _acc[i] <= '9')
+            v = v * 10 + (_acc[i++] - '0');
+        out.hasValue = (i == _accLen);
+        out.value = out.hasValue ? v : 0;
+    }
+
+    _accLen = 0;
+}
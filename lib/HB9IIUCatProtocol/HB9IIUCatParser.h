@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+// Opcodes we care about; everything else arrives as CAT_OP_OTHER
+enum CatOp : uint8_t
+{
+    CAT_OP_OTHER = 0,
+    CAT_OP_FA,    // VFO A frequency, 11 digits (Hz)
+    CAT_OP_MD,    // mode code
+    CAT_OP_ZZAG,  // AF gain 000..100
+    CAT_OP_ZZFI,  // filter preset 00..07
+    CAT_OP_ZZPC,  // RF power 000..100
+    CAT_OP_ZZTX,  // MOX 0/1
+    CAT_OP_AI,    // auto-information 0/1
+    CAT_OP_ERROR, // "?;" (command rejected)
+    CAT_OP_COUNT
+};
+
+// One CAT line in either direction, e.g. "FA00014074000;" or "ZZAG050;"
+// For received frames the parser also fills op/value, so nobody
+// downstream has to look at the text again.
+struct CatFrame
+{
+    CatOp op;
+    bool hasValue;   // true if digits followed the opcode
+    int32_t value;   // those digits, parsed in place
+    uint8_t len;     // strlen(text)
+    char text[31];   // NUL-terminated, trailing ';' included
+};
+
+// Short name for logs ("FA", "ZZAG", ...)
+const char *catOpName(CatOp op);
+
+// Incremental CAT frame parser.
+// Socket bytes go into a fixed ring; next() walks them one byte at a time
+// and returns each complete "...;" frame. A partial frame simply stays
+// buffered until the rest arrives - nothing ever waits, nothing allocates.
+class CatParser
+{
+public:
+    // Zero-copy fill: where the socket may read to, and how much fits there
+    size_t writable(uint8_t *&dst);
+    // ...then tell the ring how many bytes actually landed
+    void commit(size_t n);
+    // Copying variant; returns bytes accepted (rest is dropped)
+    size_t write(const uint8_t *data, size_t len);
+
+    // Next complete frame, false if none is buffered yet
+    bool next(CatFrame &out);
+
+    // Forget everything (new connection)
+    void reset();
+
+    uint32_t malformed() const { return _malformed; }
+
+private:
+    static const size_t RING_SIZE = 256; // power of two
+
+    enum State : uint8_t
+    {
+        IN_FRAME, // collecting bytes of a frame
+        DISCARD   // frame too long: skip to the next ';'
+    };
+
+    void finishFrame(CatFrame &out);
+
+    uint8_t _ring[RING_SIZE];
+    uint32_t _head = 0; // write position (free-running)
+    uint32_t _tail = 0; // read position (free-running)
+
+    State _state = IN_FRAME;
+    char _acc[sizeof(CatFrame::text)];
+    uint8_t _accLen = 0;
+    uint32_t _malformed = 0;
+};
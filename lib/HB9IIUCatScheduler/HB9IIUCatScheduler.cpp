@@ -0,0 +1,167 @@
+#include "HB9IIUCatScheduler.h"
+
+const uint16_t CatScheduler::FA_HIST_EDGES_MS[FA_HIST_BUCKETS - 1] = {30, 50, 70, 100, 150, 250, 500};
+static const uint32_t FA_IDLE_GAP_MS = 1000; // longer gaps are pauses, not update intervals
+
+void CatScheduler::begin(CatTransport &link, uint16_t tickMs, uint8_t burst, uint16_t perSecond)
+{
+    _link = &link;
+    _tickMs = tickMs;
+    _tokenCap = (uint32_t)burst * 1000;
+    _tokens = _tokenCap;
+    _perSecond = perSecond;
+    _lastRefill = millis();
+}
+
+void CatScheduler::set(CatSlot slot, uint32_t value)
+{
+    if (_dirty[slot])
+    {
+        if (_value[slot] == value)
+            return;
+        _coalesced++; // the older unsent value will never hit the wire
+    }
+    _value[slot] = value;
+    _dirty[slot] = true;
+}
+
+void CatScheduler::cancel(CatSlot slot)
+{
+    _dirty[slot] = false;
+}
+
+void CatScheduler::dropPending()
+{
+    for (uint8_t i = 0; i < CAT_SLOT_COUNT; i++)
+    {
+        if (_dirty[i])
+        {
+            _dirty[i] = false;
+            _dropped++;
+        }
+    }
+}
+
+bool CatScheduler::tick()
+{
+    if (millis() - _lastEmit < _tickMs)
+        return false;
+    return emit(false);
+}
+
+bool CatScheduler::flush()
+{
+    return emit(true);
+}
+
+void CatScheduler::refill()
+{
+    uint32_t now = millis();
+    uint32_t elapsed = now - _lastRefill;
+    _lastRefill = now;
+    _tokens += elapsed * _perSecond; // ms * tokens/s = milli-tokens
+    if (_tokens > _tokenCap)
+        _tokens = _tokenCap;
+}
+
+size_t CatScheduler::encodeSlot(CatSlot slot, char *dst)
+{
+    const char *src = nullptr;
+    size_t len = 0;
+    switch (slot)
+    {
+    case CAT_SLOT_VFO:
+        src = _encFA.encode(_value[slot]);
+        len = _encFA.length();
+        break;
+    case CAT_SLOT_AFGAIN:
+        src = _encZZAG.encode(_value[slot]);
+        len = _encZZAG.length();
+        break;
+    case CAT_SLOT_FILTER:
+        src = _encZZFI.encode(_value[slot]);
+        len = _encZZFI.length();
+        break;
+    case CAT_SLOT_POWER:
+        src = _encZZPC.encode(_value[slot]);
+        len = _encZZPC.length();
+        break;
+    case CAT_SLOT_MODE:
+        src = _encMD.encode(_value[slot]);
+        len = _encMD.length();
+        break;
+    default:
+        return 0;
+    }
+    memcpy(dst, src, len);
+    return len;
+}
+
+bool CatScheduler::emit(bool ignoreBudget)
+{
+    if (!_link || !_link->connected())
+        return false;
+
+    refill();
+
+    // Mode goes first so a following FA lands in the new mode; VFO next
+    static const CatSlot ORDER[CAT_SLOT_COUNT] = {
+        CAT_SLOT_MODE, CAT_SLOT_VFO, CAT_SLOT_FILTER, CAT_SLOT_AFGAIN, CAT_SLOT_POWER};
+
+    size_t n = 0;
+    bool included[CAT_SLOT_COUNT] = {};
+    uint8_t count = 0;
+    for (uint8_t i = 0; i < CAT_SLOT_COUNT; i++)
+    {
+        CatSlot slot = ORDER[i];
+        if (!_dirty[slot])
+            continue;
+        if (_tokens < 1000 && !ignoreBudget)
+            break; // budget exhausted: the rest waits for a later tick
+        char tmp[24];
+        size_t len = encodeSlot(slot, tmp);
+        if (n + len > sizeof(CatTxPacket::data))
+            break;
+        memcpy(_batch + n, tmp, len);
+        n += len;
+        included[slot] = true;
+        count++;
+    }
+    if (n == 0)
+        return false;
+    _batch[n] = '\0';
+
+    if (!_link->send(_batch, n, CAT_LANE_INTERACTIVE))
+        return false; // transport full: values stay dirty
+
+    // a forced flush may overdraw the bucket; it just starts from empty
+    uint32_t cost = (uint32_t)count * 1000;
+    _tokens = _tokens > cost ? _tokens - cost : 0;
+
+    _lastSlots = 0;
+    for (uint8_t i = 0; i < CAT_SLOT_COUNT; i++)
+    {
+        if (included[i])
+        {
+            _dirty[i] = false;
+            _lastSlots |= 1 << i;
+        }
+    }
+    _sent += count;
+    _batches++;
+    _lastEmit = millis();
+
+    if (included[CAT_SLOT_VFO])
+    {
+        uint32_t gap = _lastEmit - _lastFaMs;
+        if (_lastFaMs && gap < FA_IDLE_GAP_MS)
+        {
+            uint8_t b = 0;
+            while (b < FA_HIST_BUCKETS - 1 && gap >= FA_HIST_EDGES_MS[b])
+                b++;
+            _faHist[b]++;
+        }
+        _lastFaMs = _lastEmit;
+    }
+    return true;
+}
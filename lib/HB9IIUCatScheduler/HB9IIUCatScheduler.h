@@ -0,0 +1,102 @@
+#pragma once
+#include <Arduino.h>
+#include "HB9IIUCatCommands.h"
+#include "HB9IIUCatTransport.h"
+
+// One slot per radio setting we write
+enum CatSlot : uint8_t
+{
+    CAT_SLOT_VFO = 0, // FA   (Hz)
+    CAT_SLOT_AFGAIN,  // ZZAG (0..100)
+    CAT_SLOT_FILTER,  // ZZFI (0..7)
+    CAT_SLOT_POWER,   // ZZPC (0..100)
+    CAT_SLOT_MODE,    // MD   (code)
+    CAT_SLOT_COUNT
+};
+
+// Coalescing, last-writer-wins command scheduler.
+// set() only records the newest value of a setting; tick() sends every
+// dirty slot together in ONE transport packet (= one TCP segment), at most
+// once per tick, within a token-bucket budget so SmartSDR's CAT port is
+// never flooded. Values overwritten before they went out are "coalesced".
+class CatScheduler
+{
+public:
+    // tickMs: minimum spacing between writes
+    // burst / perSecond: token bucket (one token per command)
+    void begin(CatTransport &link, uint16_t tickMs, uint8_t burst, uint16_t perSecond);
+
+    // Write spacing can be changed at any time (rate control)
+    void setTickMs(uint16_t tickMs) { _tickMs = tickMs; }
+    uint16_t tickMs() const { return _tickMs; }
+
+    // Record the newest value for a slot (sent on a later tick)
+    void set(CatSlot slot, uint32_t value);
+    // Forget an unsent value (e.g. the radio just told us something newer)
+    void cancel(CatSlot slot);
+    bool pending(CatSlot slot) const { return _dirty[slot]; }
+
+    // Call every loop(): true if a batch was handed to the transport
+    bool tick();
+    // Send whatever is dirty right now, ignoring the tick spacing and the
+    // token budget (used before keying PTT so mode/power land first).
+    // Check pending() afterwards: a full transport ring leaves slots dirty.
+    bool flush();
+
+    // Link lost: unsent values are discarded and counted as dropped
+    void dropPending();
+
+    // Last batch handed to the transport (NUL-terminated, for logs), and
+    // which slots it carried (bit per CatSlot) with what value
+    const char *lastBatch() const { return _batch; }
+    bool lastSent(CatSlot slot) const { return _lastSlots & (1 << slot); }
+    uint32_t value(CatSlot slot) const { return _value[slot]; }
+
+    uint32_t sent() const { return _sent; }           // commands written
+    uint32_t coalesced() const { return _coalesced; } // overwritten before sending
+    uint32_t dropped() const { return _dropped; }     // discarded (link down)
+    uint32_t batches() const { return _batches; }     // transport writes
+
+    // Achieved spacing between FA writes while tuning (gaps of a second or
+    // more are idle time, not counted). Bucket i holds intervals below
+    // FA_HIST_EDGES_MS[i]; the last one everything up to a second.
+    static const uint8_t FA_HIST_BUCKETS = 8;
+    static const uint16_t FA_HIST_EDGES_MS[FA_HIST_BUCKETS - 1];
+    uint32_t faHistogram(uint8_t bucket) const { return _faHist[bucket]; }
+
+private:
+    bool emit(bool ignoreBudget);
+    void refill();
+    size_t encodeSlot(CatSlot slot, char *dst);
+
+    CatTransport *_link = nullptr;
+    uint16_t _tickMs = 60;
+    uint32_t _lastEmit = 0;
+
+    // token bucket, in milli-tokens
+    uint32_t _tokens = 0;
+    uint32_t _tokenCap = 0;
+    uint16_t _perSecond = 0;
+    uint32_t _lastRefill = 0;
+
+    uint32_t _value[CAT_SLOT_COUNT] = {};
+    bool _dirty[CAT_SLOT_COUNT] = {};
+
+    // per-command send buffers (only changed digits get rewritten)
+    CatEncoder<CatCmdFA> _encFA;
+    CatEncoder<CatCmdZZAG> _encZZAG;
+    CatEncoder<CatCmdZZFI> _encZZFI;
+    CatEncoder<CatCmdZZPC> _encZZPC;
+    CatEncoder<CatCmdMD> _encMD;
+
+    char _batch[sizeof(CatTxPacket::data) + 1] = {};
+    uint8_t _lastSlots = 0;
+
+    uint32_t _sent = 0;
+    uint32_t _coalesced = 0;
+    uint32_t _dropped = 0;
+    uint32_t _batches = 0;
+
+    uint32_t _lastFaMs = 0;
+    uint32_t _faHist[FA_HIST_BUCKETS] = {};
+};
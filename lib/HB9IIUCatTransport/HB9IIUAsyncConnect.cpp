@@ -0,0 +1,66 @@
+#include "HB9IIUAsyncConnect.h"
+#include <lwip/sockets.h>
+
+bool AsyncConnect::start(const IPAddress &host, uint16_t port, uint32_t timeoutMs)
+{
+    cancel();
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return false;
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = (uint32_t)host;
+
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 && errno != EINPROGRESS)
+    {
+        close(fd); // refused / unreachable right away
+        return false;
+    }
+    _fd = fd;
+    _startMs = millis();
+    _timeoutMs = timeoutMs;
+    return true;
+}
+
+AsyncConnect::Result AsyncConnect::poll(WiFiClient &client)
+{
+    if (_fd < 0)
+        return FAILED;
+
+    fd_set wset;
+    FD_ZERO(&wset);
+    FD_SET(_fd, &wset);
+    struct timeval tv = {0, 0};
+    if (select(_fd + 1, nullptr, &wset, nullptr, &tv) <= 0)
+    {
+        if (millis() - _startMs < _timeoutMs)
+            return PENDING;
+        cancel(); // nobody home
+        return FAILED;
+    }
+
+    int err = 0;
+    socklen_t len = sizeof(err);
+    getsockopt(_fd, SOL_SOCKET, SO_ERROR, &err, &len);
+    if (err != 0)
+    {
+        cancel(); // refused
+        return FAILED;
+    }
+
+    fcntl(_fd, F_SETFL, fcntl(_fd, F_GETFL, 0) & ~O_NONBLOCK);
+    client = WiFiClient(_fd); // closes the fd when it is done with it
+    _fd = -1;
+    return CONNECTED;
+}
+
+void AsyncConnect::cancel()
+{
+    if (_fd >= 0)
+        close(_fd);
+    _fd = -1;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+
+// Non-blocking TCP connect: start() it, then call poll() on every pass of
+// the caller's loop until it is no longer PENDING. A non-blocking lwIP
+// connect() checked with a zero-timeout select(), so nobody waits for a
+// host that is not there. The connected socket is handed to a WiFiClient.
+class AsyncConnect
+{
+public:
+    enum Result : uint8_t
+    {
+        PENDING,
+        CONNECTED,
+        FAILED
+    };
+
+    // false if it failed right away (no socket, unreachable)
+    bool start(const IPAddress &host, uint16_t port, uint32_t timeoutMs);
+    // CONNECTED: `client` owns the socket now (blocking, like WiFiClient::connect())
+    Result poll(WiFiClient &client);
+    // Drop a connect still in flight
+    void cancel();
+    bool active() const { return _fd >= 0; }
+
+    ~AsyncConnect() { cancel(); }
+
+private:
+    int _fd = -1;
+    uint32_t _startMs = 0;
+    uint32_t _timeoutMs = 0;
+};
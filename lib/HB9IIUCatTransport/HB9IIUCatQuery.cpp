@@ -0,0 +1,211 @@
+#include "HB9IIUCatQuery.h"
+
+const CatFrame *CatBatch::reply(CatOp op) const
+{
+    for (uint8_t i = 0; i < count; i++)
+        if (ops[i] == op)
+            return got[i] ? &replies[i] : nullptr;
+    return nullptr;
+}
+
+bool CatBatch::complete() const
+{
+    for (uint8_t i = 0; i < count; i++)
+        if (!got[i])
+            return false;
+    return true;
+}
+
+namespace CatQuery
+{
+    // ───────── INTERNAL STATE ─────────
+    struct Pending
+    {
+        bool used;
+        CatOp op;
+        uint32_t deadline;
+        ReplyHandler onReply;
+    };
+
+    struct PendingBatch
+    {
+        bool used;
+        uint32_t deadline;
+        BatchHandler onDone;
+        CatBatch batch;
+    };
+
+    static const uint8_t MAX_PENDING = 8;
+    static const uint8_t MAX_BATCHES = 2;
+    static Pending table[MAX_PENDING];
+    static PendingBatch batches[MAX_BATCHES];
+    static CatTransport *link = nullptr;
+
+    // ───────── INTERNAL HELPERS ─────────
+    static void finishBatch(PendingBatch &pb)
+    {
+        pb.used = false; // free first: the handler may start a new batch
+        pb.batch.elapsedMs = millis() - pb.batch.sentAtMs;
+        if (pb.onDone)
+            pb.onDone(pb.batch);
+    }
+
+    // Offer a frame to the open batches; true if one of them took it
+    static bool claimForBatch(const CatFrame &f)
+    {
+        for (uint8_t i = 0; i < MAX_BATCHES; i++)
+        {
+            PendingBatch &pb = batches[i];
+            if (!pb.used)
+                continue;
+            CatBatch &b = pb.batch;
+            for (uint8_t k = 0; k < b.count; k++)
+            {
+                if (b.ops[k] == f.op && !b.got[k])
+                {
+                    b.replies[k] = f;
+                    b.got[k] = true;
+                    if (b.complete())
+                        finishBatch(pb);
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+
+    // ───────── PUBLIC API ─────────
+    void begin(CatTransport &transport)
+    {
+        link = &transport;
+    }
+
+    bool request(const char *cmd, CatOp expect, uint32_t timeoutMs, ReplyHandler onReply)
+    {
+        if (!link)
+            return false;
+
+        Pending *slot = nullptr;
+        for (uint8_t i = 0; i < MAX_PENDING; i++)
+        {
+            if (!table[i].used)
+            {
+                slot = &table[i];
+                break;
+            }
+        }
+        if (!slot)
+            return false;
+
+        if (!link->send(cmd, CAT_LANE_BACKGROUND))
+            return false;
+
+        slot->op = expect;
+        slot->deadline = millis() + timeoutMs;
+        slot->onReply = onReply;
+        slot->used = true;
+        return true;
+    }
+
+    bool batch(const CatOp *ops, uint8_t count, uint32_t timeoutMs, BatchHandler onDone, uint8_t tag)
+    {
+        if (!link || count == 0 || count > CatBatch::MAX_OPS)
+            return false;
+
+        PendingBatch *slot = nullptr;
+        for (uint8_t i = 0; i < MAX_BATCHES; i++)
+        {
+            if (!batches[i].used)
+            {
+                slot = &batches[i];
+                break;
+            }
+        }
+        if (!slot)
+            return false;
+
+        // "FA;ZZFI;ZZAG;" - all queries in one packet
+        char cmd[sizeof(CatTxPacket::data)];
+        size_t n = 0;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            const char *name = catOpName(ops[i]);
+            size_t len = strlen(name);
+            if (n + len + 1 > sizeof(cmd))
+                return false;
+            memcpy(cmd + n, name, len);
+            n += len;
+            cmd[n++] = ';';
+        }
+        if (!link->send(cmd, n, CAT_LANE_BACKGROUND))
+            return false;
+
+        CatBatch &b = slot->batch;
+        b.count = count;
+        for (uint8_t i = 0; i < count; i++)
+        {
+            b.ops[i] = ops[i];
+            b.got[i] = false;
+        }
+        b.sentAtMs = millis();
+        b.elapsedMs = 0;
+        b.tag = tag;
+        slot->deadline = b.sentAtMs + timeoutMs;
+        slot->onDone = onDone;
+        slot->used = true;
+        return true;
+    }
+
+    void service(FrameHandler unsolicited)
+    {
+        CatFrame f;
+        while (link && link->receive(f))
+        {
+            bool claimed = claimForBatch(f);
+            for (uint8_t i = 0; i < MAX_PENDING && !claimed; i++)
+            {
+                Pending &p = table[i];
+                if (p.used && p.op == f.op)
+                {
+                    p.used = false; // free first: the handler may issue a new query
+                    if (p.onReply)
+                        p.onReply(&f);
+                    claimed = true;
+                    break;
+                }
+            }
+            if (!claimed && unsolicited)
+                unsolicited(f);
+        }
+
+        uint32_t now = millis();
+        for (uint8_t i = 0; i < MAX_PENDING; i++)
+        {
+            Pending &p = table[i];
+            if (p.used && (int32_t)(now - p.deadline) >= 0)
+            {
+                p.used = false;
+                if (p.onReply)
+                    p.onReply(nullptr);
+            }
+        }
+        for (uint8_t i = 0; i < MAX_BATCHES; i++)
+        {
+            PendingBatch &pb = batches[i];
+            if (pb.used && (int32_t)(now - pb.deadline) >= 0)
+                finishBatch(pb);
+        }
+    }
+
+    uint8_t pending()
+    {
+        uint8_t n = 0;
+        for (uint8_t i = 0; i < MAX_PENDING; i++)
+            if (table[i].used)
+                n++;
+        for (uint8_t i = 0; i < MAX_BATCHES; i++)
+            if (batches[i].used)
+                n++;
+        return n;
+    }
+}
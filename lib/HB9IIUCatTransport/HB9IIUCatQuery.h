@@ -0,0 +1,59 @@
+#pragma once
+#include <Arduino.h>
+#include "HB9IIUCatTransport.h"
+
+// Asynchronous CAT queries on top of CatTransport.
+// A query is sent, and the first reply frame carrying the expected
+// opcode is handed to its callback from service() (loop context).
+// Nothing here ever waits for the radio.
+//
+// batch() sends several queries in ONE write ("MD;ZZPC;") and collects the
+// replies by opcode as they arrive, under a single deadline, so N queries
+// cost one round trip instead of N.
+
+// Replies collected for one batch
+struct CatBatch
+{
+    static const uint8_t MAX_OPS = 4;
+
+    uint8_t count;
+    CatOp ops[MAX_OPS];
+    bool got[MAX_OPS];
+    CatFrame replies[MAX_OPS];
+    uint32_t sentAtMs;
+    uint32_t elapsedMs; // send -> last reply (or deadline)
+    uint8_t tag;        // caller's value from batch(), handed back untouched
+
+    // Reply for `op`, nullptr if it never came
+    const CatFrame *reply(CatOp op) const;
+    // true if every query was answered
+    bool complete() const;
+};
+
+namespace CatQuery
+{
+    // Called with the matching reply, or nullptr when the deadline passed
+    typedef void (*ReplyHandler)(const CatFrame *reply);
+    // Called once per batch, when all replies are in or the deadline passed
+    typedef void (*BatchHandler)(const CatBatch &batch);
+    // Called for every frame no pending query was waiting for
+    typedef void (*FrameHandler)(const CatFrame &frame);
+
+    // Bind to the transport that carries the queries
+    void begin(CatTransport &transport);
+
+    // Send `cmd` (e.g. "ZZAG;") and route the reply with opcode `expect`
+    // (e.g. CAT_OP_ZZAG) to `onReply`. false if it could not be sent.
+    bool request(const char *cmd, CatOp expect, uint32_t timeoutMs, ReplyHandler onReply);
+
+    // Query every opcode in `ops` (e.g. {CAT_OP_FA, CAT_OP_ZZFI}) with one
+    // write; `onDone` fires once, with whatever arrived before `timeoutMs`.
+    // `tag` comes back in CatBatch::tag (tells callers' batches apart).
+    bool batch(const CatOp *ops, uint8_t count, uint32_t timeoutMs, BatchHandler onDone, uint8_t tag = 0);
+
+    // Call every loop(): drains replies and expires overdue queries
+    void service(FrameHandler unsolicited);
+
+    // Number of queries / batches still waiting for replies
+    uint8_t pending();
+}
@@ -0,0 +1,416 @@
+#include "HB9IIUCatTransport.h"
+
+// How often the task looks at the socket when nobody wakes it up
+static const TickType_t CAT_POLL_TICKS = pdMS_TO_TICKS(2);
+
+// Warm standby link
+static const uint32_t STANDBY_KEEPALIVE_MS = 5000;   // "ID;" on the idle socket
+static const uint32_t STANDBY_SILENT_MS = 3 * STANDBY_KEEPALIVE_MS; // no answer: drop it
+static const uint32_t STANDBY_RETRY_MS = 10000;      // between standby connect attempts
+static const uint32_t STANDBY_CONNECT_TIMEOUT_MS = 300;
+
+// PTT commands, encoded once
+static const uint8_t KEY[] = {'Z', 'Z', 'T', 'X', '1', ';'};
+static const uint8_t UNKEY[] = {'Z', 'Z', 'T', 'X', '0', ';'};
+
+bool CatTransport::begin(const char *taskName, BaseType_t core, UBaseType_t priority)
+{
+    if (_task)
+        return true;
+    return xTaskCreatePinnedToCore(taskEntry, taskName, 4096, this, priority, &_task, core) == pdPASS;
+}
+
+void CatTransport::requestConnect(const IPAddress &host, uint16_t port, uint32_t timeoutMs)
+{
+    _reqHost = host;
+    _reqPort = port;
+    _reqTimeoutMs = timeoutMs;
+    setState(CONNECTING);
+    _request.store(REQ_CONNECT, std::memory_order_release);
+    if (_task)
+        xTaskNotifyGive(_task);
+}
+
+bool CatTransport::connect(const IPAddress &host, uint16_t port, uint32_t timeoutMs)
+{
+    requestConnect(host, port, timeoutMs);
+    while (state() == CONNECTING)
+        delay(2);
+    return connected();
+}
+
+void CatTransport::stop()
+{
+    _request.store(REQ_STOP, std::memory_order_release);
+    if (_task)
+        xTaskNotifyGive(_task);
+}
+
+void CatTransport::setStandby(const IPAddress &host, uint16_t port)
+{
+    _sbReqHost = host;
+    _sbReqPort = port;
+    _standbyChanged.store(true, std::memory_order_release);
+    if (_task)
+        xTaskNotifyGive(_task);
+}
+
+bool CatTransport::setPtt(bool on)
+{
+    if (!connected())
+        return false;
+    _pttQueuedUs = micros();
+    _ptt.store(on ? PTT_ON : PTT_OFF, std::memory_order_release);
+    if (_task)
+        xTaskNotifyGive(_task);
+    return true;
+}
+
+bool CatTransport::emergencyUnkey()
+{
+    if (!setPtt(false))
+        return false;
+    _emergencyUnkeys++;
+    return true;
+}
+
+bool CatTransport::send(const char *cmd, size_t len, CatLane lane)
+{
+    if (!connected() || len == 0 || len > sizeof(CatTxPacket::data) || lane >= CAT_LANE_COUNT)
+    {
+        _txDropped++;
+        return false;
+    }
+
+    CatTxPacket p;
+    memcpy(p.data, cmd, len);
+    p.len = (uint8_t)len;
+    p.queuedUs = micros();
+    if (!_txq[lane].push(p))
+    {
+        _txDropped++;
+        _lanes[lane].dropped++;
+        return false;
+    }
+    xTaskNotifyGive(_task);
+    return true;
+}
+
+// ---------------- transport task ----------------
+
+void CatTransport::taskEntry(void *arg)
+{
+    static_cast<CatTransport *>(arg)->run();
+}
+
+void CatTransport::run()
+{
+    for (;;)
+    {
+        // sleep until send()/connect() wakes us, or the poll period elapses
+        ulTaskNotifyTake(pdTRUE, CAT_POLL_TICKS);
+
+        handleRequest();
+        serviceStandby();
+
+        if (state() != CONNECTED)
+            continue;
+
+        flushOutgoing();
+        readIncoming();
+
+        if (!_client.connected())
+        {
+            _client.stop();
+            if (failover())
+                continue;
+            _retryLen = 0;
+            uint8_t expected = CONNECTED;
+            if (_state.compare_exchange_strong(expected, IDLE))
+                wakeLoop();
+        }
+    }
+}
+
+void CatTransport::handleRequest()
+{
+    uint8_t req = _request.exchange(REQ_NONE, std::memory_order_acquire);
+    if (req == REQ_NONE)
+        return;
+
+    if (_client.connected())
+        _client.stop();
+    _parser.reset();
+
+    // anything queued for the old socket is stale now; a pending un-key
+    // still goes out on the new one, a pending key does not
+    CatTxPacket stale;
+    for (uint8_t l = 0; l < CAT_LANE_COUNT; l++)
+        while (_txq[l].pop(stale))
+        {
+        }
+    uint8_t key = PTT_ON;
+    _ptt.compare_exchange_strong(key, PTT_NONE, std::memory_order_acq_rel);
+
+    if (req == REQ_STOP)
+    {
+        _sbConnect.cancel();
+        _standby.stop();
+        _standbyUp.store(false, std::memory_order_release);
+        setState(IDLE);
+        return;
+    }
+
+    _retryLen = 0;
+    if (_client.connect(_reqHost, _reqPort, _reqTimeoutMs))
+    {
+        _client.setNoDelay(true);
+        _host = _reqHost;
+        _port = _reqPort;
+        setState(CONNECTED);
+    }
+    else
+    {
+        setState(FAILED);
+    }
+}
+
+void CatTransport::flushOutgoing()
+{
+    servicePtt(false); // un-key in a write of its own, ahead of everything
+    writeLanes(CAT_LANE_INTERACTIVE, CAT_LANE_BACKGROUND);
+    servicePtt(true); // key behind what was queued before it
+}
+
+void CatTransport::writeLanes(uint8_t first, uint8_t last)
+{
+    static const uint8_t MAX_PACKETS = 16;
+
+    // coalesce the lanes into one socket write, higher class first
+    uint8_t buf[256];
+    size_t n = 0;
+    uint8_t count = 0;
+    uint8_t laneOf[MAX_PACKETS];
+    uint32_t queuedUs[MAX_PACKETS];
+    CatTxPacket p;
+    for (uint8_t l = first; l <= last; l++)
+    {
+        while (count < MAX_PACKETS && n + sizeof(CatTxPacket::data) <= sizeof(buf) && _txq[l].pop(p))
+        {
+            memcpy(buf + n, p.data, p.len);
+            n += p.len;
+            laneOf[count] = l;
+            queuedUs[count++] = p.queuedUs;
+            _packetsSent++;
+        }
+    }
+    if (n == 0)
+        return;
+
+    uint32_t t0 = micros();
+    size_t written = _client.write(buf, n);
+    uint32_t now = micros();
+    uint32_t writeUs = now - t0;
+    _writeAvgUs = _socketWrites ? _writeAvgUs - _writeAvgUs / 8 + writeUs / 8 : writeUs;
+    if (writeUs > _writeMaxUs)
+        _writeMaxUs = writeUs;
+    _socketWrites++;
+    if (written != n)
+    {
+        // keep it for the standby; picked up as a disconnect by run()
+        memcpy(_retry, buf, n);
+        _retryLen = n;
+        _client.stop();
+        return;
+    }
+
+    for (uint8_t i = 0; i < count; i++)
+    {
+        CatLaneStats &st = _lanes[laneOf[i]];
+        uint32_t us = now - queuedUs[i];
+        st.lastUs = us;
+        st.avgUs = st.packets ? st.avgUs - st.avgUs / 8 + us / 8 : us;
+        if (us > st.maxUs)
+            st.maxUs = us;
+        st.packets++;
+    }
+}
+
+void CatTransport::servicePtt(bool allowKey)
+{
+    // no socket: the slot waits for the standby or the next connection
+    if (!_client.connected())
+        return;
+    uint8_t req = _ptt.load(std::memory_order_acquire);
+    if (req == PTT_NONE || (req == PTT_ON && !allowKey))
+        return;
+    if (!_ptt.compare_exchange_strong(req, PTT_NONE, std::memory_order_acq_rel))
+        return; // changed under us: the newer request goes on the next pass
+
+    if (req == PTT_ON)
+    {
+        // mode/power queued before the key must be on the wire first
+        while (!_txq[CAT_LANE_INTERACTIVE].empty() && _client.connected())
+            writeLanes(CAT_LANE_INTERACTIVE, CAT_LANE_INTERACTIVE);
+        if (!_client.connected())
+        {
+            uint8_t none = PTT_NONE; // keep it unless something newer arrived
+            _ptt.compare_exchange_strong(none, PTT_ON, std::memory_order_acq_rel);
+            return;
+        }
+    }
+
+    const uint8_t *cmd = req == PTT_ON ? KEY : UNKEY;
+    if (_client.write(cmd, sizeof(UNKEY)) != sizeof(UNKEY))
+    {
+        // replayed on the standby after a failover, like a lane write
+        memcpy(_retry, cmd, sizeof(UNKEY));
+        _retryLen = sizeof(UNKEY);
+        _client.stop(); // picked up as a disconnect by run()
+        return;
+    }
+
+    uint32_t us = micros() - _pttQueuedUs;
+    _pttStats.lastUs = us;
+    _pttStats.avgUs = _pttStats.packets ? _pttStats.avgUs - _pttStats.avgUs / 8 + us / 8 : us;
+    if (us > _pttStats.maxUs)
+        _pttStats.maxUs = us;
+    _pttStats.packets++;
+}
+
+void CatTransport::readIncoming()
+{
+    CatFrame f;
+    uint32_t received = _framesReceived;
+    while (_client.available())
+    {
+        // an un-key requested while we read goes out before the next chunk
+        servicePtt(false);
+
+        // socket bytes go straight into the parser ring
+        uint8_t *dst;
+        size_t room = _parser.writable(dst);
+        int n = room ? _client.read(dst, room) : 0;
+        if (n <= 0)
+            break;
+        _parser.commit((size_t)n);
+
+        // hand over every complete frame; partial ones wait for more bytes
+        while (_parser.next(f))
+        {
+            if (_rxq.push(f))
+                _framesReceived++;
+            else
+                _rxDropped++;
+        }
+    }
+    if (_framesReceived != received)
+        wakeLoop();
+}
+
+void CatTransport::serviceStandby()
+{
+    if (_standbyChanged.exchange(false, std::memory_order_acquire))
+    {
+        _sbHost = _sbReqHost;
+        _sbPort = _sbReqPort;
+        _sbConnect.cancel();
+        _standby.stop();
+        _standbyUp.store(false, std::memory_order_release);
+        _sbTryMs = millis() - STANDBY_RETRY_MS; // try right away
+    }
+    if (_sbPort == 0)
+        return;
+
+    uint32_t now = millis();
+    if (!_standby.connected())
+    {
+        if (_standbyUp.exchange(false, std::memory_order_acq_rel))
+        {
+            _standby.stop();
+            _standbyLost++;
+        }
+        // only worth holding while there is a primary to back up
+        bool samePrimary = _sbHost == _host && _sbPort == _port;
+        if (state() != CONNECTED || samePrimary)
+        {
+            _sbConnect.cancel();
+            return;
+        }
+        if (!_sbConnect.active())
+        {
+            if (now - _sbTryMs < STANDBY_RETRY_MS)
+                return;
+            _sbTryMs = now;
+            if (!_sbConnect.start(_sbHost, _sbPort, STANDBY_CONNECT_TIMEOUT_MS))
+                return;
+        }
+        if (_sbConnect.poll(_standby) != AsyncConnect::CONNECTED)
+            return;
+        _standby.setNoDelay(true);
+        _sbPingMs = _sbRxMs = now;
+        _standbyUp.store(true, std::memory_order_release);
+        return;
+    }
+
+    // nobody reads the standby: answers only prove it is alive
+    uint8_t sink[64];
+    while (_standby.available())
+    {
+        if (_standby.read(sink, sizeof(sink)) <= 0)
+            break;
+        _sbRxMs = now;
+    }
+
+    if (now - _sbPingMs >= STANDBY_KEEPALIVE_MS)
+    {
+        _sbPingMs = now;
+        _keepalives++;
+        if (_standby.write((const uint8_t *)"ID;", 3) != 3)
+            _standby.stop();
+    }
+    if (now - _sbRxMs >= STANDBY_SILENT_MS)
+        _standby.stop(); // half-open: counted as lost on the next pass
+}
+
+bool CatTransport::failover()
+{
+    if (!_standbyUp.load(std::memory_order_acquire) || !_standby.connected())
+        return false;
+
+    uint32_t t0 = micros();
+
+    // the socket now lives in _client; _standby just drops its reference
+    _client = _standby;
+    _standby = WiFiClient();
+    _standbyUp.store(false, std::memory_order_release);
+    _parser.reset(); // a half frame from the old socket is useless
+
+    // the old primary becomes the standby target
+    IPAddress host = _host;
+    uint16_t port = _port;
+    _host = _sbHost;
+    _port = _sbPort;
+    _sbHost = host;
+    _sbPort = port;
+    _sbTryMs = millis();
+
+    // a key that never fully went out is void once an un-key is waiting
+    if (_retryLen == sizeof(KEY) && memcmp(_retry, KEY, sizeof(KEY)) == 0 &&
+        _ptt.load(std::memory_order_acquire) == PTT_OFF)
+        _retryLen = 0;
+    if (_retryLen)
+    {
+        if (_client.write(_retry, _retryLen) != _retryLen)
+            _client.stop();
+        _retryLen = 0;
+    }
+    flushOutgoing();
+
+    uint32_t us = micros() - t0;
+    _lastFailoverUs = us;
+    if (us > _maxFailoverUs)
+        _maxFailoverUs = us;
+    _failovers++;
+    return true;
+}
@@ -0,0 +1,201 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include <atomic>
+#include "HB9IIUSpscQueue.h"
+#include "HB9IIUCatParser.h"
+#include "HB9IIUAsyncConnect.h"
+
+// One outgoing write: a single command or a batch of them ("FA...;ZZAG...;")
+struct CatTxPacket
+{
+    uint8_t len;
+    char data[63];
+    uint32_t queuedUs; // micros() at send(), for the lane latency stats
+};
+
+// Outbound priority classes. Each has its own ring; the task always
+// empties a higher class before it looks at a lower one. PTT is not a
+// lane: see CatTransport::setPtt().
+enum CatLane : uint8_t
+{
+    CAT_LANE_INTERACTIVE = 0, // knob writes (FA, ZZAG, ZZFI, MD, ZZPC)
+    CAT_LANE_BACKGROUND,      // polls and queries
+    CAT_LANE_COUNT
+};
+
+// Queueing latency of one lane: send() -> handed to the socket
+struct CatLaneStats
+{
+    uint32_t packets;
+    uint32_t dropped;
+    uint32_t lastUs;
+    uint32_t avgUs; // EWMA 1/8
+    uint32_t maxUs;
+};
+
+// Owns the CAT TCP socket inside its own FreeRTOS task.
+// The main loop never touches the socket: it pushes commands into a
+// lock-free TX ring and pulls complete reply frames from an RX ring,
+// so a slow or silent radio can no longer stall the loop.
+class CatTransport
+{
+public:
+    enum State : uint8_t
+    {
+        IDLE,       // no socket
+        CONNECTING, // connect requested, task is working on it
+        CONNECTED,  // socket up
+        FAILED      // last connect attempt failed
+    };
+
+    // Start the transport task (call once from setup())
+    bool begin(const char *taskName = "CAT", BaseType_t core = 0, UBaseType_t priority = 2);
+
+    // Ask the task to (re)connect; returns immediately (watch state())
+    void requestConnect(const IPAddress &host, uint16_t port, uint32_t timeoutMs);
+    // Same, but waits for the outcome (only the connect itself blocks)
+    bool connect(const IPAddress &host, uint16_t port, uint32_t timeoutMs);
+    // Ask the task to close the socket
+    void stop();
+
+    // Optional warm standby: a second, idle connection to another port or
+    // host, kept alive with a cheap query. If the primary socket dies the
+    // task swaps the standby in on the same tick, so queued commands keep
+    // flowing without a reconnect. The roles swap, so the dead endpoint
+    // becomes the standby target. port 0 disables it.
+    void setStandby(const IPAddress &host, uint16_t port);
+    bool standbyUp() const { return _standbyUp.load(std::memory_order_acquire); }
+
+    State state() const { return (State)_state.load(std::memory_order_acquire); }
+    bool connected() const { return state() == CONNECTED; }
+
+    // Loop side: queue one command or batch (copied, up to 63 bytes) on a lane.
+    // false if not connected or the lane's ring is full. A packet always goes out in one write.
+    bool send(const char *cmd, size_t len, CatLane lane = CAT_LANE_INTERACTIVE);
+    bool send(const char *cmd, CatLane lane = CAT_LANE_INTERACTIVE) { return send(cmd, strlen(cmd), lane); }
+
+    // PTT is one last-writer-wins slot, not a queue entry: a quick
+    // press/release can never reach the radio as ZZTX0 then ZZTX1. The task
+    // writes an un-key ahead of every lane; a key only after the
+    // interactive lane queued before it (TUNE's mode/power) is on the wire.
+    // Any task (not an ISR); false if not connected.
+    bool setPtt(bool on);
+    // setPtt(false) for the TX watchdog, counted separately
+    bool emergencyUnkey();
+
+    // Loop side: next parsed reply frame, false if none waiting
+    bool receive(CatFrame &out) { return _rxq.pop(out); }
+
+    // Notify task (eSetBits) when reply frames are queued or the link drops,
+    // so a sleeping loop picks them up right away (nullptr: off)
+    void setWake(TaskHandle_t task, uint32_t bits)
+    {
+        _wakeBits = bits;
+        _wakeTask = task;
+    }
+
+    // Counters (written by one side only, safe to read anywhere)
+    uint32_t packetsSent() const { return _packetsSent; }
+    uint32_t socketWrites() const { return _socketWrites; }
+    uint32_t framesReceived() const { return _framesReceived; }
+    uint32_t txDropped() const { return _txDropped; }
+    uint32_t rxDropped() const { return _rxDropped; }
+    const CatLaneStats &laneStats(CatLane lane) const { return _lanes[lane]; }
+    const CatLaneStats &pttStats() const { return _pttStats; } // setPtt() -> socket
+    // Time spent inside the socket write: grows when lwIP's send buffer is full
+    uint32_t writeAvgUs() const { return _writeAvgUs; } // EWMA 1/8
+    uint32_t writeMaxUs() const { return _writeMaxUs; }
+    uint32_t emergencyUnkeys() const { return _emergencyUnkeys; }
+    uint32_t failovers() const { return _failovers; }
+    uint32_t lastFailoverUs() const { return _lastFailoverUs; } // dead primary -> standby writing
+    uint32_t maxFailoverUs() const { return _maxFailoverUs; }
+    uint32_t keepalives() const { return _keepalives; }
+    uint32_t standbyLost() const { return _standbyLost; }
+
+private:
+    enum Request : uint8_t
+    {
+        REQ_NONE,
+        REQ_CONNECT,
+        REQ_STOP
+    };
+
+    enum PttRequest : uint8_t
+    {
+        PTT_NONE,
+        PTT_ON,
+        PTT_OFF
+    };
+
+    static void taskEntry(void *arg);
+    void run();
+    void handleRequest();
+    void flushOutgoing();
+    void writeLanes(uint8_t first, uint8_t last);
+    void readIncoming();
+    void serviceStandby();
+    void servicePtt(bool allowKey);
+    bool failover();
+    void setState(State s) { _state.store(s, std::memory_order_release); }
+    void wakeLoop()
+    {
+        TaskHandle_t t = _wakeTask;
+        if (t)
+            xTaskNotify(t, _wakeBits, eSetBits);
+    }
+
+    TaskHandle_t _task = nullptr;
+    volatile TaskHandle_t _wakeTask = nullptr;
+    volatile uint32_t _wakeBits = 0;
+    WiFiClient _client; // only ever used from the transport task
+
+    std::atomic<uint8_t> _state{IDLE};
+    std::atomic<uint8_t> _request{REQ_NONE};
+    std::atomic<uint8_t> _ptt{PTT_NONE}; // PttRequest, newest wins
+    volatile uint32_t _pttQueuedUs = 0;
+    IPAddress _reqHost;
+    uint16_t _reqPort = 0;
+    uint32_t _reqTimeoutMs = 0;
+
+    // endpoint of _client, so the standby never points at the primary
+    IPAddress _host;
+    uint16_t _port = 0;
+
+    WiFiClient _standby; // task side, like _client
+    std::atomic<bool> _standbyUp{false};
+    std::atomic<bool> _standbyChanged{false};
+    IPAddress _sbReqHost; // loop -> task via _standbyChanged
+    uint16_t _sbReqPort = 0;
+    IPAddress _sbHost; // task side
+    uint16_t _sbPort = 0;
+    AsyncConnect _sbConnect; // never blocks primary writes or an un-key
+    uint32_t _sbTryMs = 0;
+    uint32_t _sbPingMs = 0;
+    uint32_t _sbRxMs = 0;
+
+    // last write that failed on a dead primary, replayed after a failover
+    uint8_t _retry[256];
+    size_t _retryLen = 0;
+
+    SpscQueue<CatTxPacket, 16> _txq[CAT_LANE_COUNT]; // loop -> task, one ring per lane
+    CatLaneStats _lanes[CAT_LANE_COUNT] = {};        // written by the task (dropped: loop)
+    CatLaneStats _pttStats = {};                     // written by the task
+    SpscQueue<CatFrame, 32> _rxq; // task -> loop
+
+    CatParser _parser; // incoming frames (task side)
+
+    volatile uint32_t _packetsSent = 0;
+    volatile uint32_t _socketWrites = 0;
+    volatile uint32_t _framesReceived = 0;
+    volatile uint32_t _txDropped = 0;
+    volatile uint32_t _rxDropped = 0;
+    volatile uint32_t _writeAvgUs = 0;
+    volatile uint32_t _writeMaxUs = 0;
+    volatile uint32_t _emergencyUnkeys = 0;
+    volatile uint32_t _failovers = 0;
+    volatile uint32_t _lastFailoverUs = 0;
+    volatile uint32_t _maxFailoverUs = 0;
+    volatile uint32_t _keepalives = 0;
+    volatile uint32_t _standbyLost = 0;
+};
@@ -0,0 +1,267 @@
+#include "HB9IIUFlexDiscovery.h"
+
+// VITA-49 framing of FlexRadio discovery packets
+static const uint8_t VITA_EXT_DATA_STREAM = 0x3;  // packet type: extension data with stream id
+static const uint32_t DISCOVERY_STREAM_ID = 0x00000800;
+static const uint32_t FLEX_OUI = 0x001C2D;
+static const uint16_t DISCOVERY_CLASS = 0xFFFF;   // packet class code
+static const uint32_t RADIO_TIMEOUT_MS = 5000;    // ~5 broadcasts missed: radio gone, entry dropped
+
+static uint32_t be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+// bounded copy of a value that is not NUL terminated
+static void copyValue(char *dst, size_t size, const char *src, size_t len)
+{
+    if (len >= size)
+        len = size - 1;
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+static bool parseIp(IPAddress &ip, const char *src, size_t len)
+{
+    char text[16];
+    if (len == 0 || len >= sizeof(text))
+        return false;
+    memcpy(text, src, len);
+    text[len] = '\0';
+    return ip.fromString(text);
+}
+
+static int32_t parseInt(const char *src, size_t len)
+{
+    int32_t v = 0;
+    if (len == 0)
+        return -1;
+    for (size_t i = 0; i < len; i++)
+    {
+        if (src[i] < '0' || src[i] > '9')
+            return -1;
+        v = v * 10 + (src[i] - '0');
+    }
+    return v;
+}
+
+// "a.b.c.d,e.f.g.h" -> clients[], skipping duplicates
+static void parseClientIps(FlexRadioInfo &out, const char *src, size_t len)
+{
+    size_t start = 0;
+    for (size_t i = 0; i <= len; i++)
+    {
+        if (i < len && src[i] != ',')
+            continue;
+        IPAddress ip;
+        if (out.clientCount < FlexRadioInfo::MAX_CLIENTS && parseIp(ip, src + start, i - start))
+        {
+            bool dup = false;
+            for (uint8_t k = 0; k < out.clientCount; k++)
+                dup = dup || out.clients[k] == ip;
+            if (!dup)
+                out.clients[out.clientCount++] = ip;
+        }
+        start = i + 1;
+    }
+}
+
+static bool keyIs(const char *key, size_t keyLen, const char *name)
+{
+    return strlen(name) == keyLen && strncmp(key, name, keyLen) == 0;
+}
+
+bool FlexDiscovery::decode(const uint8_t *pkt, size_t len, FlexRadioInfo &out)
+{
+    if (len < 16)
+        return false;
+
+    // word 0: type(4) C T rr TSI(2) TSF(2) count(4) size(16, in 32-bit words)
+    uint8_t type = pkt[0] >> 4;
+    bool hasClass = pkt[0] & 0x08;
+    bool hasTrailer = pkt[0] & 0x04;
+    uint8_t tsi = (pkt[1] >> 6) & 0x3;
+    uint8_t tsf = (pkt[1] >> 4) & 0x3;
+    size_t size = (size_t)(be32(pkt) & 0xFFFF) * 4;
+
+    if (type != VITA_EXT_DATA_STREAM || !hasClass || size > len)
+        return false;
+    if (be32(pkt + 4) != DISCOVERY_STREAM_ID)
+        return false;
+    if ((be32(pkt + 8) & 0x00FFFFFF) != FLEX_OUI || (be32(pkt + 12) & 0xFFFF) != DISCOVERY_CLASS)
+        return false;
+
+    size_t start = 16 + (tsi ? 4 : 0) + (tsf ? 8 : 0);
+    size_t end = size - (hasTrailer ? 4 : 0);
+    if (start >= end)
+        return false;
+
+    out = FlexRadioInfo();
+    out.port = DEFAULT_PORT;
+    out.availableSlices = -1;
+    out.availableClients = -1;
+    bool haveIp = false;
+
+    // payload: "key=value key=value ...", NUL padded to a word boundary
+    const char *p = (const char *)pkt + start;
+    const char *stop = (const char *)pkt + end;
+    while (p < stop && *p)
+    {
+        while (p < stop && *p == ' ')
+            p++;
+        const char *key = p;
+        while (p < stop && *p && *p != ' ' && *p != '=')
+            p++;
+        size_t keyLen = p - key;
+        if (p >= stop || *p != '=')
+        {
+            while (p < stop && *p && *p != ' ')
+                p++;
+            continue;
+        }
+        const char *val = ++p;
+        while (p < stop && *p && *p != ' ')
+            p++;
+        size_t valLen = p - val;
+
+        if (keyIs(key, keyLen, "ip"))
+            haveIp = parseIp(out.ip, val, valLen);
+        else if (keyIs(key, keyLen, "port"))
+        {
+            int32_t port = parseInt(val, valLen);
+            if (port > 0 && port < 65536)
+                out.port = (uint16_t)port;
+        }
+        else if (keyIs(key, keyLen, "model"))
+            copyValue(out.model, sizeof(out.model), val, valLen);
+        else if (keyIs(key, keyLen, "serial"))
+            copyValue(out.serial, sizeof(out.serial), val, valLen);
+        else if (keyIs(key, keyLen, "nickname"))
+            copyValue(out.nickname, sizeof(out.nickname), val, valLen);
+        else if (keyIs(key, keyLen, "status"))
+            copyValue(out.status, sizeof(out.status), val, valLen);
+        else if (keyIs(key, keyLen, "available_slices"))
+            out.availableSlices = (int8_t)parseInt(val, valLen);
+        else if (keyIs(key, keyLen, "available_clients"))
+            out.availableClients = (int8_t)parseInt(val, valLen);
+        else if (keyIs(key, keyLen, "gui_client_ips") || keyIs(key, keyLen, "inuse_ip"))
+            parseClientIps(out, val, valLen);
+    }
+    return haveIp;
+}
+
+bool FlexDiscovery::begin(uint16_t port)
+{
+    _listening = _udp.begin(port);
+    return _listening;
+}
+
+void FlexDiscovery::stop()
+{
+    if (_listening)
+        _udp.stop();
+    _listening = false;
+}
+
+void FlexDiscovery::remember(const FlexRadioInfo &info)
+{
+    uint32_t now = millis();
+    uint8_t slot = MAX_RADIOS;
+
+    // same radio again (by serial, else by address)?
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        bool same = info.serial[0] ? strcmp(_radios[i].serial, info.serial) == 0
+                                   : _radios[i].ip == info.ip;
+        if (same)
+        {
+            slot = i;
+            break;
+        }
+    }
+    if (slot == MAX_RADIOS && _count < MAX_RADIOS)
+        slot = _count++;
+    if (slot == MAX_RADIOS)
+        return; // table full of radios still broadcasting (expire() frees silent ones)
+
+    _radios[slot] = info;
+    _radios[slot].lastSeenMs = now;
+}
+
+// Drop radios that stopped broadcasting, so reconnects never chase an
+// address (or a SmartSDR client list) that is long gone
+void FlexDiscovery::expire()
+{
+    uint32_t now = millis();
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        if (now - _radios[i].lastSeenMs >= RADIO_TIMEOUT_MS)
+        {
+            _expired++;
+            continue;
+        }
+        if (kept != i)
+            _radios[kept] = _radios[i];
+        kept++;
+    }
+    _count = kept;
+}
+
+void FlexDiscovery::service()
+{
+    if (!_listening)
+        return;
+    expire();
+
+    int len;
+    while ((len = _udp.parsePacket()) > 0)
+    {
+        int n = _udp.read(_buf, sizeof(_buf));
+        if (n <= 0)
+            break;
+        _packets++;
+
+        FlexRadioInfo info;
+        if (decode(_buf, (size_t)n, info))
+            remember(info);
+        else
+            _rejected++;
+    }
+}
+
+bool FlexDiscovery::waitForRadio(uint32_t timeoutMs)
+{
+    uint32_t t0 = millis();
+    service();
+    while (_count == 0 && millis() - t0 < timeoutMs)
+    {
+        delay(20);
+        service();
+    }
+    return _count > 0;
+}
+
+void FlexDiscovery::appendStats(String &out) const
+{
+    out += "discovery: packets=" + String(_packets);
+    out += " rejected=" + String(_rejected);
+    out += " expired=" + String(_expired);
+    out += " radios=" + String(_count) + "\n";
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        const FlexRadioInfo &r = _radios[i];
+        out += "  ";
+        out += r.model;
+        out += " ";
+        out += r.nickname;
+        out += " " + r.ip.toString() + ":" + String(r.port);
+        out += " ";
+        out += r.status;
+        out += " slices=" + String(r.availableSlices);
+        for (uint8_t k = 0; k < r.clientCount; k++)
+            out += " client=" + r.clients[k].toString();
+        out += " seen=" + String(now - r.lastSeenMs) + "ms ago\n";
+    }
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFiUdp.h>
+
+// What one discovery broadcast tells us about a radio
+struct FlexRadioInfo
+{
+    static const uint8_t MAX_CLIENTS = 2;
+
+    IPAddress ip;          // the radio (TCP API host)
+    uint16_t port;         // TCP API port, normally 4992
+    char model[16];        // "FLEX-6600"
+    char serial[24];
+    char nickname[24];
+    char status[12];       // "Available", "In_Use", ...
+    int8_t availableSlices;  // -1 = not announced
+    int8_t availableClients; // -1 = not announced
+    IPAddress clients[MAX_CLIENTS]; // GUI clients (SmartSDR PCs, where CAT runs)
+    uint8_t clientCount;
+    uint32_t lastSeenMs;
+};
+
+// Listens for the VITA-49 discovery packets FlexRadios broadcast on
+// UDP 4992 about once a second and keeps a small table of the radios
+// heard. Works on any subnet size and needs no probing at all; a cold
+// start knows the radio (and its SmartSDR clients) after one broadcast.
+// A radio silent for a few broadcast periods is dropped from the table.
+class FlexDiscovery
+{
+public:
+    static const uint16_t DEFAULT_PORT = 4992;
+    static const uint8_t MAX_RADIOS = 4;
+
+    bool begin(uint16_t port = DEFAULT_PORT);
+    void stop();
+
+    // Drain pending packets and drop stale radios (never blocks); call from loop()
+    void service();
+    // Service until at least one radio is known or timeoutMs passed
+    bool waitForRadio(uint32_t timeoutMs);
+
+    uint8_t count() const { return _count; }
+    const FlexRadioInfo &radio(uint8_t i) const { return _radios[i]; }
+
+    // Decode one raw packet; false if it isn't a FlexRadio discovery packet
+    static bool decode(const uint8_t *pkt, size_t len, FlexRadioInfo &out);
+
+    void appendStats(String &out) const;
+
+private:
+    static const size_t PACKET_SIZE = 1024;
+
+    void remember(const FlexRadioInfo &info);
+    void expire();
+
+    WiFiUDP _udp;
+    bool _listening = false;
+    uint8_t _buf[PACKET_SIZE];
+
+    FlexRadioInfo _radios[MAX_RADIOS];
+    uint8_t _count = 0;
+
+    uint32_t _packets = 0;
+    uint32_t _rejected = 0;
+    uint32_t _expired = 0;
+};
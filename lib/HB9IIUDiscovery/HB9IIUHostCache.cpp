@@ -0,0 +1,154 @@
+#include "HB9IIUHostCache.h"
+
+// a ranks before b
+static bool better(const HostEntry &a, const HostEntry &b)
+{
+    if (a.failures != b.failures)
+        return a.failures < b.failures;
+    if (a.lastOkSeq != b.lastOkSeq)
+        return a.lastOkSeq > b.lastOkSeq;
+    return a.rttMs < b.rttMs;
+}
+
+void HostCache::load(Preferences &prefs, const char *key)
+{
+    _key = key;
+    _count = 0;
+    _successSeq = 0;
+
+    Blob blob;
+    if (prefs.getBytesLength(key) == sizeof(blob) &&
+        prefs.getBytes(key, &blob, sizeof(blob)) == sizeof(blob) &&
+        blob.version == BLOB_VERSION && blob.count <= MAX_HOSTS)
+    {
+        _count = blob.count;
+        _successSeq = blob.successSeq;
+        memcpy(_hosts, blob.hosts, sizeof(HostEntry) * _count);
+    }
+    rank();
+    _savedSignature = signature();
+}
+
+bool HostCache::save(Preferences &prefs)
+{
+    uint32_t sig = signature();
+    if (sig == _savedSignature)
+        return false;
+
+    Blob blob;
+    memset(&blob, 0, sizeof(blob));
+    blob.version = BLOB_VERSION;
+    blob.count = _count;
+    blob.successSeq = _successSeq;
+    memcpy(blob.hosts, _hosts, sizeof(HostEntry) * _count);
+    if (prefs.putBytes(_key, &blob, sizeof(blob)) != sizeof(blob))
+        return false;
+    _savedSignature = sig;
+    return true;
+}
+
+uint8_t HostCache::candidates(uint8_t backend, uint16_t port, IPAddress *out, uint8_t max) const
+{
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < _count && n < max; i++)
+    {
+        if (_hosts[i].backend == backend && _hosts[i].port == port)
+            out[n++] = IPAddress(_hosts[i].ip);
+    }
+    return n;
+}
+
+int8_t HostCache::find(uint32_t ip, uint16_t port, uint8_t backend) const
+{
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        const HostEntry &h = _hosts[i];
+        if (h.ip == ip && h.port == port && h.backend == backend)
+            return i;
+    }
+    return -1;
+}
+
+int8_t HostCache::slotFor(uint32_t ip, uint16_t port, uint8_t backend)
+{
+    int8_t i = find(ip, port, backend);
+    if (i >= 0)
+        return i;
+
+    // new host: append, or replace the worst-ranked one
+    i = _count < MAX_HOSTS ? _count++ : MAX_HOSTS - 1;
+    HostEntry &h = _hosts[i];
+    memset(&h, 0, sizeof(h));
+    h.ip = ip;
+    h.port = port;
+    h.backend = backend;
+    return i;
+}
+
+void HostCache::noteSuccess(const IPAddress &ip, uint16_t port, uint8_t backend, uint32_t rttMs)
+{
+    HostEntry &h = _hosts[slotFor((uint32_t)ip, port, backend)];
+    if (rttMs > 0xFFFF)
+        rttMs = 0xFFFF;
+    // EWMA 1/4 once we have a value
+    h.rttMs = h.lastOkSeq ? (uint16_t)((h.rttMs * 3 + rttMs) / 4) : (uint16_t)rttMs;
+    h.failures = 0;
+    h.lastOkSeq = ++_successSeq;
+    rank();
+}
+
+void HostCache::noteFailure(const IPAddress &ip, uint16_t port, uint8_t backend)
+{
+    int8_t i = find((uint32_t)ip, port, backend);
+    if (i < 0)
+        return; // only hosts that worked once are worth remembering
+    if (_hosts[i].failures < MAX_FAILURES)
+        _hosts[i].failures++;
+    rank();
+}
+
+void HostCache::rank()
+{
+    // insertion sort: tiny table, stable
+    for (uint8_t i = 1; i < _count; i++)
+    {
+        HostEntry h = _hosts[i];
+        int8_t j = i - 1;
+        while (j >= 0 && better(h, _hosts[j]))
+        {
+            _hosts[j + 1] = _hosts[j];
+            j--;
+        }
+        _hosts[j + 1] = h;
+    }
+}
+
+// FNV-1a over the ranked endpoint list
+uint32_t HostCache::signature() const
+{
+    uint32_t hash = 2166136261UL;
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        const HostEntry &h = _hosts[i];
+        uint8_t bytes[7] = {(uint8_t)h.ip, (uint8_t)(h.ip >> 8), (uint8_t)(h.ip >> 16),
+                            (uint8_t)(h.ip >> 24), (uint8_t)h.port, (uint8_t)(h.port >> 8),
+                            h.backend};
+        for (uint8_t k = 0; k < sizeof(bytes); k++)
+            hash = (hash ^ bytes[k]) * 16777619UL;
+    }
+    return hash ^ _count;
+}
+
+void HostCache::appendStats(String &out) const
+{
+    out += "known hosts: " + String(_count) + "\n";
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        const HostEntry &h = _hosts[i];
+        out += "  " + String(i + 1) + ". " + IPAddress(h.ip).toString() + ":" + String(h.port);
+        out += " backend=" + String(h.backend);
+        out += " rtt=" + String(h.rttMs) + "ms";
+        out += " failures=" + String(h.failures);
+        out += " last_ok=#" + String(h.lastOkSeq) + "\n";
+    }
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <Arduino.h>
+#include <IPAddress.h>
+#include <Preferences.h>
+
+// One endpoint we connected to before (persisted as-is, keep it POD)
+struct HostEntry
+{
+    uint32_t ip;        // IPAddress as stored by IPAddress (network order)
+    uint16_t port;
+    uint8_t backend;    // caller's backend id (CAT, API, ...)
+    uint8_t failures;   // consecutive failed attempts, saturating
+    uint32_t lastOkSeq; // value of the success counter at the last success, 0 = never
+    uint16_t rttMs;     // smoothed TCP connect time
+    uint16_t reserved;
+};
+
+// Small ranked table of known endpoints, kept in Preferences as one blob.
+// Ranking: fewest consecutive failures, then most recently successful,
+// then fastest connect. There is no wall clock, so "recent" is a success
+// counter. The blob is only rewritten when the ranking (or the set of
+// hosts) changes, not on every RTT update.
+class HostCache
+{
+public:
+    static const uint8_t MAX_HOSTS = 6;
+
+    void load(Preferences &prefs, const char *key);
+    // Persist if the ranking changed since the last load/save
+    bool save(Preferences &prefs);
+
+    // Ranked endpoints for one backend/port; returns how many were written
+    uint8_t candidates(uint8_t backend, uint16_t port, IPAddress *out, uint8_t max) const;
+
+    void noteSuccess(const IPAddress &ip, uint16_t port, uint8_t backend, uint32_t rttMs);
+    void noteFailure(const IPAddress &ip, uint16_t port, uint8_t backend);
+
+    uint8_t count() const { return _count; }
+    void appendStats(String &out) const;
+
+private:
+    static const uint8_t BLOB_VERSION = 1;
+    static const uint8_t MAX_FAILURES = 255;
+
+    struct Blob
+    {
+        uint8_t version;
+        uint8_t count;
+        uint16_t reserved;
+        uint32_t successSeq;
+        HostEntry hosts[MAX_HOSTS];
+    };
+
+    int8_t find(uint32_t ip, uint16_t port, uint8_t backend) const;
+    int8_t slotFor(uint32_t ip, uint16_t port, uint8_t backend);
+    void rank();
+    uint32_t signature() const;
+
+    const char *_key = "hosts";
+    HostEntry _hosts[MAX_HOSTS];
+    uint8_t _count = 0;
+    uint32_t _successSeq = 0;
+    uint32_t _savedSignature = 0;
+};
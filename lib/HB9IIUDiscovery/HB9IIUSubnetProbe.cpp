@@ -0,0 +1,262 @@
+#include "HB9IIUSubnetProbe.h"
+#include <lwip/sockets.h>
+#include <lwip/etharp.h>
+#include <lwip/tcpip.h>
+#include <lwip/priv/tcpip_priv.h>
+
+static uint32_t toHost(const IPAddress &ip)
+{
+    return ((uint32_t)ip[0] << 24) | ((uint32_t)ip[1] << 16) | ((uint32_t)ip[2] << 8) | ip[3];
+}
+
+static IPAddress fromHost(uint32_t v)
+{
+    return IPAddress((uint8_t)(v >> 24), (uint8_t)(v >> 16), (uint8_t)(v >> 8), (uint8_t)v);
+}
+
+void SubnetProbe::begin(const IPAddress &self, uint16_t port, uint32_t timeoutMs)
+{
+    _self = self;
+    _port = port;
+    _timeoutMs = timeoutMs;
+    _priorityCount = 0;
+    _priorityNext = 0;
+    _sweepBase = _sweepNext = _sweepEnd = 0;
+    _held = false;
+    _probed = 0;
+    _elapsedMs = 0;
+    closeAll();
+}
+
+bool SubnetProbe::isPriority(const IPAddress &ip) const
+{
+    for (uint8_t i = 0; i < _priorityCount; i++)
+        if (_priority[i] == ip)
+            return true;
+    return false;
+}
+
+void SubnetProbe::add(const IPAddress &ip)
+{
+    if ((uint32_t)ip == 0 || ip == _self || _priorityCount >= MAX_PRIORITY || isPriority(ip))
+        return;
+    _priority[_priorityCount++] = ip;
+}
+
+void SubnetProbe::addNeighbours(const IPAddress &center, uint8_t radius)
+{
+    uint32_t c = toHost(center);
+    for (uint8_t d = 1; d <= radius; d++)
+    {
+        uint8_t last = (uint8_t)(c & 0xFF);
+        if (last + d < 255)
+            add(fromHost(c + d));
+        if (last > d)
+            add(fromHost(c - d));
+    }
+}
+
+// Copy of lwIP's ARP cache addresses, taken on the lwIP side
+struct ArpSnapshot
+{
+    struct tcpip_api_call_data call; // first: lwIP hands this pointer back
+    uint32_t addr[ARP_TABLE_SIZE];
+    size_t count;
+};
+
+static err_t readArpTable(struct tcpip_api_call_data *call)
+{
+    ArpSnapshot *snap = (ArpSnapshot *)call;
+    snap->count = 0;
+    for (size_t i = 0; i < ARP_TABLE_SIZE; i++)
+    {
+        ip4_addr_t *ip = nullptr;
+        struct netif *nif = nullptr;
+        struct eth_addr *eth = nullptr;
+        if (etharp_get_entry(i, &ip, &nif, &eth) && ip)
+            snap->addr[snap->count++] = ip->addr;
+    }
+    return ERR_OK;
+}
+
+void SubnetProbe::addArpTable()
+{
+    // etharp_get_entry() walks the live table: only with the core lock held,
+    // or on the tcpip thread itself when the core has no lock (IDF default)
+    ArpSnapshot snap;
+#if LWIP_TCPIP_CORE_LOCKING
+    LOCK_TCPIP_CORE();
+    readArpTable(&snap.call);
+    UNLOCK_TCPIP_CORE();
+#else
+    if (tcpip_api_call(readArpTable, &snap.call) != ERR_OK)
+        return;
+#endif
+    for (size_t i = 0; i < snap.count; i++)
+        add(IPAddress(snap.addr[i]));
+}
+
+void SubnetProbe::sweep(const IPAddress &mask, bool allowWide)
+{
+    uint32_t m = toHost(mask);
+    uint8_t prefix = 0;
+    while (prefix < 32 && (m & (0x80000000UL >> prefix)))
+        prefix++;
+
+    if (prefix < 24 && !allowWide)
+        prefix = 24;
+    if (prefix < MIN_PREFIX)
+        prefix = MIN_PREFIX;
+    if (prefix > 30)
+        return; // point-to-point: nothing to sweep
+
+    uint32_t hostBits = 32 - prefix;
+    _sweepBase = toHost(_self) & ~((1UL << hostBits) - 1);
+    _sweepNext = 1;                  // skip the network address
+    _sweepEnd = (1UL << hostBits) - 1; // ... and broadcast
+}
+
+bool SubnetProbe::nextCandidate(IPAddress &ip)
+{
+    if (_priorityNext < _priorityCount)
+    {
+        ip = _priority[_priorityNext++];
+        return true;
+    }
+    while (_sweepNext < _sweepEnd)
+    {
+        ip = fromHost(_sweepBase + _sweepNext++);
+        if (ip != _self && !isPriority(ip))
+            return true;
+    }
+    return false;
+}
+
+bool SubnetProbe::open(Slot &slot, const IPAddress &ip)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+        return false; // out of sockets: retry on the next round
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(_port);
+    addr.sin_addr.s_addr = (uint32_t)ip;
+
+    _probed++;
+    int rc = connect(fd, (struct sockaddr *)&addr, sizeof(addr));
+    if (rc < 0 && errno != EINPROGRESS)
+    {
+        close(fd); // refused / unreachable right away
+        slot.fd = -1;
+        return true;
+    }
+    slot.fd = fd;
+    slot.ip = ip;
+    slot.startMs = millis();
+    return true;
+}
+
+void SubnetProbe::closeAll()
+{
+    for (uint8_t i = 0; i < WINDOW; i++)
+    {
+        if (_slots[i].fd >= 0)
+            close(_slots[i].fd);
+        _slots[i].fd = -1;
+    }
+}
+
+bool SubnetProbe::run(IPAddress &found, uint32_t budgetMs)
+{
+    uint32_t t0 = millis();
+    bool more = _priorityNext < _priorityCount || _sweepNext < _sweepEnd || _held;
+
+    while (millis() - t0 < budgetMs)
+    {
+        // keep the window full
+        for (uint8_t i = 0; i < WINDOW && more; i++)
+        {
+            if (_slots[i].fd >= 0)
+                continue;
+            IPAddress ip;
+            if (_held)
+                ip = _heldIp;
+            else
+                more = nextCandidate(ip);
+            if (!more)
+                break;
+            _held = !open(_slots[i], ip);
+            if (_held)
+            {
+                _heldIp = ip; // no free socket: try it again next round
+                break;
+            }
+        }
+
+        fd_set wset;
+        FD_ZERO(&wset);
+        int maxFd = -1;
+        for (uint8_t i = 0; i < WINDOW; i++)
+        {
+            if (_slots[i].fd < 0)
+                continue;
+            FD_SET(_slots[i].fd, &wset);
+            if (_slots[i].fd > maxFd)
+                maxFd = _slots[i].fd;
+        }
+        if (maxFd < 0)
+        {
+            if (!more && !_held)
+                break; // everything tried
+            delay(10);
+            continue;
+        }
+
+        struct timeval tv = {0, 10000}; // 10 ms: lets other tasks run
+        int ready = select(maxFd + 1, nullptr, &wset, nullptr, &tv);
+
+        uint32_t now = millis();
+        for (uint8_t i = 0; i < WINDOW; i++)
+        {
+            Slot &s = _slots[i];
+            if (s.fd < 0)
+                continue;
+            if (ready > 0 && FD_ISSET(s.fd, &wset))
+            {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                getsockopt(s.fd, SOL_SOCKET, SO_ERROR, &err, &len);
+                if (err == 0)
+                {
+                    found = s.ip;
+                    closeAll();
+                    _elapsedMs += millis() - t0;
+                    return true;
+                }
+                close(s.fd); // refused
+                s.fd = -1;
+            }
+            else if (now - s.startMs >= _timeoutMs)
+            {
+                close(s.fd); // nobody home
+                s.fd = -1;
+            }
+        }
+    }
+
+    _elapsedMs += millis() - t0;
+    return false;
+}
+
+bool SubnetProbe::exhausted() const
+{
+    if (_held || _priorityNext < _priorityCount || _sweepNext < _sweepEnd)
+        return false;
+    for (uint8_t i = 0; i < WINDOW; i++)
+        if (_slots[i].fd >= 0)
+            return false;
+    return true;
+}
@@ -0,0 +1,80 @@
+#pragma once
+#include <Arduino.h>
+#include <IPAddress.h>
+
+// Finds the first host with an open TCP port by keeping several
+// non-blocking lwIP connect()s in flight and collecting them with
+// select(). Likely hosts (added with add()/addNeighbours()/addArpTable())
+// are probed first, then the subnet sweep, skipping what was already tried.
+// Used when no discovery broadcast arrives (CAT server on a PC, routed
+// network, broadcasts filtered).
+class SubnetProbe
+{
+public:
+    static const uint8_t WINDOW = 8;          // sockets in flight (lwIP has ~16 in total)
+    static const uint8_t MAX_PRIORITY = 32;   // likely hosts probed before the sweep
+    static const uint8_t MIN_PREFIX = 20;     // widest sweep we allow (4094 hosts)
+
+    // self: our own address (never probed); port: TCP port to look for;
+    // timeoutMs: per-host connect timeout
+    void begin(const IPAddress &self, uint16_t port, uint32_t timeoutMs);
+
+    // Likely hosts, in the order given (duplicates and our own IP skipped)
+    void add(const IPAddress &ip);
+    // Hosts just around `center` (gateway neighbours: PCs often sit there)
+    void addNeighbours(const IPAddress &center, uint8_t radius);
+    // Hosts we talked to recently (lwIP ARP cache)
+    void addArpTable();
+
+    // Then sweep our subnet; prefixes wider than /24 only if allowWide
+    void sweep(const IPAddress &mask, bool allowWide);
+
+    // Probe until one host accepts or everything failed / budgetMs passed.
+    // Probes still in flight when the budget runs out stay open, so a long
+    // scan can be run in short slices from loop(); see exhausted().
+    bool run(IPAddress &found, uint32_t budgetMs);
+    // Every candidate tried (and nothing in flight)
+    bool exhausted() const;
+    // Drop whatever is still in flight
+    void cancel() { closeAll(); }
+
+    ~SubnetProbe() { closeAll(); }
+
+    uint16_t probed() const { return _probed; }
+    uint32_t elapsedMs() const { return _elapsedMs; }
+
+    // Next host run() would probe (taken off the list); false when none is
+    // left. Public for test/test_subnet_probe.
+    bool nextCandidate(IPAddress &ip);
+
+private:
+    struct Slot
+    {
+        int fd = -1; // -1 = free
+        IPAddress ip;
+        uint32_t startMs;
+    };
+
+    bool isPriority(const IPAddress &ip) const;
+    bool open(Slot &slot, const IPAddress &ip);
+    void closeAll();
+
+    uint16_t _port = 0;
+    uint32_t _timeoutMs = 200;
+    IPAddress _self;
+
+    IPAddress _priority[MAX_PRIORITY];
+    uint8_t _priorityCount = 0;
+    uint8_t _priorityNext = 0;
+
+    // sweep: host numbers [_sweepNext, _sweepEnd) on network _sweepBase
+    uint32_t _sweepBase = 0; // host byte order
+    uint32_t _sweepNext = 0;
+    uint32_t _sweepEnd = 0;
+
+    Slot _slots[WINDOW];
+    IPAddress _heldIp; // candidate that found no free socket
+    bool _held = false;
+    uint16_t _probed = 0;
+    uint32_t _elapsedMs = 0;
+};
@@ -0,0 +1,27 @@
+#include "HB9IIUEncoder.h"
+
+int32_t EncoderDetents::take(int32_t edges, uint32_t nowUs)
+{
+    int32_t detents = (edges - _last) / EDGES_PER_DETENT; // truncates toward zero both ways
+    if (detents == 0)
+        return 0;
+    _last += detents * EDGES_PER_DETENT;
+    uint32_t n = detents > 0 ? detents : -detents;
+    _intervalUs = _moved ? (nowUs - _lastUs) / n : SLOW_US;
+    _lastUs = nowUs;
+    _moved = true;
+    return detents;
+}
+
+void EncoderDetents::add(int8_t dir, uint32_t intervalUs)
+{
+    _added += dir;
+    _intervalUs = intervalUs;
+}
+
+int32_t EncoderDetents::takeAdded()
+{
+    int32_t detents = _added;
+    _added = 0;
+    return detents;
+}
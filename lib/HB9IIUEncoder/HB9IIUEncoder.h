@@ -0,0 +1,76 @@
+#pragma once
+#include <stdint.h>
+
+// One rotary encoder as seen by the UI: a running count of quadrature
+// edges (4 per detent on the usual mechanical encoders). Backends:
+// PcntEncoder (ESP32 pulse counter, hardware glitch filter), the channels
+// of IsrEncoderBank (one GPIO interrupt for all encoders, fallback) and
+// MockEncoder (tests: test/test_encoder).
+// No Arduino headers here, so the UI logic builds on a PC.
+
+// Called from interrupt context when an idle encoder starts to move
+// (must live in IRAM on the ESP32)
+typedef void (*EncoderWakeFn)(void *arg);
+
+class EncoderDriver
+{
+public:
+    virtual ~EncoderDriver() {}
+
+    virtual const char *name() const = 0; // backend tag for /stats ("pcnt", "isr", ...)
+    virtual bool begin() = 0;
+
+    // Edges since begin(); call from one task only (the loop)
+    virtual int32_t edges() = 0;
+    // Pins may have moved unseen (e.g. after a re-sync): pick up their state
+    virtual void resync() {}
+
+    // Interrupts taken so far (per edge for ISR, per counter wrap for PCNT)
+    virtual uint32_t interrupts() const = 0;
+
+    // true if the backend delivers timestamped detents itself
+    // (IsrEncoderBank::drain()); edges() is then for statistics only
+    virtual bool timestamped() const { return false; }
+
+    // Event-driven loops: fn runs on the first movement after armWake(),
+    // so nobody has to poll edges() while the knob is still. Drivers
+    // that cannot do this never call it (the loop then has to poll).
+    virtual void setWake(EncoderWakeFn fn, void *arg) {}
+    // Knob idle again: the next movement should call the wake function
+    virtual void armWake() {}
+};
+
+// Loop-side detent counting for one encoder (host-testable). Fed either
+// from an edge count (take) or from timestamped detents (add/takeAdded).
+// Partial detents carry over to the next call.
+class EncoderDetents
+{
+public:
+    static const int32_t EDGES_PER_DETENT = 4;
+    static const uint32_t SLOW_US = 0xFFFFFFFFUL; // no previous detent
+
+    // Edges so far are not detents (new baseline); queued detents are dropped
+    void reset(int32_t edges)
+    {
+        _last = edges;
+        _added = 0;
+    }
+
+    // Edge-count drivers: whole detents since the last call (signed);
+    // the time per detent is spread over the detents of this batch
+    int32_t take(int32_t edges, uint32_t nowUs);
+
+    // Timestamped drivers: one detent, intervalUs after the previous one
+    void add(int8_t dir, uint32_t intervalUs);
+    int32_t takeAdded();
+
+    // Time per detent of the latest movement (acceleration)
+    uint32_t intervalUs() const { return _intervalUs; }
+
+private:
+    int32_t _last = 0;
+    uint32_t _lastUs = 0;
+    bool _moved = false;
+    int32_t _added = 0;
+    uint32_t _intervalUs = SLOW_US;
+};
@@ -0,0 +1,132 @@
+#include "HB9IIUIsrEncoderBank.h"
+#include <soc/soc.h>
+#include <soc/gpio_reg.h>
+#include <hal/cpu_hal.h>
+#include <atomic>
+
+// (previous AB << 2 | current AB) -> -1 / 0 / +1; in DRAM so the ISR can
+// run while the flash cache is off (NVS writes)
+static const DRAM_ATTR int8_t QDEC_TAB[16] = {
+    0, -1, +1, 0, +1, 0, 0, -1, -1, 0, 0, +1, 0, +1, -1, 0};
+
+// Longer than this between two detents, the cycle counter may have wrapped
+static const uint32_t CCOUNT_SAFE_MS = 10000;
+
+static inline uint8_t IRAM_ATTR pinLevel(uint32_t lo, uint32_t hi, uint8_t pin)
+{
+    return pin < 32 ? (lo >> pin) & 1 : (hi >> (pin - 32)) & 1;
+}
+
+uint8_t IsrEncoderBank::readAB(const Channel &c) const
+{
+    return (uint8_t(digitalRead(c._pinA)) << 1) | uint8_t(digitalRead(c._pinB));
+}
+
+void IsrEncoderBank::Channel::resync()
+{
+    if (_bank)
+        _last = _bank->readAB(*this);
+}
+
+void IsrEncoderBank::Channel::setWake(EncoderWakeFn fn, void *arg)
+{
+    if (!_bank)
+        return;
+    _bank->_wakeArg = arg;
+    _bank->_wake = fn; // pointer last: the ISR may be running already
+}
+
+IsrEncoderBank::Channel *IsrEncoderBank::add(uint8_t pinA, uint8_t pinB)
+{
+    if (_started || _count >= MAX_CHANNELS)
+        return nullptr;
+    Channel &c = _ch[_count++];
+    c._bank = this;
+    c._pinA = pinA;
+    c._pinB = pinB;
+    return &c;
+}
+
+bool IsrEncoderBank::begin()
+{
+    if (_started)
+        return true;
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        pinMode(_ch[i]._pinA, _mode);
+        pinMode(_ch[i]._pinB, _mode);
+        _ch[i]._last = readAB(_ch[i]);
+    }
+    _started = true; // before attaching: the handler may run right away
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        attachInterruptArg(digitalPinToInterrupt(_ch[i]._pinA), isr, this, CHANGE);
+        attachInterruptArg(digitalPinToInterrupt(_ch[i]._pinB), isr, this, CHANGE);
+    }
+    return true;
+}
+
+// Every edge on any encoder pin: one register snapshot, all channels
+void IRAM_ATTR IsrEncoderBank::isr(void *arg)
+{
+    IsrEncoderBank &self = *static_cast<IsrEncoderBank *>(arg);
+    uint32_t lo = REG_READ(GPIO_IN_REG);
+    uint32_t hi = REG_READ(GPIO_IN1_REG);
+    uint32_t ccount = cpu_hal_get_cycle_count();
+    self._interrupts++;
+    bool queued = false;
+
+    for (uint8_t i = 0; i < self._count; i++)
+    {
+        Channel &c = self._ch[i];
+        uint8_t now = (pinLevel(lo, hi, c._pinA) << 1) | pinLevel(lo, hi, c._pinB);
+        int8_t d = QDEC_TAB[(c._last << 2) | now];
+        c._last = now;
+        if (!d)
+            continue;
+        c._edges += d;
+        c._partial += d;
+        if (c._partial > -EncoderDetents::EDGES_PER_DETENT && c._partial < EncoderDetents::EDGES_PER_DETENT)
+            continue;
+
+        EncoderEvent &e = self._ring[self._head % RING];
+        if (self._head - self._tail >= RING)
+        {
+            self._dropped++; // loop stuck for 64 detents: this one is lost
+        }
+        else
+        {
+            e.id = i;
+            e.dir = c._partial > 0 ? 1 : -1;
+            e.ccount = ccount;
+            std::atomic_signal_fence(std::memory_order_release); // event before head
+            self._head = self._head + 1;
+            queued = true;
+        }
+        c._partial = 0;
+    }
+    if (queued && self._wake)
+        self._wake(self._wakeArg);
+}
+
+bool IsrEncoderBank::drain(uint8_t &id, int8_t &dir, uint32_t &intervalUs)
+{
+    if (_tail == _head)
+        return false;
+    std::atomic_signal_fence(std::memory_order_acquire); // head before event
+    const EncoderEvent &e = _ring[_tail % RING];
+    Channel &c = _ch[e.id];
+    uint32_t nowMs = millis();
+
+    if (c._lastMs == 0 || nowMs - c._lastMs > CCOUNT_SAFE_MS)
+        intervalUs = EncoderDetents::SLOW_US;
+    else
+        intervalUs = (e.ccount - c._lastCcount) / getCpuFrequencyMhz();
+    c._lastCcount = e.ccount;
+    c._lastMs = nowMs ? nowMs : 1;
+
+    id = e.id;
+    dir = e.dir;
+    _tail = _tail + 1;
+    return true;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include <Arduino.h>
+#include "HB9IIUEncoder.h"
+
+// One detent as seen by the ISR
+struct EncoderEvent
+{
+    uint8_t id;     // channel index in the bank
+    int8_t dir;     // +1 / -1
+    uint32_t ccount; // CPU cycle counter at the edge that completed it
+};
+
+// Software fallback for all encoders at once: one IRAM handler on every
+// A/B pin reads the GPIO input registers once, decodes every channel and
+// pushes timestamped detents into a lock-free ring. The loop drains the
+// ring without masking interrupts and gets exact inter-detent times.
+class IsrEncoderBank
+{
+public:
+    static const uint8_t MAX_CHANNELS = 4;
+    static const uint8_t RING = 64; // power of two
+
+    // One encoder of the bank, usable wherever an EncoderDriver is
+    class Channel : public EncoderDriver
+    {
+    public:
+        const char *name() const override { return "isr"; }
+        bool begin() override { return _bank && _bank->begin(); }
+        int32_t edges() override { return _edges; } // aligned 32-bit read: atomic
+        void resync() override;
+        uint32_t interrupts() const override { return _bank ? _bank->_interrupts : 0; }
+        bool timestamped() const override { return true; }
+        // Every detent of the bank wakes (the ISR runs anyway)
+        void setWake(EncoderWakeFn fn, void *arg) override;
+
+    private:
+        friend class IsrEncoderBank;
+        IsrEncoderBank *_bank = nullptr;
+        uint8_t _pinA = 0, _pinB = 0;
+        volatile uint8_t _last = 0;   // previous AB state
+        volatile int8_t _partial = 0; // edges toward the next detent
+        volatile int32_t _edges = 0;
+        uint32_t _lastCcount = 0;     // loop side: previous detent
+        uint32_t _lastMs = 0;
+    };
+
+    explicit IsrEncoderBank(uint8_t inputMode) : _mode(inputMode) {}
+
+    // Before begin(): returns the channel (nullptr if the bank is full)
+    Channel *add(uint8_t pinA, uint8_t pinB);
+    // Attach the handler to every pin (once; later calls are no-ops)
+    bool begin();
+
+    // Loop side: next detent; intervalUs is the time since the previous
+    // detent of the same channel (EncoderDetents::SLOW_US after a long pause)
+    bool drain(uint8_t &id, int8_t &dir, uint32_t &intervalUs);
+
+    uint32_t dropped() const { return _dropped; }
+
+private:
+    static void isr(void *arg);
+    uint8_t readAB(const Channel &c) const;
+
+    uint8_t _mode;
+    bool _started = false;
+    EncoderWakeFn _wake = nullptr; // once per interrupt that queued a detent
+    void *_wakeArg = nullptr;
+    Channel _ch[MAX_CHANNELS];
+    uint8_t _count = 0;
+
+    // ring written by the ISR, read by the loop (single core, single producer)
+    EncoderEvent _ring[RING];
+    volatile uint32_t _head = 0;
+    volatile uint32_t _tail = 0;
+    volatile uint32_t _dropped = 0;
+    volatile uint32_t _interrupts = 0;
+};
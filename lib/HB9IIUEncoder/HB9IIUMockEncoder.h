@@ -0,0 +1,18 @@
+#pragma once
+#include "HB9IIUEncoder.h"
+
+// Host backend: the test turns the knob
+class MockEncoder : public EncoderDriver
+{
+public:
+    const char *name() const override { return "mock"; }
+    bool begin() override { return true; }
+    int32_t edges() override { return _edges; }
+    uint32_t interrupts() const override { return 0; }
+
+    void turn(int32_t detents) { _edges += detents * EncoderDetents::EDGES_PER_DETENT; }
+    void step(int32_t edges) { _edges += edges; } // partial detents, bounce
+
+private:
+    int32_t _edges = 0;
+};
@@ -0,0 +1,110 @@
+#include "HB9IIUPcntEncoder.h"
+#include <driver/gpio.h>
+#include <hal/gpio_ll.h>
+
+static bool isrServiceInstalled = false;
+
+void IRAM_ATTR PcntEncoder::onLimit(void *arg)
+{
+    static_cast<PcntEncoder *>(arg)->_wraps++; // statistics only, see edges()
+}
+
+void IRAM_ATTR PcntEncoder::onWakeEdge(void *arg)
+{
+    PcntEncoder &self = *static_cast<PcntEncoder *>(arg);
+    gpio_ll_intr_disable(&GPIO, (gpio_num_t)self._pinA); // register write, IRAM-safe
+    self._wakeups++;
+    if (self._wake)
+        self._wake(self._wakeArg);
+}
+
+void PcntEncoder::setWake(EncoderWakeFn fn, void *arg)
+{
+    _wakeArg = arg;
+    _wake = fn;
+    if (fn)
+    {
+        attachInterruptArg(digitalPinToInterrupt(_pinA), onWakeEdge, this, CHANGE);
+        gpio_intr_enable((gpio_num_t)_pinA);
+    }
+    else
+        detachInterrupt(digitalPinToInterrupt(_pinA));
+}
+
+void PcntEncoder::armWake()
+{
+    if (_wake)
+        gpio_intr_enable((gpio_num_t)_pinA);
+}
+
+bool PcntEncoder::begin()
+{
+    pinMode(_pinA, _mode);
+    pinMode(_pinB, _mode);
+
+    // channel 0 counts A edges, direction from B; channel 1 the other way round
+    pcnt_config_t c = {};
+    c.unit = _unit;
+    c.counter_h_lim = LIMIT;
+    c.counter_l_lim = -LIMIT;
+
+    c.channel = PCNT_CHANNEL_0;
+    c.pulse_gpio_num = _pinA;
+    c.ctrl_gpio_num = _pinB;
+    c.pos_mode = PCNT_COUNT_DEC;
+    c.neg_mode = PCNT_COUNT_INC;
+    c.lctrl_mode = PCNT_MODE_REVERSE;
+    c.hctrl_mode = PCNT_MODE_KEEP;
+    if (pcnt_unit_config(&c) != ESP_OK)
+        return false;
+
+    c.channel = PCNT_CHANNEL_1;
+    c.pulse_gpio_num = _pinB;
+    c.ctrl_gpio_num = _pinA;
+    c.pos_mode = PCNT_COUNT_INC;
+    c.neg_mode = PCNT_COUNT_DEC;
+    if (pcnt_unit_config(&c) != ESP_OK)
+        return false;
+
+    if (_filter)
+    {
+        pcnt_set_filter_value(_unit, _filter < FILTER_MAX ? _filter : (uint16_t)FILTER_MAX);
+        pcnt_filter_enable(_unit);
+    }
+
+    pcnt_counter_pause(_unit);
+    pcnt_counter_clear(_unit);
+
+    if (!isrServiceInstalled)
+    {
+        esp_err_t err = pcnt_isr_service_install(0);
+        if (err != ESP_OK && err != ESP_ERR_INVALID_STATE) // already installed elsewhere: fine
+            return false;
+        isrServiceInstalled = true;
+    }
+    pcnt_event_enable(_unit, PCNT_EVT_H_LIM);
+    pcnt_event_enable(_unit, PCNT_EVT_L_LIM);
+    pcnt_isr_handler_add(_unit, onLimit, this);
+    pcnt_intr_enable(_unit);
+
+    pcnt_counter_resume(_unit);
+    _lastRaw = 0;
+    _edges = 0;
+    return true;
+}
+
+int32_t PcntEncoder::edges()
+{
+    int16_t raw = 0;
+    pcnt_get_counter_value(_unit, &raw);
+
+    // the loop reads far more often than LIMIT / 2 edges can pass
+    int32_t delta = (int32_t)raw - _lastRaw;
+    if (delta > LIMIT / 2)
+        delta -= LIMIT;
+    else if (delta < -LIMIT / 2)
+        delta += LIMIT;
+    _lastRaw = raw;
+    _edges += delta;
+    return _edges;
+}
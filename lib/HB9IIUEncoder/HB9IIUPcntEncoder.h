@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include <driver/pcnt.h>
+#include "HB9IIUEncoder.h"
+
+// Quadrature decoding in an ESP32 pulse-counter unit: both channels count
+// (x4, same direction convention as IsrEncoder), the hardware glitch
+// filter eats contact bounce, and the only interrupt is the counter
+// reaching its limit. The limit resets the counter to 0, which is
+// congruent modulo LIMIT, so edges() unwraps it without needing the
+// interrupt to have run yet.
+class PcntEncoder : public EncoderDriver
+{
+public:
+    static const int16_t LIMIT = 10000;       // counter range is -LIMIT..LIMIT
+    static const uint16_t FILTER_MAX = 1023;  // APB cycles (12.8 us at 80 MHz)
+
+    // filterCycles: pulses shorter than this many APB cycles are ignored
+    PcntEncoder(pcnt_unit_t unit, uint8_t pinA, uint8_t pinB, uint8_t inputMode,
+                uint16_t filterCycles = FILTER_MAX)
+        : _unit(unit), _pinA(pinA), _pinB(pinB), _mode(inputMode), _filter(filterCycles) {}
+
+    const char *name() const override { return "pcnt"; }
+    bool begin() override;
+    int32_t edges() override;
+    uint32_t interrupts() const override { return _wraps; }
+
+    // A GPIO interrupt on pin A (the counter still gets the signal through
+    // the GPIO matrix) that disables itself on the first edge: one
+    // interrupt per start of movement, none while the knob spins.
+    void setWake(EncoderWakeFn fn, void *arg) override;
+    void armWake() override;
+    uint32_t wakeups() const { return _wakeups; }
+
+private:
+    static void onLimit(void *arg);
+    static void onWakeEdge(void *arg);
+
+    pcnt_unit_t _unit;
+    uint8_t _pinA, _pinB, _mode;
+    uint16_t _filter;
+
+    int16_t _lastRaw = 0; // loop side
+    int32_t _edges = 0;
+    volatile uint32_t _wraps = 0;
+
+    EncoderWakeFn _wake = nullptr;
+    void *_wakeArg = nullptr;
+    volatile uint32_t _wakeups = 0;
+};
@@ -0,0 +1,82 @@
+#include "HB9IIUTuningAccel.h"
+
+// Slow turns are exact; from a brisk spin on it ramps up to x200
+static const TuningAccel::CurvePoint DEFAULT_CURVE[] = {
+    {0, 1}, {100, 1}, {300, 4}, {800, 30}, {1500, 200}};
+
+TuningAccel::TuningAccel()
+{
+    setCurve(DEFAULT_CURVE, sizeof(DEFAULT_CURVE) / sizeof(DEFAULT_CURVE[0]));
+}
+
+void TuningAccel::setCurve(const CurvePoint *points, uint8_t count)
+{
+    if (count == 0)
+        return;
+    if (count > MAX_POINTS)
+        count = MAX_POINTS;
+    for (uint8_t i = 0; i < count; i++)
+        _curve[i] = points[i];
+    _points = count;
+}
+
+void TuningAccel::setRange(uint32_t minHz, uint32_t maxHz)
+{
+    _minHz = minHz;
+    _maxHz = maxHz;
+}
+
+uint16_t TuningAccel::curveAt(uint32_t v) const
+{
+    if (v <= _curve[0].detentsPerSec)
+        return _curve[0].multiplier;
+    for (uint8_t i = 1; i < _points; i++)
+    {
+        const CurvePoint &a = _curve[i - 1];
+        const CurvePoint &b = _curve[i];
+        if (v < b.detentsPerSec)
+        {
+            uint32_t span = b.detentsPerSec - a.detentsPerSec;
+            int32_t rise = (int32_t)b.multiplier - a.multiplier;
+            return (uint16_t)(a.multiplier + rise * (int32_t)(v - a.detentsPerSec) / (int32_t)span);
+        }
+    }
+    return _curve[_points - 1].multiplier;
+}
+
+uint32_t TuningAccel::apply(uint32_t freqHz, int32_t detents, uint32_t intervalUs, uint32_t stepHz)
+{
+    if (detents == 0)
+        return freqHz;
+    if (stepHz == 0)
+        stepHz = 1;
+
+    // EWMA (1/4 per detent, at most 8 rounds per batch) of the detent rate
+    uint32_t rate = intervalUs == 0 ? MAX_RATE : 1000000UL / intervalUs;
+    if (rate > MAX_RATE)
+        rate = MAX_RATE;
+    uint32_t target = rate << VEL_SHIFT;
+    uint32_t n = detents > 0 ? detents : -detents;
+    for (uint32_t i = 0; i < n && i < 8; i++)
+        _velocity = _velocity - _velocity / 4 + target / 4;
+    if (rate == 0)
+        _velocity = 0; // after a pause the first detent is always fine-grained
+
+    _mult = curveAt(velocity());
+    if (_mult == 0)
+        _mult = 1;
+
+    int64_t next = (int64_t)freqHz + (int64_t)detents * stepHz * _mult;
+
+    // snap to the grid in the direction of travel: off-grid starts land on the next line
+    if (detents > 0)
+        next = next / stepHz * stepHz;
+    else if (next >= 0)
+        next = (next + stepHz - 1) / stepHz * stepHz;
+
+    if (next < (int64_t)_minHz)
+        next = _minHz;
+    if (next > (int64_t)_maxHz)
+        next = _maxHz;
+    return (uint32_t)next;
+}
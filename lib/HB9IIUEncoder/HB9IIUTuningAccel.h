@@ -0,0 +1,46 @@
+#pragma once
+#include <stdint.h>
+
+// Velocity-based tuning acceleration (pure, host-testable).
+// Spin velocity is an EWMA over the time per detent; a piecewise-linear
+// curve maps it to a step multiplier. Steps land on the grid of the
+// mode's base step, so a slow knob always moves by exactly one step.
+class TuningAccel
+{
+public:
+    struct CurvePoint
+    {
+        uint16_t detentsPerSec; // velocity (ascending across the curve)
+        uint16_t multiplier;    // x base step at that velocity
+    };
+    static const uint8_t MAX_POINTS = 8;
+    static const uint32_t MAX_RATE = 10000; // detents/s: faster readings are noise
+
+    TuningAccel();
+
+    // Replace the curve (points with ascending velocity, at least one)
+    void setCurve(const CurvePoint *points, uint8_t count);
+    void setRange(uint32_t minHz, uint32_t maxHz);
+
+    // Knob stopped or frequency changed elsewhere: velocity starts over
+    void reset() { _velocity = 0; }
+
+    // detents (signed) arrived intervalUs apart (0xFFFFFFFF = after a pause).
+    // Returns the new frequency, snapped to the stepHz grid.
+    uint32_t apply(uint32_t freqHz, int32_t detents, uint32_t intervalUs, uint32_t stepHz);
+
+    uint32_t velocity() const { return _velocity >> VEL_SHIFT; } // detents/s
+    uint16_t multiplier() const { return _mult; }                // last one applied
+
+private:
+    static const uint8_t VEL_SHIFT = 4; // velocity kept in 1/16 detent/s
+
+    uint16_t curveAt(uint32_t detentsPerSec) const;
+
+    CurvePoint _curve[MAX_POINTS];
+    uint8_t _points = 0;
+    uint32_t _minHz = 0;
+    uint32_t _maxHz = 0xFFFFFFFFUL;
+    uint32_t _velocity = 0;
+    uint16_t _mult = 1;
+};
@@ -0,0 +1,70 @@
+#include "HB9IIUInputBindings.h"
+
+void InputBindings::setDefaults(const InputBinding *defaults, uint8_t count)
+{
+    _defaults = defaults;
+    _defaultCount = count < MAX_BINDINGS ? count : MAX_BINDINGS;
+    memcpy(_map, _defaults, sizeof(InputBinding) * _defaultCount);
+    _count = _defaultCount;
+}
+
+void InputBindings::load(Preferences &prefs, const char *key)
+{
+    _key = key;
+    Blob blob;
+    if (prefs.getBytesLength(key) == sizeof(blob) &&
+        prefs.getBytes(key, &blob, sizeof(blob)) == sizeof(blob) &&
+        blob.version == BLOB_VERSION && blob.count <= MAX_BINDINGS)
+    {
+        _count = blob.count;
+        memcpy(_map, blob.map, sizeof(InputBinding) * _count);
+    }
+}
+
+bool InputBindings::save(Preferences &prefs)
+{
+    Blob blob;
+    memset(&blob, 0, sizeof(blob));
+    blob.version = BLOB_VERSION;
+    blob.count = _count;
+    memcpy(blob.map, _map, sizeof(InputBinding) * _count);
+    return prefs.putBytes(_key, &blob, sizeof(blob)) == sizeof(blob);
+}
+
+void InputBindings::reset(Preferences &prefs)
+{
+    setDefaults(_defaults, _defaultCount);
+    prefs.remove(_key);
+}
+
+bool InputBindings::bind(uint8_t input, InputGesture gesture, uint8_t action)
+{
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        if (_map[i].input != input || _map[i].gesture != gesture)
+            continue;
+        if (action)
+        {
+            _map[i].action = action;
+        }
+        else
+        {
+            _map[i] = _map[--_count]; // order does not matter
+        }
+        return true;
+    }
+    if (!action)
+        return true;
+    if (_count >= MAX_BINDINGS)
+        return false;
+    _map[_count++] = {input, (uint8_t)gesture, action};
+    return true;
+}
+
+uint8_t InputBindings::action(uint8_t input, InputGesture gesture) const
+{
+    for (uint8_t i = 0; i < _count; i++)
+        if (_map[i].input == input && _map[i].gesture == gesture)
+            return _map[i].action;
+    return 0;
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <Arduino.h>
+#include <Preferences.h>
+#include "HB9IIUInputEngine.h"
+
+// One entry of the binding map (persisted as-is, keep it POD)
+struct InputBinding
+{
+    uint8_t input;   // row in the input table
+    uint8_t gesture; // InputGesture
+    uint8_t action;  // caller's action id, 0 = none
+};
+
+// (input, gesture) -> action, changeable at run time and kept in
+// Preferences as one blob. The caller supplies the defaults.
+class InputBindings
+{
+public:
+    static const uint8_t MAX_BINDINGS = 24;
+
+    void setDefaults(const InputBinding *defaults, uint8_t count);
+    // Saved map if there is a valid one, else the defaults
+    void load(Preferences &prefs, const char *key);
+    bool save(Preferences &prefs);
+    // Back to the defaults (and forget the saved map)
+    void reset(Preferences &prefs);
+
+    // action 0 removes the binding; false if the map is full
+    bool bind(uint8_t input, InputGesture gesture, uint8_t action);
+    uint8_t action(uint8_t input, InputGesture gesture) const;
+
+    uint8_t count() const { return _count; }
+    const InputBinding &at(uint8_t i) const { return _map[i]; }
+
+private:
+    static const uint8_t BLOB_VERSION = 1;
+
+    struct Blob
+    {
+        uint8_t version;
+        uint8_t count;
+        InputBinding map[MAX_BINDINGS];
+    };
+
+    const char *_key = "inbind";
+    const InputBinding *_defaults = nullptr;
+    uint8_t _defaultCount = 0;
+    InputBinding _map[MAX_BINDINGS];
+    uint8_t _count = 0;
+};
@@ -0,0 +1,98 @@
+#include "HB9IIUInputEngine.h"
+
+static const char *const GESTURE_NAMES[GESTURE_COUNT] = {"press", "release", "click", "double", "long"};
+
+const char *InputEngine::gestureName(InputGesture g)
+{
+    return g < GESTURE_COUNT ? GESTURE_NAMES[g] : "?";
+}
+
+bool InputEngine::level(uint8_t i, uint64_t levels) const
+{
+    bool high = (levels >> _table[i].pin) & 1;
+    return high == _table[i].activeHigh;
+}
+
+void InputEngine::begin(const InputPin *table, uint8_t count, uint64_t levels, uint32_t nowMs)
+{
+    _table = table;
+    _count = count < MAX_INPUTS ? count : MAX_INPUTS;
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        State &s = _st[i];
+        s = State();
+        s.down = level(i, levels);
+        s.longFired = s.down; // held at boot: no gestures until it is released
+        s.changeMs = nowMs;
+    }
+    _busy = false;
+}
+
+uint8_t InputEngine::scan(uint64_t levels, uint32_t nowMs, InputEvent *out, uint8_t max)
+{
+    uint8_t n = 0;
+    bool busy = false;
+
+    for (uint8_t i = 0; i < _count; i++)
+    {
+        const InputPin &p = _table[i];
+        State &s = _st[i];
+        bool raw = level(i, levels);
+
+        if (raw != s.down)
+        {
+            if (nowMs - s.changeMs < p.debounceMs)
+            {
+                busy = true; // look again once the window has passed
+                continue;
+            }
+            s.down = raw;
+            s.changeMs = nowMs;
+            if (raw)
+            {
+                s.pressMs = nowMs;
+                s.longFired = false;
+                s.doubled = s.tapPending && nowMs - s.tapMs <= p.doubleMs;
+                s.tapPending = false;
+                if (n < max)
+                    out[n++] = {i, GESTURE_PRESS};
+                if (s.doubled && n < max)
+                    out[n++] = {i, GESTURE_DOUBLE};
+            }
+            else
+            {
+                if (n < max)
+                    out[n++] = {i, GESTURE_RELEASE};
+                if (!s.longFired && !s.doubled)
+                {
+                    if (p.doubleMs)
+                    {
+                        s.tapPending = true;
+                        s.tapMs = nowMs;
+                    }
+                    else if (n < max)
+                        out[n++] = {i, GESTURE_CLICK};
+                }
+                s.longFired = false;
+            }
+        }
+
+        if (s.down && p.longMs && !s.longFired && nowMs - s.pressMs >= p.longMs)
+        {
+            s.longFired = true;
+            if (n < max)
+                out[n++] = {i, GESTURE_LONG};
+        }
+        if (s.tapPending && nowMs - s.tapMs > p.doubleMs)
+        {
+            s.tapPending = false;
+            if (n < max)
+                out[n++] = {i, GESTURE_CLICK};
+        }
+
+        if ((s.down && p.longMs && !s.longFired) || s.tapPending)
+            busy = true;
+    }
+    _busy = busy;
+    return n;
+}
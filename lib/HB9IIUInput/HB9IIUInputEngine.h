@@ -0,0 +1,75 @@
+#pragma once
+#include <stdint.h>
+
+// What one input did
+enum InputGesture : uint8_t
+{
+    GESTURE_PRESS = 0, // went active (right away, no waiting)
+    GESTURE_RELEASE,   // went inactive
+    GESTURE_CLICK,     // short press; held back for doubleMs if double-taps are on
+    GESTURE_DOUBLE,    // second press within doubleMs of the first release
+    GESTURE_LONG,      // still held after longMs (once per press)
+    GESTURE_COUNT
+};
+
+// One row of the input table
+struct InputPin
+{
+    const char *name;  // for /inputs and logs
+    uint8_t pin;       // GPIO number
+    bool activeHigh;   // TTP223 pads: true; buttons to GND: false
+    uint16_t debounceMs; // after a change, further changes wait this long
+    uint16_t longMs;   // 0 = no long press
+    uint16_t doubleMs; // 0 = no double-tap (clicks come at release)
+};
+
+struct InputEvent
+{
+    uint8_t input; // row in the table
+    InputGesture gesture;
+};
+
+// Debounce and gesture detection for a table of digital inputs, all
+// sampled in one go (a snapshot of the GPIO input registers). Debounce
+// is leading-edge: the first edge counts at once, later ones are ignored
+// until debounceMs has passed. Pure logic, no Arduino headers.
+class InputEngine
+{
+public:
+    static const uint8_t MAX_INPUTS = 16;
+
+    // levels: GPIO levels, bit n = GPIO n; the current states become the baseline
+    void begin(const InputPin *table, uint8_t count, uint64_t levels, uint32_t nowMs);
+
+    // One scan over all inputs; returns how many events were written to out
+    uint8_t scan(uint64_t levels, uint32_t nowMs, InputEvent *out, uint8_t max);
+
+    // true while a later scan may still produce something (held, tap
+    // pending, change inside the debounce window): keep sampling
+    bool busy() const { return _busy; }
+
+    uint8_t count() const { return _count; }
+    const InputPin &pin(uint8_t i) const { return _table[i]; }
+    bool active(uint8_t i) const { return _st[i].down; }
+
+    static const char *gestureName(InputGesture g);
+
+private:
+    struct State
+    {
+        bool down;
+        bool longFired;
+        bool doubled;    // this press was the second tap
+        bool tapPending; // released, waiting for a possible second tap
+        uint32_t changeMs; // last accepted change
+        uint32_t pressMs;
+        uint32_t tapMs;    // release of the pending tap
+    };
+
+    bool level(uint8_t i, uint64_t levels) const;
+
+    const InputPin *_table = nullptr;
+    uint8_t _count = 0;
+    State _st[MAX_INPUTS];
+    bool _busy = false;
+};
@@ -0,0 +1,123 @@
+#include "HB9IIULoopEvents.h"
+#include <esp_timer.h>
+
+void LoopEvents::begin()
+{
+    _task = xTaskGetCurrentTaskHandle();
+    _startUs = esp_timer_get_time();
+}
+
+void LoopEvents::post(uint32_t bits)
+{
+    if (_task)
+        xTaskNotify(_task, bits, eSetBits);
+}
+
+void IRAM_ATTR LoopEvents::postFromIsr(uint32_t bits)
+{
+    if (!_task)
+        return;
+    if (!_inputUs)
+        _inputUs = micros() | 1; // never 0
+    BaseType_t woken = pdFALSE;
+    xTaskNotifyFromISR(_task, bits, eSetBits, &woken);
+    if (woken)
+        portYIELD_FROM_ISR();
+}
+
+int8_t LoopEvents::find(uint32_t bits) const
+{
+    for (uint8_t i = 0; i < MAX_TIMERS; i++)
+        if (_timers[i].bits == bits)
+            return i;
+    return -1;
+}
+
+void LoopEvents::arm(uint32_t bits, uint32_t delayMs, uint32_t periodMs)
+{
+    if (!bits)
+        return;
+    int8_t i = find(bits);
+    if (i < 0)
+        i = find(0);
+    if (i < 0)
+        return; // all slots taken: a bug in the caller, not worth a crash
+    _timers[i].bits = bits;
+    _timers[i].periodMs = periodMs;
+    _timers[i].dueMs = millis() + delayMs;
+}
+
+void LoopEvents::cancel(uint32_t bits)
+{
+    int8_t i = find(bits);
+    if (i >= 0)
+        _timers[i].bits = 0;
+}
+
+bool LoopEvents::armed(uint32_t bits) const
+{
+    return bits && find(bits) >= 0;
+}
+
+uint32_t LoopEvents::wait()
+{
+    // sleep until the nearest timer (or forever if there is none)
+    uint32_t now = millis();
+    TickType_t ticks = portMAX_DELAY;
+    for (uint8_t i = 0; i < MAX_TIMERS; i++)
+    {
+        if (!_timers[i].bits)
+            continue;
+        int32_t left = (int32_t)(_timers[i].dueMs - now);
+        TickType_t t = left <= 0 ? 0 : (TickType_t)((left + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS);
+        if (t < ticks)
+            ticks = t;
+    }
+
+    uint32_t bits = 0;
+    int64_t t0 = esp_timer_get_time();
+    xTaskNotifyWait(0, 0xFFFFFFFFUL, &bits, ticks);
+    _sleptUs += esp_timer_get_time() - t0;
+    _wakeups++;
+    if (bits)
+        _posted++;
+
+    now = millis();
+    for (uint8_t i = 0; i < MAX_TIMERS; i++)
+    {
+        Timer &t = _timers[i];
+        if (!t.bits || (int32_t)(now - t.dueMs) < 0)
+            continue;
+        bits |= t.bits;
+        if (!t.periodMs)
+            t.bits = 0;
+        else if ((int32_t)(now - (t.dueMs += t.periodMs)) >= 0)
+            t.dueMs = now + t.periodMs; // fell behind: skip, don't burst
+    }
+    return bits;
+}
+
+void LoopEvents::inputDone(bool sent, bool held)
+{
+    uint32_t at = _inputUs;
+    if (!at || (!sent && held))
+        return;
+    _inputUs = 0;
+    if (!sent)
+        return;
+    uint32_t us = micros() - at;
+    _inputs++;
+    _latAvgUs = _inputs == 1 ? us : _latAvgUs - _latAvgUs / 8 + us / 8;
+    if (us > _latMaxUs)
+        _latMaxUs = us;
+}
+
+void LoopEvents::appendStats(String &out) const
+{
+    int64_t upUs = esp_timer_get_time() - _startUs;
+    uint32_t idlePermille = upUs > 0 ? (uint32_t)(_sleptUs * 1000 / upUs) : 0;
+    out += "loop: wakeups=" + String(_wakeups) + " (posted " + String(_posted) + ")";
+    out += " idle=" + String(idlePermille / 10) + "." + String(idlePermille % 10) + "%";
+    out += " input->sent avg=" + String(_latAvgUs) + "us max=" + String(_latMaxUs) + "us";
+    out += " inputs=" + String(_inputs) + "\n";
+}
@@ -0,0 +1,78 @@
+#pragma once
+#include <Arduino.h>
+
+// Wakes the control task (the Arduino loop) only when something happened.
+// ISRs, the CAT transport and other tasks set bits in its task
+// notification value; periodic work comes from a few timer slots; wait()
+// sleeps until either. The bits are the caller's (one per kind of work).
+class LoopEvents
+{
+public:
+    static const uint8_t MAX_TIMERS = 8;
+
+    // Bind to the calling task (setup() runs in the loop task)
+    void begin();
+    TaskHandle_t task() const { return _task; }
+
+    // Wake the loop with these bits (any task, not an ISR)
+    void post(uint32_t bits);
+    // Same from an ISR. The first input since the last inputDone() is
+    // timestamped for the input latency stats.
+    void postFromIsr(uint32_t bits);
+    // Loop side: an input found by polling (encoder scan) that happened
+    // at atUs; kept only if no interrupt stamped one first
+    void inputAt(uint32_t atUs)
+    {
+        if (!_inputUs)
+            _inputUs = atUs | 1;
+    }
+
+    // Post bits every periodMs, or once after delayMs; either replaces
+    // an earlier timer for the same bits
+    void every(uint32_t bits, uint32_t periodMs) { arm(bits, periodMs, periodMs); }
+    void after(uint32_t bits, uint32_t delayMs) { arm(bits, delayMs, 0); }
+    void cancel(uint32_t bits);
+    bool armed(uint32_t bits) const;
+
+    // Sleep until something is posted or the next timer is due;
+    // returns every bit that is set (posted and due timers)
+    uint32_t wait();
+
+    // End of a pass. sent: the scheduler handed a write to the transport
+    // (input->sent is counted); held: values still wait for the tick
+    // spacing (the stamp stays for the write that carries them). Neither:
+    // the input needed no write, its stamp is dropped.
+    void inputDone(bool sent, bool held);
+
+    void appendStats(String &out) const;
+    // Latency figures start over (a load test measures one phase at a time)
+    void resetLatency()
+    {
+        _inputs = 0;
+        _latAvgUs = 0;
+        _latMaxUs = 0;
+    }
+
+private:
+    struct Timer
+    {
+        uint32_t bits; // 0 = free slot
+        uint32_t periodMs; // 0 = one-shot
+        uint32_t dueMs;
+    };
+
+    void arm(uint32_t bits, uint32_t delayMs, uint32_t periodMs);
+    int8_t find(uint32_t bits) const;
+
+    TaskHandle_t _task = nullptr;
+    Timer _timers[MAX_TIMERS] = {};
+    volatile uint32_t _inputUs = 0; // micros() of the pending input, 0 = none
+
+    int64_t _startUs = 0; // esp_timer clock: no wrap
+    int64_t _sleptUs = 0;
+    uint32_t _wakeups = 0;
+    uint32_t _posted = 0; // wakeups with at least one posted bit
+    uint32_t _inputs = 0;
+    uint32_t _latAvgUs = 0; // EWMA 1/8
+    uint32_t _latMaxUs = 0;
+};
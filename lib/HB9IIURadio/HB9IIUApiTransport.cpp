@@ -0,0 +1,231 @@
+#include "HB9IIUApiTransport.h"
+
+// How often the task looks at the socket when nobody wakes it up
+static const TickType_t API_POLL_TICKS = pdMS_TO_TICKS(2);
+
+bool ApiTransport::begin(const char *taskName, BaseType_t core, UBaseType_t priority)
+{
+    if (_task)
+        return true;
+    return xTaskCreatePinnedToCore(taskEntry, taskName, 4096, this, priority, &_task, core) == pdPASS;
+}
+
+void ApiTransport::requestConnect(const IPAddress &host, uint16_t port, uint32_t timeoutMs)
+{
+    _reqHost = host;
+    _reqPort = port;
+    _reqTimeoutMs = timeoutMs;
+    setState(CONNECTING);
+    _request.store(REQ_CONNECT, std::memory_order_release);
+    if (_task)
+        xTaskNotifyGive(_task);
+}
+
+void ApiTransport::stop()
+{
+    _request.store(REQ_STOP, std::memory_order_release);
+    if (_task)
+        xTaskNotifyGive(_task);
+}
+
+bool ApiTransport::setPtt(bool on, uint32_t seq)
+{
+    if (!connected())
+        return false;
+    _ptt.store((seq << 2) | (on ? PTT_ON : PTT_OFF), std::memory_order_release);
+    if (_task)
+        xTaskNotifyGive(_task);
+    return true;
+}
+
+bool ApiTransport::emergencyUnkey(uint32_t seq)
+{
+    if (!setPtt(false, seq))
+        return false;
+    _emergencyUnkeys++;
+    return true;
+}
+
+bool ApiTransport::send(const char *data, size_t len)
+{
+    if (!connected() || len == 0 || len > sizeof(ApiTxPacket::data))
+    {
+        _txDropped++;
+        return false;
+    }
+
+    ApiTxPacket p;
+    memcpy(p.data, data, len);
+    p.len = (uint16_t)len;
+    p.queuedUs = micros();
+    if (!_txq.push(p))
+    {
+        _txDropped++;
+        return false;
+    }
+    xTaskNotifyGive(_task);
+    return true;
+}
+
+bool ApiTransport::receive(ApiRxChunk &out)
+{
+    uint8_t gen = _gen.load(std::memory_order_acquire);
+    while (_rxq.pop(out))
+        if (out.gen == gen)
+            return true; // older ones are the tail of a closed socket
+    return false;
+}
+
+// ---------------- transport task ----------------
+
+void ApiTransport::taskEntry(void *arg)
+{
+    static_cast<ApiTransport *>(arg)->run();
+}
+
+void ApiTransport::run()
+{
+    for (;;)
+    {
+        // sleep until send()/connect() wakes us, or the poll period elapses
+        ulTaskNotifyTake(pdTRUE, API_POLL_TICKS);
+
+        handleRequest();
+        if (state() != CONNECTED)
+            continue;
+
+        flushOutgoing();
+        readIncoming();
+
+        if (!_client.connected())
+        {
+            _client.stop();
+            uint8_t expected = CONNECTED;
+            if (_state.compare_exchange_strong(expected, IDLE))
+                wakeLoop();
+        }
+    }
+}
+
+void ApiTransport::handleRequest()
+{
+    uint8_t req = _request.exchange(REQ_NONE, std::memory_order_acquire);
+    if (req == REQ_NONE)
+        return;
+
+    if (_client.connected())
+        _client.stop();
+
+    // anything queued for the old socket is stale now, PTT included: the
+    // backend subscribes again and the radio reports where it stands.
+    // Received bytes are the loop's to drop (receive() checks the stamp).
+    ApiTxPacket stale;
+    while (_txq.pop(stale))
+    {
+    }
+    _ptt.store(0, std::memory_order_release);
+    _gen.fetch_add(1, std::memory_order_acq_rel);
+
+    if (req == REQ_STOP)
+    {
+        setState(IDLE);
+        return;
+    }
+
+    // only the task waits for the connect
+    if (_client.connect(_reqHost, _reqPort, _reqTimeoutMs))
+    {
+        _client.setNoDelay(true);
+        setState(CONNECTED);
+    }
+    else
+    {
+        setState(FAILED);
+    }
+    wakeLoop();
+}
+
+void ApiTransport::flushOutgoing()
+{
+    servicePtt(false); // un-key in a write of its own, ahead of everything
+    while (_client.connected() && writeQueued())
+        servicePtt(false); // an un-key that arrives meanwhile still goes first
+    servicePtt(true);      // key behind what was queued before it
+}
+
+// One queued packet to the socket; false if the ring was empty
+bool ApiTransport::writeQueued()
+{
+    ApiTxPacket p;
+    if (!_txq.pop(p))
+        return false;
+    if (!writeAll((const uint8_t *)p.data, p.len))
+        return true; // picked up as a disconnect by run()
+
+    uint32_t us = micros() - p.queuedUs;
+    _queuedAvgUs = _packetsSent ? _queuedAvgUs - _queuedAvgUs / 8 + us / 8 : us;
+    if (us > _queuedMaxUs)
+        _queuedMaxUs = us;
+    _packetsSent++;
+    return true;
+}
+
+void ApiTransport::servicePtt(bool allowKey)
+{
+    if (!_client.connected())
+        return;
+    uint32_t v = _ptt.load(std::memory_order_acquire);
+    uint8_t req = v & 3;
+    if (req == PTT_NONE || (req == PTT_ON && !allowKey))
+        return;
+    if (!_ptt.compare_exchange_strong(v, 0, std::memory_order_acq_rel))
+        return; // changed under us: the newer request goes on the next pass
+
+    if (req == PTT_ON)
+    {
+        // mode/power queued before the key must be on the wire first
+        while (_client.connected() && writeQueued())
+        {
+        }
+    }
+
+    char cmd[24];
+    int n = snprintf(cmd, sizeof(cmd), "C%u|xmit %u\n", (unsigned)(v >> 2), req == PTT_ON ? 1u : 0u);
+    writeAll((const uint8_t *)cmd, (size_t)n);
+}
+
+bool ApiTransport::writeAll(const uint8_t *data, size_t len)
+{
+    uint32_t t0 = micros();
+    size_t written = _client.write(data, len);
+    uint32_t writeUs = micros() - t0;
+    _writeAvgUs = _socketWrites ? _writeAvgUs - _writeAvgUs / 8 + writeUs / 8 : writeUs;
+    if (writeUs > _writeMaxUs)
+        _writeMaxUs = writeUs;
+    _socketWrites++;
+    if (written == len)
+        return true;
+    _client.stop();
+    return false;
+}
+
+void ApiTransport::readIncoming()
+{
+    uint32_t received = _bytesReceived;
+    // a full ring is back-pressure: the rest stays in the socket
+    while (_rxq.size() < _rxq.capacity() && _client.available())
+    {
+        servicePtt(false); // an un-key requested while we read goes out first
+
+        ApiRxChunk c;
+        c.gen = _gen.load(std::memory_order_relaxed);
+        int n = _client.read((uint8_t *)c.data, sizeof(c.data));
+        if (n <= 0)
+            break;
+        c.len = (uint8_t)n;
+        _rxq.push(c);
+        _bytesReceived += n;
+    }
+    if (_bytesReceived != received)
+        wakeLoop();
+}
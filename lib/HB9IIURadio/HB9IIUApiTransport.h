@@ -0,0 +1,142 @@
+#pragma once
+#include <Arduino.h>
+#include <WiFi.h>
+#include <atomic>
+#include "HB9IIUSpscQueue.h"
+
+// One outgoing write: the commands of one tick ("C12|slice tune 0 ...\n...")
+struct ApiTxPacket
+{
+    uint16_t len;
+    char data[256];
+    uint32_t queuedUs; // micros() at send(), for the latency stats
+};
+
+// Raw bytes as they came off the socket; lines are cut by the backend
+struct ApiRxChunk
+{
+    uint8_t gen; // connection it came from (older ones are dropped)
+    uint8_t len;
+    char data[126];
+};
+
+// Owns the SmartSDR API socket inside its own FreeRTOS task, like
+// CatTransport does for CAT: the loop pushes whole writes into a TX ring
+// and pulls received bytes from an RX ring, so a full send buffer or a
+// slow radio never stalls the knobs. The API is line based and its status
+// lines are long, so bytes are handed over unparsed (FlexApiBackend cuts
+// them). When the RX ring is full the task stops reading and TCP flow
+// control holds the radio back; nothing is dropped.
+class ApiTransport
+{
+public:
+    enum State : uint8_t
+    {
+        IDLE,       // no socket
+        CONNECTING, // connect requested, task is working on it
+        CONNECTED,  // socket up
+        FAILED      // last connect attempt failed
+    };
+
+    // Start the transport task (call once from setup())
+    bool begin(const char *taskName = "API", BaseType_t core = 0, UBaseType_t priority = 2);
+
+    // Ask the task to (re)connect; returns immediately (watch state())
+    void requestConnect(const IPAddress &host, uint16_t port, uint32_t timeoutMs);
+    // Ask the task to close the socket
+    void stop();
+
+    State state() const { return (State)_state.load(std::memory_order_acquire); }
+    bool connected() const { return state() == CONNECTED; }
+
+    // Loop side: queue one write (copied, up to 256 bytes). false if not
+    // connected or the ring is full.
+    bool send(const char *data, size_t len);
+
+    // PTT is one last-writer-wins slot ("C<seq>|xmit 0/1"), as in
+    // CatTransport: an un-key goes out ahead of every queued write, a key
+    // only behind the writes queued before it. Any task (not an ISR).
+    bool setPtt(bool on, uint32_t seq);
+    // setPtt(false) for the TX watchdog, counted separately
+    bool emergencyUnkey(uint32_t seq);
+
+    // Loop side: next chunk of received bytes from the current connection,
+    // false if none waiting
+    bool receive(ApiRxChunk &out);
+
+    // Notify task (eSetBits) when bytes arrived or the link dropped
+    void setWake(TaskHandle_t task, uint32_t bits)
+    {
+        _wakeBits = bits;
+        _wakeTask = task;
+    }
+
+    // Counters (written by one side only, safe to read anywhere)
+    uint32_t packetsSent() const { return _packetsSent; }
+    uint32_t socketWrites() const { return _socketWrites; }
+    uint32_t bytesReceived() const { return _bytesReceived; }
+    uint32_t txDropped() const { return _txDropped; }
+    uint32_t writeAvgUs() const { return _writeAvgUs; } // EWMA 1/8, time inside the socket write
+    uint32_t writeMaxUs() const { return _writeMaxUs; }
+    uint32_t queuedAvgUs() const { return _queuedAvgUs; } // send() -> written, EWMA 1/8
+    uint32_t queuedMaxUs() const { return _queuedMaxUs; }
+    uint32_t emergencyUnkeys() const { return _emergencyUnkeys; }
+
+private:
+    enum Request : uint8_t
+    {
+        REQ_NONE,
+        REQ_CONNECT,
+        REQ_STOP
+    };
+
+    // _ptt packs (seq << 2) | PttRequest; 0 = nothing pending
+    enum PttRequest : uint8_t
+    {
+        PTT_NONE,
+        PTT_ON,
+        PTT_OFF
+    };
+
+    static void taskEntry(void *arg);
+    void run();
+    void handleRequest();
+    void flushOutgoing();
+    bool writeQueued();
+    void servicePtt(bool allowKey);
+    bool writeAll(const uint8_t *data, size_t len);
+    void readIncoming();
+    void setState(State s) { _state.store(s, std::memory_order_release); }
+    void wakeLoop()
+    {
+        TaskHandle_t t = _wakeTask;
+        if (t)
+            xTaskNotify(t, _wakeBits, eSetBits);
+    }
+
+    TaskHandle_t _task = nullptr;
+    volatile TaskHandle_t _wakeTask = nullptr;
+    volatile uint32_t _wakeBits = 0;
+    WiFiClient _client; // only ever used from the transport task
+
+    std::atomic<uint8_t> _state{IDLE};
+    std::atomic<uint8_t> _request{REQ_NONE};
+    std::atomic<uint32_t> _ptt{0};
+    std::atomic<uint8_t> _gen{0}; // bumped per connect, stamped on every RX chunk
+    IPAddress _reqHost;
+    uint16_t _reqPort = 0;
+    uint32_t _reqTimeoutMs = 0;
+
+    SpscQueue<ApiTxPacket, 8> _txq;  // loop -> task
+    SpscQueue<ApiRxChunk, 16> _rxq;  // task -> loop
+
+    volatile uint32_t _packetsSent = 0;
+    volatile uint32_t _socketWrites = 0;
+    volatile uint32_t _bytesReceived = 0;
+    volatile uint32_t _txDropped = 0;
+    volatile uint32_t _writeAvgUs = 0;
+    volatile uint32_t _writeMaxUs = 0;
+    volatile uint32_t _queuedAvgUs = 0;
+    volatile uint32_t _queuedMaxUs = 0;
+    volatile uint32_t _emergencyUnkeys = 0;
+};
@@ -0,0 +1,529 @@
+#include "HB9IIUCatBackend.h"
+
+// RadioParam -> scheduler slot / query opcode (same order as RadioParam)
+static const CatSlot PARAM_SLOT[RADIO_PARAM_COUNT] = {
+    CAT_SLOT_VFO,    // RADIO_FREQ
+    CAT_SLOT_MODE,   // RADIO_MODE
+    CAT_SLOT_FILTER, // RADIO_FILTER
+    CAT_SLOT_AFGAIN, // RADIO_AFGAIN
+    CAT_SLOT_POWER,  // RADIO_POWER
+};
+static const CatOp PARAM_OP[RADIO_PARAM_COUNT] = {
+    CAT_OP_FA,   // RADIO_FREQ
+    CAT_OP_MD,   // RADIO_MODE
+    CAT_OP_ZZFI, // RADIO_FILTER
+    CAT_OP_ZZAG, // RADIO_AFGAIN
+    CAT_OP_ZZPC, // RADIO_POWER
+};
+
+CatBackend *CatBackend::_self = nullptr;
+
+CatBackend::CatBackend(uint16_t tickMs, uint8_t burst, uint16_t perSecond)
+    : _tickMs(tickMs), _burst(burst), _perSecond(perSecond), _minTickMs(tickMs), _maxTickMs(tickMs)
+{
+    for (uint8_t i = 0; i < RADIO_PARAM_COUNT; i++)
+        _seen[i] = -1;
+}
+
+void CatBackend::begin(RadioReportHandler onReport, RadioLogHandler onLog)
+{
+    _self = this;
+    _onReport = onReport;
+    _onLog = onLog;
+
+    // CAT transport task owns the socket from here on
+    _link.begin();
+    CatQuery::begin(_link);
+    _sched.begin(_link, _tickMs, _burst, _perSecond);
+}
+
+// No formatting here: the handler gets the bytes as they are (traffic
+// goes straight into the trace ring, see onRadioLog() in main.cpp)
+void CatBackend::log(RadioLogKind kind, const char *text, size_t len)
+{
+    if (_onLog)
+        _onLog(kind, text, len);
+}
+
+void CatBackend::beginConnect(const IPAddress &host, uint16_t port, uint32_t timeoutMs)
+{
+    _sched.dropPending(); // unsent writes belong to the dead link
+    _autoInfo = false;    // AI is per connection; poll until confirmed
+    _host = host;
+    _connectTimeoutMs = timeoutMs;
+    _connecting = true;
+    _link.requestConnect(host, port, timeoutMs); // the transport task does the waiting
+}
+
+RadioConnectState CatBackend::pollConnect()
+{
+    if (!_connecting)
+        return _link.connected() ? RADIO_CONNECT_UP : RADIO_CONNECT_FAILED;
+    CatTransport::State st = _link.state();
+    if (st == CatTransport::CONNECTING)
+        return RADIO_CONNECT_PENDING;
+    _connecting = false;
+    if (st != CatTransport::CONNECTED)
+        return RADIO_CONNECT_FAILED;
+
+    _failoversSeen = _link.failovers();
+    _rttSamples = 0; // new path, new measurements
+    _rttPending = false;
+    _pollOutstanding = false;
+    _sched.setTickMs(_tickMs);
+
+    if (_queryPort)
+    {
+        // not waited for: bindQueries() moves the queries over once it is up
+        _link.setStandby(IPAddress(), 0); // keep our two sockets apart from a standby
+        _queryLink.begin("CATQ");
+        _queryTryMs = millis();
+        _queryLink.requestConnect(_host, _queryPort, _connectTimeoutMs);
+    }
+    else
+    {
+        _queryLink.stop();
+    }
+    _queries = &_link;
+    CatQuery::begin(_link);
+    startSession();
+    return RADIO_CONNECT_UP;
+}
+
+// Keep CatQuery on the query socket while it is up, on the control socket
+// otherwise. AI is per connection: it is switched on wherever they land and
+// off on the control socket while split, so reports and FA/MD echoes stay
+// off the write path.
+void CatBackend::bindQueries()
+{
+    uint32_t now = millis();
+    if (_queryPort && _link.connected() && now - _queryTryMs >= QUERY_RETRY_MS)
+    {
+        CatTransport::State st = _queryLink.state();
+        if (st == CatTransport::IDLE || st == CatTransport::FAILED)
+        {
+            _queryTryMs = now;
+            _queryLink.requestConnect(_host, _queryPort, QUERY_CONNECT_TIMEOUT_MS);
+        }
+    }
+
+    CatTransport *want = _queryPort && _queryLink.connected() ? &_queryLink : &_link;
+    if (want == _queries)
+        return;
+    _queries = want;
+    CatQuery::begin(*want); // queries still open on the old socket just time out
+    _rttPending = false;    // the probe changes path with them
+    _pollOutstanding = false;
+    log(RADIO_LOG_INFO, want == &_queryLink ? "[CAT] Queries back on the query port."
+                                             : "[CAT] Query port lost; queries on the control socket.");
+    if (!_link.connected())
+        return;
+    if (want == &_queryLink)
+    {
+        log(RADIO_LOG_TX, "AI0;");
+        _link.send("AI0;", CAT_LANE_BACKGROUND);
+    }
+    _autoInfo = false;
+    startSession(); // back on _link this switches AI1 on there again
+}
+
+void CatBackend::startSession()
+{
+    // AI1 then read it back in the same write; "?;" + timeout = not supported
+    log(RADIO_LOG_TX, "AI1;AI;");
+    CatQuery::request("AI1;AI;", CAT_OP_AI, 800, onAutoInfoReply);
+    _activityMs = millis();
+}
+
+void CatBackend::setRateBounds(uint16_t minMs, uint16_t maxMs)
+{
+    _minTickMs = minMs;
+    _maxTickMs = maxMs > minMs ? maxMs : minMs;
+}
+
+// ZZTX; is cheap and nothing else waits for its answer. Always measured on
+// the control socket, the one adaptRate() paces: through CatQuery while
+// queries share it, sent directly (answer caught in service()) when split.
+void CatBackend::probeRtt()
+{
+    uint32_t now = millis();
+    if (_pollOutstanding && now - _lastPollMs >= POLL_REPLY_MS)
+        _pollOutstanding = false; // burst lost, don't wait on it forever
+    if (_rttPending && _rttDirect && now - _rttSentMs >= RTT_TIMEOUT_MS)
+        _rttPending = false;      // CatQuery times out its own requests
+    if (_rttPending || now - _rttSentMs < RTT_PROBE_MS || _pollOutstanding)
+        return; // a probe queued behind a poll burst would measure it, not the link
+
+    bool direct = _queries != &_link;
+    if (direct)
+    {
+        if (!_link.send("ZZTX;", CAT_LANE_BACKGROUND))
+            return;
+    }
+    else
+    {
+        if (CatQuery::pending())
+            return; // same reason: other queries ahead of it on this socket
+        if (!CatQuery::request("ZZTX;", CAT_OP_ZZTX, RTT_TIMEOUT_MS, onRttReply))
+            return;
+    }
+    _rttSentMs = now;
+    _rttPending = true;
+    _rttDirect = direct;
+}
+
+void CatBackend::onRttReply(const CatFrame *reply)
+{
+    CatBackend &self = *_self;
+    if (self._rttDirect)
+        return; // a query-path probe from before a split: no longer ours
+    self._rttPending = false;
+    if (reply)
+        self.addRttSample(millis() - self._rttSentMs);
+}
+
+void CatBackend::addRttSample(uint32_t ms)
+{
+    _rttMs = _rttSamples ? (_rttMs * 3 + ms) / 4 : ms;
+    if (!_rttSamples || ms < _rttFloorMs)
+        _rttFloorMs = ms;
+    else
+        _rttFloorMs++; // forget an old minimum after a while (route changes)
+    _rttSamples++;
+}
+
+void CatBackend::adaptRate()
+{
+    uint32_t now = millis();
+    if (_minTickMs >= _maxTickMs || now - _lastAdaptMs < RATE_ADAPT_MS)
+        return;
+    _lastAdaptMs = now;
+
+    // only writes since the last pass tell anything about the send buffer
+    uint32_t writes = _link.socketWrites();
+    bool wrote = writes != _writesSeen;
+    _writesSeen = writes;
+
+    bool congested = (wrote && _link.writeAvgUs() > WRITE_CONGESTED_US) ||
+                     (_rttSamples && _rttMs > 2 * _rttFloorMs + RTT_SLACK_MS);
+
+    uint32_t tick = _sched.tickMs();
+    if (congested)
+    {
+        tick += tick / 2 + 1;
+        _backoffs++;
+    }
+    else
+    {
+        // healthy: about one write per round trip, approached gently
+        uint32_t target = _rttSamples ? _rttMs : _minTickMs;
+        if (tick > target)
+            tick -= (tick - target + 3) / 4;
+    }
+    if (tick < _minTickMs)
+        tick = _minTickMs;
+    if (tick > _maxTickMs)
+        tick = _maxTickMs;
+    _sched.setTickMs((uint16_t)tick);
+}
+
+bool CatBackend::setStandby(const IPAddress &host, uint16_t port)
+{
+    if (_queryPort && port)
+        return false; // both spare sockets at once would eat lwIP's small pool
+    _link.setStandby(host, port);
+    return true;
+}
+
+void CatBackend::onAutoInfoReply(const CatFrame *reply)
+{
+    CatBackend &self = *_self;
+    self._autoInfo = reply && reply->hasValue && reply->value > 0;
+    self._activityMs = millis();
+    self.log(RADIO_LOG_INFO, self._autoInfo ? "[CAT] Auto-information on; polling off."
+                                            : "[CAT] No auto-information; using adaptive polling.");
+}
+
+void CatBackend::set(RadioParam param, int32_t value)
+{
+    if (param >= RADIO_PARAM_COUNT || value < 0)
+        return;
+    _sched.set(PARAM_SLOT[param], (uint32_t)value);
+    _activityMs = millis();
+    if (param == RADIO_FREQ)
+        _freqSetMs = _activityMs;
+}
+
+bool CatBackend::pending(RadioParam param) const
+{
+    return param < RADIO_PARAM_COUNT && _sched.pending(PARAM_SLOT[param]);
+}
+
+void CatBackend::cancel(RadioParam param)
+{
+    if (param < RADIO_PARAM_COUNT)
+        _sched.cancel(PARAM_SLOT[param]);
+}
+
+bool CatBackend::tick(bool force)
+{
+    bool sent = force ? _sched.flush() : _sched.tick();
+    if (!sent)
+        return false;
+    for (uint8_t p = 0; p < RADIO_PARAM_COUNT; p++)
+        if (_sched.lastSent(PARAM_SLOT[p]))
+            _sent.note((RadioParam)p, (int32_t)_sched.value(PARAM_SLOT[p]));
+    _activityMs = millis(); // keeps fallback polling in its fast phase
+    log(RADIO_LOG_TX, _sched.lastBatch());
+    return true;
+}
+
+bool CatBackend::setPtt(bool on)
+{
+    if (!_link.connected())
+        return false;
+
+    // Queued mode/power changes (e.g. TUNE prep) must land before we key;
+    // if they could not even be queued, keying would transmit with the old ones
+    if (on)
+    {
+        tick(true);
+        if (_sched.pending(CAT_SLOT_MODE) || _sched.pending(CAT_SLOT_POWER))
+        {
+            log(RADIO_LOG_INFO, "[CAT] Mode/power not queued; not keying.");
+            return false;
+        }
+    }
+
+    // one PTT slot in the transport: keying stays behind the flushed
+    // writes, un-keying jumps every queue, the newest request wins
+    log(RADIO_LOG_TX, on ? "ZZTX1;" : "ZZTX0;");
+    return _link.setPtt(on);
+}
+
+bool CatBackend::query(const RadioParam *params, uint8_t count, uint32_t timeoutMs,
+                       RadioSnapshotHandler onDone)
+{
+    if (!_link.connected() || count == 0 || count > CatBatch::MAX_OPS)
+        return false;
+
+    uint8_t tag = MAX_QUERIES;
+    for (uint8_t i = 0; i < MAX_QUERIES; i++)
+    {
+        if (!_snapshots[i])
+        {
+            tag = i;
+            break;
+        }
+    }
+    if (tag == MAX_QUERIES)
+        return false;
+
+    CatOp ops[CatBatch::MAX_OPS];
+    char text[32];
+    size_t n = 0;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (params[i] >= RADIO_PARAM_COUNT)
+            return false;
+        ops[i] = PARAM_OP[params[i]];
+        n += snprintf(text + n, sizeof(text) - n, "%s;", catOpName(ops[i]));
+    }
+
+    // one write, one deadline, replies matched by opcode
+    if (!CatQuery::batch(ops, count, timeoutMs, onBatch, tag))
+        return false;
+    _snapshots[tag] = onDone;
+    log(RADIO_LOG_TX, text);
+    return true;
+}
+
+void CatBackend::onBatch(const CatBatch &b)
+{
+    CatBackend &self = *_self;
+    RadioSnapshotHandler onDone = self._snapshots[b.tag];
+    self._snapshots[b.tag] = nullptr; // free first: the handler may query again
+
+    RadioSnapshot s;
+    for (uint8_t p = 0; p < RADIO_PARAM_COUNT; p++)
+    {
+        const CatFrame *f = b.reply(PARAM_OP[p]);
+        s.valid[p] = f && f->hasValue;
+        s.value[p] = s.valid[p] ? f->value : -1;
+        if (f)
+            self.log(RADIO_LOG_RX, f->text);
+    }
+    s.elapsedMs = b.elapsedMs;
+
+    if (onDone)
+        onDone(s);
+}
+
+// Frames nobody asked for: AI reports, poll answers, radio chatter
+void CatBackend::onFrame(const CatFrame &f)
+{
+    CatBackend &self = *_self;
+
+    if (f.op == CAT_OP_ERROR)
+    {
+        self.log(RADIO_LOG_RX, "?; (ignored)");
+        return;
+    }
+    self.log(RADIO_LOG_RX, f.text);
+    if (f.op == CAT_OP_ZZAG)
+        self._pollOutstanding = false; // last answer of a poll burst (or an AI report)
+
+    for (uint8_t p = 0; p < RADIO_PARAM_COUNT; p++)
+    {
+        if (PARAM_OP[p] != f.op || !f.hasValue)
+            continue;
+        if (f.value != self._seen[p])
+        {
+            self._seen[p] = f.value;
+            self._activityMs = millis();
+        }
+        if (self._onReport)
+            self._onReport((RadioParam)p, f.value);
+        return;
+    }
+}
+
+void CatBackend::poll()
+{
+    uint32_t now = millis();
+    uint32_t period = POLL_SLOW_MS;
+    if (now - _activityMs < POLL_ACTIVE_WINDOW_MS)
+        period = POLL_FAST_MS;
+    if (now - _lastPollMs <= period)
+        return;
+    // while the knob turns an FA; answer would only report a value we already passed
+    if (now - _freqSetMs < POLL_TUNE_GUARD_MS)
+        return;
+
+    _lastPollMs = now;
+    if (_queries->send("FA;MD;ZZFI;ZZAG;", CAT_LANE_BACKGROUND)) // answers come back through onFrame()
+    {
+        _polls++;
+        _pollOutstanding = true;
+    }
+}
+
+void CatBackend::service()
+{
+    bindQueries();
+    CatQuery::service(onFrame);
+
+    // split: the control socket only carries errors and radio chatter
+    if (_queries != &_link)
+    {
+        CatFrame f;
+        while (_link.receive(f))
+        {
+            if (f.op == CAT_OP_ZZTX && _rttPending && _rttDirect)
+            {
+                _rttPending = false;
+                addRttSample(millis() - _rttSentMs);
+                continue;
+            }
+            onFrame(f);
+        }
+    }
+
+    // The transport swapped in the standby socket: writes already go
+    // there, but AI is per connection, so switch it on again
+    uint32_t failovers = _link.failovers();
+    if (failovers != _failoversSeen)
+    {
+        _failoversSeen = failovers;
+        char line[64];
+        snprintf(line, sizeof(line), "[CAT] Primary lost; standby took over in %lu us.",
+                 (unsigned long)_link.lastFailoverUs());
+        log(RADIO_LOG_INFO, line);
+        if (_queries == &_link)
+        {
+            _autoInfo = false;
+            startSession();
+        }
+    }
+
+    // External changes: pushed by the radio (AI1), otherwise polled
+    if (_link.connected() && !_autoInfo)
+        poll();
+
+    if (_link.connected())
+    {
+        probeRtt();
+        adaptRate();
+    }
+}
+
+static void appendLink(String &out, const char *name, const CatTransport &link)
+{
+    out += name;
+    out += ": packets=" + String(link.packetsSent());
+    out += " writes=" + String(link.socketWrites());
+    out += " frames_in=" + String(link.framesReceived());
+    out += " tx_dropped=" + String(link.txDropped());
+    out += " rx_dropped=" + String(link.rxDropped());
+    out += "\n";
+
+    static const char *const LANE_NAMES[CAT_LANE_COUNT] = {"interactive", "background"};
+    for (uint8_t l = 0; l < CAT_LANE_COUNT; l++)
+    {
+        const CatLaneStats &st = link.laneStats((CatLane)l);
+        if (!st.packets && !st.dropped)
+            continue;
+        out += "  lane ";
+        out += LANE_NAMES[l];
+        out += ": packets=" + String(st.packets);
+        out += " dropped=" + String(st.dropped);
+        out += " queued last/avg/max=" + String(st.lastUs) + "/" + String(st.avgUs) + "/" +
+               String(st.maxUs) + "us\n";
+    }
+    const CatLaneStats &ptt = link.pttStats();
+    if (ptt.packets)
+        out += "  ptt: writes=" + String(ptt.packets) + " queued last/avg/max=" + String(ptt.lastUs) +
+               "/" + String(ptt.avgUs) + "/" + String(ptt.maxUs) + "us\n";
+}
+
+void CatBackend::appendStats(String &out) const
+{
+    appendLink(out, _queryPort ? "control" : "transport", _link);
+    if (_queryPort)
+    {
+        appendLink(out, "queries", _queryLink);
+        out += "query port " + String(_queryPort);
+        out += _queries == &_queryLink ? " (in use)\n" : " (down, queries on control)\n";
+    }
+    out += "scheduler: sent=" + String(_sched.sent());
+    out += " coalesced=" + String(_sched.coalesced());
+    out += " dropped=" + String(_sched.dropped());
+    out += " batches=" + String(_sched.batches());
+    out += "\nrate: interval=" + String(_sched.tickMs()) + "ms";
+    out += " bounds=" + String(_minTickMs) + ".." + String(_maxTickMs) + "ms";
+    out += " rtt=" + String(_rttMs) + "ms floor=" + String(_rttFloorMs) + "ms";
+    out += " samples=" + String(_rttSamples);
+    out += " backoffs=" + String(_backoffs);
+    out += " write avg/max=" + String(_link.writeAvgUs()) + "/" + String(_link.writeMaxUs()) + "us";
+    out += "\nFA intervals:";
+    for (uint8_t b = 0; b < CatScheduler::FA_HIST_BUCKETS; b++)
+    {
+        out += b < CatScheduler::FA_HIST_BUCKETS - 1
+                   ? " <" + String(CatScheduler::FA_HIST_EDGES_MS[b]) + "ms="
+                   : String(" <1s=");
+        out += String(_sched.faHistogram(b));
+    }
+    out += "\nemergency un-keys=" + String(_link.emergencyUnkeys());
+    out += "\nstandby: ";
+    out += _link.standbyUp() ? "up" : "down";
+    out += " keepalives=" + String(_link.keepalives());
+    out += " lost=" + String(_link.standbyLost());
+    out += " failovers=" + String(_link.failovers());
+    out += " last=" + String(_link.lastFailoverUs()) + "us";
+    out += " max=" + String(_link.maxFailoverUs()) + "us";
+    out += "\nexternal changes: ";
+    if (_autoInfo)
+        out += "auto-information (AI1)\n";
+    else
+        out += "adaptive polling (" + String(_polls) + " polls)\n";
+}
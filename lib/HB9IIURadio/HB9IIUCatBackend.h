@@ -0,0 +1,152 @@
+#pragma once
+#include <Arduino.h>
+#include "HB9IIURadioBackend.h"
+#include "HB9IIUCatTransport.h"
+#include "HB9IIUCatQuery.h"
+#include "HB9IIUCatScheduler.h"
+
+// Kenwood-style CAT through a SmartSDR CAT instance (TCP 5002 on the PC).
+// Socket in its own task (CatTransport), set-commands coalesced by
+// CatScheduler, queries pipelined by CatQuery. External changes arrive
+// via auto-information (AI1); if the CAT port refuses it, FA/MD/ZZFI/ZZAG
+// are polled - fast right after activity, slow when idle.
+//
+// Optionally (setQueryPort) queries, polls and auto-information use a
+// second CAT port with its own transport task, so a burst of replies or a
+// slow query never sits in front of the tuning writes. The control socket
+// then only carries FA/ZZAG/ZZFI/MD/ZZPC writes and ZZTX, with AI0 so no
+// reports or echoes come back on it. If the query port is down, queries
+// (and AI1) fall back to the control socket until it is back.
+//
+// The write spacing adapts (setRateBounds): a ZZTX; query every second on
+// the control socket (the one being paced) measures the CAT round trip,
+// never while a poll burst is in flight; the transport reports how long socket
+// writes block. Healthy: one write per RTT, never below the minimum.
+// Congested: back off by half again, up to the maximum.
+//
+// CatQuery has a single link, so there is one CatBackend per firmware.
+class CatBackend : public RadioBackend
+{
+public:
+    static const uint16_t DEFAULT_PORT = 5002;
+
+    static const uint32_t POLL_FAST_MS = 150;           // poll period right after activity
+    static const uint32_t POLL_SLOW_MS = 2000;          // poll period when idle
+    static const uint32_t POLL_ACTIVE_WINDOW_MS = 5000; // how long "right after" lasts
+    static const uint32_t POLL_TUNE_GUARD_MS = 250;     // no FA; polls while FA is being set
+    static const uint32_t QUERY_RETRY_MS = 5000;        // between query port reconnects
+    static const uint32_t QUERY_CONNECT_TIMEOUT_MS = 300;
+    static const uint32_t RTT_PROBE_MS = 1000;           // ZZTX; round-trip probe period
+    static const uint32_t RTT_TIMEOUT_MS = 1000;         // probe answer given up after this
+    static const uint32_t POLL_REPLY_MS = 1000;          // poll burst given up after this
+    static const uint32_t RATE_ADAPT_MS = 250;           // rate control period
+    static const uint32_t WRITE_CONGESTED_US = 5000;     // socket write blocking this long = send buffer full
+    static const uint32_t RTT_SLACK_MS = 20;             // RTT above 2 * floor + this = queueing on the path
+
+    // tickMs / burst / perSecond: see CatScheduler::begin()
+    CatBackend(uint16_t tickMs, uint8_t burst, uint16_t perSecond);
+
+    const char *name() const override { return "CAT"; }
+    uint16_t defaultPort() const override { return DEFAULT_PORT; }
+
+    void begin(RadioReportHandler onReport, RadioLogHandler onLog) override;
+
+    void beginConnect(const IPAddress &host, uint16_t port, uint32_t timeoutMs) override;
+    RadioConnectState pollConnect() override;
+    void stop() override
+    {
+        _link.stop();
+        _queryLink.stop();
+    }
+    bool connected() const override { return _link.connected(); }
+
+    void set(RadioParam param, int32_t value) override;
+    bool pending(RadioParam param) const override;
+    void cancel(RadioParam param) override;
+    bool tick(bool force) override;
+    bool setPtt(bool on) override;
+    bool emergencyUnkey() override { return _link.emergencyUnkey(); }
+    void setWake(TaskHandle_t task, uint32_t bits) override
+    {
+        _link.setWake(task, bits);
+        _queryLink.setWake(task, bits);
+    }
+
+    bool query(const RadioParam *params, uint8_t count, uint32_t timeoutMs,
+               RadioSnapshotHandler onDone) override;
+
+    bool setStandby(const IPAddress &host, uint16_t port) override;
+    bool standbyUp() const override { return _link.standbyUp(); }
+
+    void service() override;
+
+    bool pushesChanges() const override { return _autoInfo; }
+
+    // Separate CAT port for queries and reports (0 = share the control
+    // socket). Takes effect on the next connect; until the query socket is
+    // up, queries use the control socket.
+    void setQueryPort(uint16_t port) { _queryPort = port; }
+    uint16_t queryPort() const { return _queryPort; }
+
+    // Bounds for the adaptive write spacing; min == max keeps it fixed
+    void setRateBounds(uint16_t minMs, uint16_t maxMs);
+    void appendStats(String &out) const override;
+
+private:
+    static const uint8_t MAX_QUERIES = 4;
+
+    static void onAutoInfoReply(const CatFrame *reply);
+    static void onRttReply(const CatFrame *reply);
+    static void onFrame(const CatFrame &f);
+    static void onBatch(const CatBatch &b);
+
+    void log(RadioLogKind kind, const char *text, size_t len);
+    void log(RadioLogKind kind, const char *text) { log(kind, text, strlen(text)); }
+    void poll();
+    void startSession();
+    void bindQueries();
+    void probeRtt();
+    void addRttSample(uint32_t ms);
+    void adaptRate();
+
+    static CatBackend *_self; // CatQuery handlers carry no context
+
+    CatTransport _link;      // control: writes and PTT
+    CatTransport _queryLink; // queries and reports, if _queryPort is set
+    CatTransport *_queries = &_link; // where CatQuery is bound right now
+    uint16_t _queryPort = 0;
+    IPAddress _host;
+    uint32_t _connectTimeoutMs = 0;
+    bool _connecting = false; // beginConnect() waiting for the transport
+    uint32_t _queryTryMs = 0;
+    CatScheduler _sched;
+    uint16_t _tickMs;
+    uint8_t _burst;
+    uint16_t _perSecond;
+
+    RadioReportHandler _onReport = nullptr;
+    RadioLogHandler _onLog = nullptr;
+    RadioSnapshotHandler _snapshots[MAX_QUERIES] = {};
+
+    bool _autoInfo = false;         // radio accepted AI1
+    uint32_t _activityMs = 0;       // last local or external change
+    uint32_t _freqSetMs = 0;        // last set(RADIO_FREQ)
+    uint32_t _lastPollMs = 0;
+    bool _pollOutstanding = false;  // sent, ZZAG (last of the burst) not back yet
+    int32_t _seen[RADIO_PARAM_COUNT]; // last reported values (activity detection)
+    uint32_t _polls = 0;
+    uint32_t _failoversSeen = 0;
+
+    // rate control
+    uint16_t _minTickMs;
+    uint16_t _maxTickMs;
+    uint32_t _rttMs = 0;      // EWMA 1/4, 0 = no sample yet
+    uint32_t _rttFloorMs = 0; // slowly rising minimum (path without queueing)
+    uint32_t _rttSamples = 0;
+    uint32_t _rttSentMs = 0;
+    bool _rttPending = false;
+    bool _rttDirect = false;  // split: probe sent straight on _link, not via CatQuery
+    uint32_t _lastAdaptMs = 0;
+    uint32_t _writesSeen = 0;
+    uint32_t _backoffs = 0;
+};
@@ -0,0 +1,619 @@
+#include "HB9IIUFlexApiBackend.h"
+#include <string.h>
+#include <stdlib.h>
+
+// ───────── MODE / FILTER TABLES ─────────
+
+// MD code <-> SmartSDR mode name (first match wins when encoding)
+struct ApiMode
+{
+    uint8_t code;
+    const char *name;
+};
+static const ApiMode API_MODES[] = {
+    {1, "LSB"},
+    {2, "USB"},
+    {3, "CW"},
+    {4, "FM"},
+    {5, "AM"},
+    {6, "DIGL"},
+    {9, "DIGU"},
+    {5, "SAM"},
+    {4, "NFM"},
+    {4, "DFM"},
+    {4, "FDV"},
+    {6, "RTTY"},
+};
+static const size_t NUM_API_MODES = sizeof(API_MODES) / sizeof(API_MODES[0]);
+
+static const char *modeName(int32_t code)
+{
+    for (size_t i = 0; i < NUM_API_MODES; i++)
+        if (API_MODES[i].code == code)
+            return API_MODES[i].name;
+    return nullptr;
+}
+
+static int32_t modeCode(const char *name)
+{
+    for (size_t i = 0; i < NUM_API_MODES; i++)
+        if (strcmp(API_MODES[i].name, name) == 0)
+            return API_MODES[i].code;
+    return -1;
+}
+
+// SmartSDR's default filter buttons (Hz), narrow to wide = preset 0..7.
+// Edit these if you changed the buttons in SmartSDR.
+static const uint16_t FILTER_SSB[8] = {1600, 1800, 2100, 2400, 2700, 2900, 3300, 4000};
+static const uint16_t FILTER_CW[8] = {50, 100, 250, 400, 500, 800, 1000, 3000};
+static const uint16_t FILTER_DIG[8] = {100, 300, 600, 1000, 1500, 2000, 3000, 6000};
+static const uint16_t FILTER_AMFM[8] = {5600, 6000, 8000, 10000, 12000, 14000, 16000, 20000};
+static const int32_t SSB_LOW_CUT_HZ = 100;
+
+static const uint16_t *filterTable(int32_t code)
+{
+    switch (code)
+    {
+    case 3:
+        return FILTER_CW;
+    case 6:
+    case 9:
+        return FILTER_DIG;
+    case 4:
+    case 5:
+        return FILTER_AMFM;
+    default:
+        return FILTER_SSB;
+    }
+}
+
+// preset -> filter edges relative to the slice frequency
+static void filterEdges(int32_t code, uint8_t preset, int32_t &lo, int32_t &hi)
+{
+    int32_t w = filterTable(code)[preset & 7];
+    switch (code)
+    {
+    case 1: // LSB
+    case 6: // DIGL
+        lo = -(SSB_LOW_CUT_HZ + w);
+        hi = -SSB_LOW_CUT_HZ;
+        break;
+    case 2: // USB
+    case 9: // DIGU
+        lo = SSB_LOW_CUT_HZ;
+        hi = SSB_LOW_CUT_HZ + w;
+        break;
+    default: // CW / AM / FM: centred
+        lo = -w / 2;
+        hi = w - w / 2;
+        break;
+    }
+}
+
+// filter edges -> nearest preset for this mode
+static int32_t filterPreset(int32_t code, int32_t lo, int32_t hi)
+{
+    const uint16_t *table = filterTable(code);
+    int32_t w = hi - lo;
+    int32_t best = 0;
+    int32_t bestDiff = 0x7fffffff;
+    for (int32_t i = 0; i < 8; i++)
+    {
+        int32_t d = abs(w - (int32_t)table[i]);
+        if (d < bestDiff)
+        {
+            bestDiff = d;
+            best = i;
+        }
+    }
+    return best;
+}
+
+// "14.074000" (MHz) -> 14074000 (Hz), without floating point
+static int32_t parseMhz(const char *s)
+{
+    int32_t mhz = 0;
+    while (*s >= '0' && *s <= '9')
+        mhz = mhz * 10 + (*s++ - '0');
+    int32_t frac = 0;
+    int digits = 0;
+    if (*s == '.')
+    {
+        s++;
+        while (*s >= '0' && *s <= '9' && digits < 6)
+        {
+            frac = frac * 10 + (*s++ - '0');
+            digits++;
+        }
+    }
+    while (digits++ < 6)
+        frac *= 10;
+    return mhz * 1000000 + frac;
+}
+
+// ───────── BACKEND ─────────
+
+FlexApiBackend::FlexApiBackend(uint16_t tickMs, uint8_t slice)
+    : _tickMs(tickMs), _slice(slice)
+{
+}
+
+void FlexApiBackend::begin(RadioReportHandler onReport, RadioLogHandler onLog)
+{
+    _onReport = onReport;
+    _onLog = onLog;
+
+    // API transport task owns the socket from here on
+    _link.begin();
+}
+
+void FlexApiBackend::log(RadioLogKind kind, const char *text, size_t len)
+{
+    if (_onLog)
+        _onLog(kind, text, len);
+}
+
+void FlexApiBackend::beginConnect(const IPAddress &host, uint16_t port, uint32_t timeoutMs)
+{
+    stop();
+
+    // unsent values and everything we knew belong to the old link
+    for (uint8_t i = 0; i < RADIO_PARAM_COUNT; i++)
+    {
+        _dirty[i] = false;
+        _valid[i] = false;
+    }
+    _state = LINE_START;
+    _outLen = 0;
+
+    _connecting = true;
+    _link.requestConnect(host, port, timeoutMs); // the transport task does the waiting
+}
+
+RadioConnectState FlexApiBackend::pollConnect()
+{
+    if (!_connecting)
+        return connected() ? RADIO_CONNECT_UP : RADIO_CONNECT_FAILED;
+    ApiTransport::State st = _link.state();
+    if (st == ApiTransport::CONNECTING)
+        return RADIO_CONNECT_PENDING;
+    _connecting = false;
+    if (st != ApiTransport::CONNECTED)
+        return RADIO_CONNECT_FAILED;
+    _up = true;
+
+    // the radio answers with a full status dump, then pushes every change
+    queue("sub slice all");
+    queue("sub tx all");
+    if (flushOut())
+        return RADIO_CONNECT_UP;
+    stop();
+    return RADIO_CONNECT_FAILED;
+}
+
+void FlexApiBackend::stop()
+{
+    _link.stop();
+    _connecting = false;
+    _up = false;
+}
+
+void FlexApiBackend::set(RadioParam param, int32_t value)
+{
+    if (param >= RADIO_PARAM_COUNT || value < 0)
+        return;
+    _value[param] = value;
+    _dirty[param] = true;
+}
+
+void FlexApiBackend::cancel(RadioParam param)
+{
+    if (param < RADIO_PARAM_COUNT)
+        _dirty[param] = false;
+}
+
+// "C<seq>|<cmd>\n" into the outgoing buffer
+bool FlexApiBackend::queue(const char *cmd)
+{
+    // the sequence number is only used up once the command fits (checked
+    // at the widest number, the watchdog may take one in between)
+    if (_outLen + strlen(cmd) + 12 + 1 >= OUT_SIZE)
+        return false;
+    int n = snprintf(_out + _outLen, OUT_SIZE - _outLen, "C%u|%s", (unsigned)++_seq, cmd);
+    if (n <= 0)
+        return false;
+    log(RADIO_LOG_TX, _out + _outLen, n);
+    _outLen += n;
+    _out[_outLen++] = '\n';
+    _commands++;
+    return true;
+}
+
+bool FlexApiBackend::flushOut()
+{
+    if (_outLen == 0)
+        return false;
+    size_t len = _outLen;
+    _outLen = 0;
+    return _up && _link.send(_out, len); // the transport task writes it
+}
+
+bool FlexApiBackend::queueParam(RadioParam param, int32_t value)
+{
+    char cmd[48];
+    switch (param)
+    {
+    case RADIO_FREQ:
+        snprintf(cmd, sizeof(cmd), "slice tune %u %u.%06u", _slice,
+                 (unsigned)(value / 1000000), (unsigned)(value % 1000000));
+        break;
+    case RADIO_MODE:
+    {
+        const char *name = modeName(value);
+        if (!name)
+            return true; // no such mode in the API: drop it
+        snprintf(cmd, sizeof(cmd), "slice set %u mode=%s", _slice, name);
+        if (!queue(cmd))
+            return false;
+        _modeCode = value;
+        return true;
+    }
+    case RADIO_FILTER:
+    {
+        // edges depend on the mode (tick() queues a mode change first)
+        int32_t lo, hi;
+        filterEdges(_modeCode, (uint8_t)value, lo, hi);
+        snprintf(cmd, sizeof(cmd), "filt %u %d %d", _slice, (int)lo, (int)hi);
+        break;
+    }
+    case RADIO_AFGAIN:
+        snprintf(cmd, sizeof(cmd), "slice set %u %s=%d", _slice, _audioKey, (int)value);
+        break;
+    case RADIO_POWER:
+        snprintf(cmd, sizeof(cmd), "transmit set rfpower=%d", (int)value);
+        break;
+    default:
+        return false;
+    }
+    return queue(cmd);
+}
+
+bool FlexApiBackend::tick(bool force)
+{
+    if (!force && millis() - _lastTick < _tickMs)
+        return false;
+    if (!_up)
+        return false;
+
+    // mode first, so the filter edges below already match it
+    static const RadioParam ORDER[RADIO_PARAM_COUNT] = {
+        RADIO_MODE, RADIO_FREQ, RADIO_FILTER, RADIO_AFGAIN, RADIO_POWER};
+    bool any = false;
+    for (uint8_t i = 0; i < RADIO_PARAM_COUNT; i++)
+    {
+        RadioParam p = ORDER[i];
+        if (!_dirty[p])
+            continue;
+        if (!queueParam(p, _value[p]))
+            break; // buffer full: the rest stays dirty for the next tick
+        _dirty[p] = false;
+        _sent.note(p, _value[p]);
+        any = true;
+    }
+    if (!any)
+        return false;
+
+    _lastTick = millis();
+    return flushOut();
+}
+
+bool FlexApiBackend::setPtt(bool on)
+{
+    if (!_up)
+        return false;
+
+    // Queued mode/power changes (e.g. TUNE prep) must land before we key;
+    // never key with them still unsent
+    if (on)
+    {
+        tick(true);
+        if (_dirty[RADIO_MODE] || _dirty[RADIO_POWER])
+            return false;
+    }
+
+    // not through _out: the transport's PTT slot puts an un-key ahead of
+    // every queued write and a key behind them
+    uint32_t seq = ++_seq;
+    char cmd[24];
+    int n = snprintf(cmd, sizeof(cmd), "C%u|xmit %u", (unsigned)seq, on ? 1u : 0u);
+    log(RADIO_LOG_TX, cmd, n);
+    _commands++;
+    return _link.setPtt(on, seq);
+}
+
+bool FlexApiBackend::query(const RadioParam *params, uint8_t count, uint32_t timeoutMs,
+                           RadioSnapshotHandler onDone)
+{
+    if (!_up || count == 0)
+        return false;
+
+    for (uint8_t i = 0; i < MAX_QUERIES; i++)
+    {
+        Query &q = _queries[i];
+        if (q.onDone)
+            continue;
+        q.mask = 0;
+        for (uint8_t k = 0; k < count; k++)
+            if (params[k] < RADIO_PARAM_COUNT)
+                q.mask |= 1u << params[k];
+        q.startMs = millis();
+        q.deadline = q.startMs + timeoutMs;
+        q.onDone = onDone; // answered from the status cache in service()
+        return true;
+    }
+    return false;
+}
+
+void FlexApiBackend::serviceQueries()
+{
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < MAX_QUERIES; i++)
+    {
+        Query &q = _queries[i];
+        if (!q.onDone)
+            continue;
+
+        bool complete = true;
+        for (uint8_t p = 0; p < RADIO_PARAM_COUNT; p++)
+            if ((q.mask & (1u << p)) && !_valid[p])
+                complete = false;
+        if (!complete && (int32_t)(now - q.deadline) < 0)
+            continue;
+
+        RadioSnapshot s;
+        for (uint8_t p = 0; p < RADIO_PARAM_COUNT; p++)
+        {
+            s.valid[p] = (q.mask & (1u << p)) && _valid[p];
+            s.value[p] = s.valid[p] ? _cache[p] : -1;
+        }
+        s.elapsedMs = now - q.startMs;
+
+        RadioSnapshotHandler onDone = q.onDone;
+        q.onDone = nullptr; // free first: the handler may query again
+        onDone(s);
+    }
+}
+
+void FlexApiBackend::service()
+{
+    if (_up && !_link.connected())
+    {
+        _up = false;
+        log(RADIO_LOG_INFO, "[API] Connection closed by radio.");
+    }
+
+    // bytes the transport task read; never touches the socket itself
+    size_t budget = READ_BUDGET;
+    ApiRxChunk c;
+    while (_up && budget > 0 && _link.receive(c))
+    {
+        feed(c.data, c.len);
+        budget -= c.len < budget ? c.len : budget;
+    }
+
+    serviceQueries();
+}
+
+// ───────── INCOMING PARSER ─────────
+
+void FlexApiBackend::feed(const char *data, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+        feed(data[i]);
+}
+
+void FlexApiBackend::feed(char c)
+{
+    if (c == '\r')
+        return;
+    if (c == '\n')
+    {
+        if (_state == TOKENS)
+            endToken();
+        else if (_state == REPLY_CODE)
+            onReply(_replySeq, _replyCode);
+        endLine();
+        return;
+    }
+
+    switch (_state)
+    {
+    case LINE_START:
+        if (c == 'R')
+        {
+            _replySeq = 0;
+            _state = REPLY_SEQ;
+        }
+        else if (c == 'S')
+            _state = STATUS_HDR;
+        else
+            _state = SKIP; // V<version>, H<handle>, M<message>
+        break;
+
+    case REPLY_SEQ:
+        if (c >= '0' && c <= '9')
+            _replySeq = _replySeq * 10 + (c - '0');
+        else if (c == '|')
+        {
+            _replyCode = 0;
+            _state = REPLY_CODE;
+        }
+        else
+            _state = SKIP;
+        break;
+
+    case REPLY_CODE:
+        if (c == '|')
+        {
+            onReply(_replySeq, _replyCode);
+            _state = SKIP;
+        }
+        else
+        {
+            uint8_t d = (c >= '0' && c <= '9') ? c - '0' : ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') ? (c | 0x20) - 'a' + 10 : 0;
+            _replyCode = (_replyCode << 4) | d;
+        }
+        break;
+
+    case STATUS_HDR:
+        if (c == '|')
+        {
+            _obj = OBJ_NONE;
+            _sliceIdxSeen = false;
+            _filterSeen = false;
+            _tokLen = 0;
+            _tokTruncated = false;
+            _statusLines++;
+            _state = TOKENS;
+        }
+        break;
+
+    case TOKENS:
+        if (c == ' ')
+            endToken();
+        else if (_tokLen < TOKEN_SIZE - 1)
+            _tok[_tokLen++] = c;
+        else
+            _tokTruncated = true;
+        break;
+
+    case SKIP:
+        break;
+    }
+}
+
+void FlexApiBackend::endToken()
+{
+    if (_tokLen == 0)
+        return;
+    _tok[_tokLen] = '\0';
+    _tokLen = 0;
+    if (_tokTruncated)
+    {
+        _tokTruncated = false;
+        _truncated++;
+        return; // a value we can't trust; none of ours are this long
+    }
+
+    if (_obj == OBJ_IGNORED)
+        return;
+    if (_obj == OBJ_NONE)
+    {
+        if (strcmp(_tok, "slice") == 0)
+            _obj = OBJ_SLICE;
+        else if (strcmp(_tok, "transmit") == 0)
+            _obj = OBJ_TRANSMIT;
+        else
+            _obj = OBJ_IGNORED;
+        return;
+    }
+
+    char *eq = strchr(_tok, '=');
+    if (!eq)
+    {
+        // "slice <n>": only our slice is interesting
+        if (_obj == OBJ_SLICE && !_sliceIdxSeen)
+        {
+            _sliceIdxSeen = true;
+            if (atoi(_tok) != _slice)
+                _obj = OBJ_IGNORED;
+        }
+        return;
+    }
+    *eq = '\0';
+    onStatus(_tok, eq + 1);
+}
+
+void FlexApiBackend::endLine()
+{
+    // filter_lo / filter_hi may come in any order: map once the line is done
+    if (_filterSeen && _obj == OBJ_SLICE)
+        update(RADIO_FILTER, filterPreset(_modeCode, _filterLo, _filterHi));
+    _filterSeen = false;
+    _state = LINE_START;
+}
+
+void FlexApiBackend::onReply(uint32_t seq, uint32_t code)
+{
+    if (code == 0)
+        return;
+    _errors++;
+    char msg[48];
+    snprintf(msg, sizeof(msg), "[API] C%u failed: 0x%08X", (unsigned)seq, (unsigned)code);
+    log(RADIO_LOG_INFO, msg);
+}
+
+void FlexApiBackend::onStatus(const char *key, const char *value)
+{
+    if (_obj == OBJ_SLICE)
+    {
+        if (strcmp(key, "RF_frequency") == 0)
+            update(RADIO_FREQ, parseMhz(value));
+        else if (strcmp(key, "mode") == 0)
+        {
+            int32_t code = modeCode(value);
+            if (code >= 0)
+            {
+                _modeCode = code;
+                update(RADIO_MODE, code);
+            }
+        }
+        else if (strcmp(key, "filter_lo") == 0)
+        {
+            _filterLo = atoi(value);
+            _filterSeen = true;
+        }
+        else if (strcmp(key, "filter_hi") == 0)
+        {
+            _filterHi = atoi(value);
+            _filterSeen = true;
+        }
+        else if (strcmp(key, "audio_level") == 0)
+            update(RADIO_AFGAIN, atoi(value));
+        else if (strcmp(key, "audio_gain") == 0)
+        {
+            _audioKey = "audio_gain";
+            update(RADIO_AFGAIN, atoi(value));
+        }
+    }
+    else if (_obj == OBJ_TRANSMIT)
+    {
+        if (strcmp(key, "rfpower") == 0)
+            update(RADIO_POWER, atoi(value));
+    }
+}
+
+void FlexApiBackend::update(RadioParam param, int32_t value)
+{
+    if (_valid[param] && _cache[param] == value)
+        return;
+    _cache[param] = value;
+    _valid[param] = true;
+    if (_onReport)
+        _onReport(param, value);
+}
+
+void FlexApiBackend::appendStats(String &out) const
+{
+    out += "api: commands=" + String(_commands);
+    out += " writes=" + String(_link.socketWrites());
+    out += " tx_dropped=" + String(_link.txDropped());
+    out += " rx_bytes=" + String(_link.bytesReceived());
+    out += " errors=" + String(_errors);
+    out += " status_lines=" + String(_statusLines);
+    out += " truncated=" + String(_truncated);
+    out += "\nsocket write avg/max=" + String(_link.writeAvgUs()) + "/" + String(_link.writeMaxUs()) + "us";
+    out += " queued avg/max=" + String(_link.queuedAvgUs()) + "/" + String(_link.queuedMaxUs()) + "us";
+    out += "\nemergency un-keys=" + String(_link.emergencyUnkeys());
+    out += "\nexternal changes: status subscription\n";
+}
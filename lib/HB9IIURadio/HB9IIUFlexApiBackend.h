@@ -0,0 +1,147 @@
+#pragma once
+#include <Arduino.h>
+#include <atomic>
+#include "HB9IIURadioBackend.h"
+#include "HB9IIUApiTransport.h"
+
+// Native SmartSDR TCP API (port 4992 on the radio itself, no PC hop).
+// Commands go out as "C<seq>|slice tune 0 14.074000\n", the radio answers
+// "R<seq>|<hex code>|..." and, after "sub slice all" / "sub tx all",
+// pushes "S<handle>|slice 0 RF_frequency=... mode=USB ..." status lines.
+// Status is parsed token by token straight off the socket into a value
+// cache, so queries are answered locally and nothing is ever polled.
+// The socket lives in its own task (ApiTransport); the loop only queues
+// writes and parses the bytes the task hands over.
+//
+// Values keep the CAT conventions (MD codes, filter preset 0..7); the
+// preset index is mapped to filter edges with SmartSDR's default
+// filter buttons for the current mode.
+class FlexApiBackend : public RadioBackend
+{
+public:
+    static const uint16_t DEFAULT_PORT = 4992;
+
+    // tickMs: minimum spacing between writes; slice: which slice we drive
+    FlexApiBackend(uint16_t tickMs, uint8_t slice = 0);
+
+    const char *name() const override { return "API"; }
+    uint16_t defaultPort() const override { return DEFAULT_PORT; }
+
+    void begin(RadioReportHandler onReport, RadioLogHandler onLog) override;
+
+    void beginConnect(const IPAddress &host, uint16_t port, uint32_t timeoutMs) override;
+    RadioConnectState pollConnect() override;
+    void stop() override;
+    bool connected() const override { return _up && _link.connected(); }
+
+    void set(RadioParam param, int32_t value) override;
+    bool pending(RadioParam param) const override { return param < RADIO_PARAM_COUNT && _dirty[param]; }
+    void cancel(RadioParam param) override;
+    bool tick(bool force) override;
+    bool setPtt(bool on) override;
+    // "xmit 0" straight into the transport's PTT slot; safe from the TX
+    // watchdog's timer task
+    bool emergencyUnkey() override { return _link.emergencyUnkey(++_seq); }
+
+    bool query(const RadioParam *params, uint8_t count, uint32_t timeoutMs,
+               RadioSnapshotHandler onDone) override;
+
+    void service() override;
+    void setWake(TaskHandle_t task, uint32_t bits) override { _link.setWake(task, bits); }
+
+    // Parse received API bytes (service() feeds the socket data through it)
+    void feed(const char *data, size_t len);
+
+    bool pushesChanges() const override { return true; }
+    void appendStats(String &out) const override;
+
+private:
+    static const uint8_t MAX_QUERIES = 2;
+    static const size_t OUT_SIZE = 256;
+    static const size_t TOKEN_SIZE = 40;
+    static const size_t READ_BUDGET = 1024; // bytes parsed per service() call (rest waits in the ring)
+
+    enum LineState : uint8_t
+    {
+        LINE_START, // first byte tells the line type
+        REPLY_SEQ,  // "R<seq>|"
+        REPLY_CODE, // "<hex code>|"
+        STATUS_HDR, // "S<handle>|"
+        TOKENS,     // status body, space separated
+        SKIP        // ignore the rest of the line
+    };
+
+    enum StatusObj : uint8_t
+    {
+        OBJ_NONE,     // object name not seen yet
+        OBJ_SLICE,    // "slice <n> ..."
+        OBJ_TRANSMIT, // "transmit ..."
+        OBJ_IGNORED   // other objects / other slices
+    };
+
+    struct Query
+    {
+        RadioSnapshotHandler onDone;
+        uint8_t mask; // bit per RadioParam
+        uint32_t startMs;
+        uint32_t deadline;
+    };
+
+    void log(RadioLogKind kind, const char *text, size_t len);
+    void log(RadioLogKind kind, const char *text) { log(kind, text, strlen(text)); }
+    bool queue(const char *cmd);
+    bool flushOut();
+    bool queueParam(RadioParam param, int32_t value);
+
+    void feed(char c);
+    void endToken();
+    void endLine();
+    void onReply(uint32_t seq, uint32_t code);
+    void onStatus(const char *key, const char *value);
+    void update(RadioParam param, int32_t value);
+    void serviceQueries();
+
+    ApiTransport _link;
+    bool _connecting = false; // beginConnect() waiting for the transport
+    bool _up = false;         // connected and subscribed
+    uint16_t _tickMs;
+    uint8_t _slice;
+    uint32_t _lastTick = 0;
+    std::atomic<uint32_t> _seq{0}; // the TX watchdog takes numbers too
+
+    RadioReportHandler _onReport = nullptr;
+    RadioLogHandler _onLog = nullptr;
+    Query _queries[MAX_QUERIES] = {};
+
+    // outgoing: every command of one tick goes out in one write
+    char _out[OUT_SIZE];
+    size_t _outLen = 0;
+
+    // set() values waiting for the next tick
+    int32_t _value[RADIO_PARAM_COUNT] = {};
+    bool _dirty[RADIO_PARAM_COUNT] = {};
+
+    // last values the radio reported
+    int32_t _cache[RADIO_PARAM_COUNT] = {};
+    bool _valid[RADIO_PARAM_COUNT] = {};
+    int32_t _modeCode = 2;                 // mode the filter presets refer to (USB until told)
+    const char *_audioKey = "audio_level"; // "audio_gain" on older firmware
+
+    // incremental line parser
+    LineState _state = LINE_START;
+    StatusObj _obj = OBJ_NONE;
+    bool _sliceIdxSeen = false;
+    uint32_t _replySeq = 0;
+    uint32_t _replyCode = 0;
+    char _tok[TOKEN_SIZE];
+    uint8_t _tokLen = 0;
+    bool _tokTruncated = false;
+    bool _filterSeen = false;
+    int32_t _filterLo = 0;
+    int32_t _filterHi = 0;
+
+    uint32_t _commands = 0;
+    uint32_t _errors = 0;
+    uint32_t _statusLines = 0;
+    uint32_t _truncated = 0;
+};
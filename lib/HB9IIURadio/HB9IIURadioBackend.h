@@ -0,0 +1,170 @@
+#pragma once
+#include <Arduino.h>
+#include <IPAddress.h>
+
+// Radio settings every backend understands. Values keep the CAT
+// conventions the UI already speaks, whatever goes over the wire.
+enum RadioParam : uint8_t
+{
+    RADIO_FREQ = 0, // VFO / slice frequency (Hz)
+    RADIO_MODE,     // Kenwood/Flex MD code (1 = LSB, 2 = USB, 3 = CW, ...)
+    RADIO_FILTER,   // filter preset 0..7
+    RADIO_AFGAIN,   // AF gain 0..100
+    RADIO_POWER,    // RF power 0..100
+    RADIO_PARAM_COUNT
+};
+
+// Answer to RadioBackend::query(): the values that came back in time
+struct RadioSnapshot
+{
+    bool valid[RADIO_PARAM_COUNT];
+    int32_t value[RADIO_PARAM_COUNT];
+    uint32_t elapsedMs; // query -> answer (or deadline)
+
+    bool has(RadioParam p) const { return valid[p]; }
+    int32_t get(RadioParam p, int32_t fallback = -1) const { return valid[p] ? value[p] : fallback; }
+    // true if every requested value is present
+    bool complete(const RadioParam *params, uint8_t count) const
+    {
+        for (uint8_t i = 0; i < count; i++)
+            if (!valid[params[i]])
+                return false;
+        return true;
+    }
+};
+
+// A value the radio reported on its own (changed in SmartSDR, poll answer, ...)
+typedef void (*RadioReportHandler)(RadioParam param, int32_t value);
+// Answer to a query()
+typedef void (*RadioSnapshotHandler)(const RadioSnapshot &snapshot);
+// What a log call carries: raw traffic either way, or a status line
+enum RadioLogKind : uint8_t
+{
+    RADIO_LOG_INFO = 0, // "[CAT] ...", "[API] ..."
+    RADIO_LOG_TX,       // bytes as written to the radio
+    RADIO_LOG_RX        // bytes as received (one frame / line)
+};
+// Log text for Serial / web console; text is not NUL terminated and only
+// valid during the call
+typedef void (*RadioLogHandler)(RadioLogKind kind, const char *text, size_t len);
+
+// The last values a backend actually put on the wire, per setting, with
+// their send time. A report matching one of them is a late echo of our
+// own write, not a change made elsewhere. Recorded at write time, so a
+// spinning knob's many set() calls per tick never push a sent value out.
+class RadioSentLog
+{
+public:
+    static const uint8_t DEPTH = 16; // >= echo round trip / fastest write spacing
+
+    void note(RadioParam p, int32_t value)
+    {
+        uint32_t now = millis();
+        uint8_t &h = _head[p];
+        _value[p][h] = value;
+        _atMs[p][h] = now ? now : 1;
+        h = (h + 1) % DEPTH;
+    }
+
+    bool contains(RadioParam p, int32_t value, uint32_t windowMs) const
+    {
+        uint32_t now = millis();
+        for (uint8_t k = 0; k < DEPTH; k++)
+            if (_atMs[p][k] && _value[p][k] == value && now - _atMs[p][k] <= windowMs)
+                return true;
+        return false;
+    }
+
+private:
+    int32_t _value[RADIO_PARAM_COUNT][DEPTH] = {};
+    uint32_t _atMs[RADIO_PARAM_COUNT][DEPTH] = {}; // 0 = empty
+    uint8_t _head[RADIO_PARAM_COUNT] = {};
+};
+
+// Progress of a beginConnect()
+enum RadioConnectState : uint8_t
+{
+    RADIO_CONNECT_PENDING,
+    RADIO_CONNECT_UP,
+    RADIO_CONNECT_FAILED
+};
+
+// One way of talking to the radio (SmartSDR CAT, native TCP API, ...).
+// Everything is loop-side and non-blocking except connect(); handlers
+// only ever run from inside service().
+class RadioBackend
+{
+public:
+    virtual ~RadioBackend() {}
+
+    virtual const char *name() const = 0; // short tag for logs ("CAT", "API")
+    virtual uint16_t defaultPort() const = 0;
+
+    // Call once from setup()
+    virtual void begin(RadioReportHandler onReport, RadioLogHandler onLog) = 0;
+
+    // Start a connect and return at once; unsent values from a previous
+    // link are discarded. Call pollConnect() until it is no longer PENDING;
+    // on UP the session is started (change reports, subscriptions).
+    virtual void beginConnect(const IPAddress &host, uint16_t port, uint32_t timeoutMs) = 0;
+    virtual RadioConnectState pollConnect() = 0;
+
+    // Blocking connect (boot only: the loop is dead meanwhile)
+    bool connect(const IPAddress &host, uint16_t port, uint32_t timeoutMs)
+    {
+        beginConnect(host, port, timeoutMs);
+        RadioConnectState s;
+        while ((s = pollConnect()) == RADIO_CONNECT_PENDING)
+            delay(2);
+        return s == RADIO_CONNECT_UP;
+    }
+    virtual void stop() = 0;
+    virtual bool connected() const = 0;
+
+    // Newest value wins; it goes out with a later tick()
+    virtual void set(RadioParam param, int32_t value) = 0;
+    // true while a set() value has not been written yet
+    virtual bool pending(RadioParam param) const = 0;
+    // Forget an unsent value (the radio just told us something newer)
+    virtual void cancel(RadioParam param) = 0;
+    // Write pending values (force: ignore the tick spacing); true if a write went out
+    virtual bool tick(bool force) = 0;
+
+    // PTT skips the queue; pending values are flushed first so they land before keying
+    virtual bool setPtt(bool on) = 0;
+    // Un-key from another task (TX watchdog) while loop() may be stuck.
+    // false if the backend has no path that bypasses the loop.
+    virtual bool emergencyUnkey() { return false; }
+
+    // Ask for current values; onDone fires once from service(), with
+    // whatever arrived before timeoutMs. false if it could not be issued.
+    virtual bool query(const RadioParam *params, uint8_t count, uint32_t timeoutMs,
+                       RadioSnapshotHandler onDone) = 0;
+
+    // Optional second, idle link the backend can switch to without a
+    // reconnect when the primary dies (port 0: off). false if unsupported.
+    virtual bool setStandby(const IPAddress &host, uint16_t port) { return false; }
+    virtual bool standbyUp() const { return false; }
+
+    // Call every loop(): drains incoming data and fires the handlers
+    virtual void service() = 0;
+    // `value` went out to the radio within the last windowMs: a late echo
+    // of our own write (the knob has moved on since), not an external change
+    bool sentRecently(RadioParam p, int32_t value, uint32_t windowMs) const
+    {
+        return p < RADIO_PARAM_COUNT && _sent.contains(p, value, windowMs);
+    }
+
+    // Notify task (eSetBits) when there is something for service(). Backends
+    // that read their socket from service() itself ignore it: poll them.
+    virtual void setWake(TaskHandle_t task, uint32_t bits) {}
+
+    // true if the radio pushes changes by itself (nothing is polled)
+    virtual bool pushesChanges() const = 0;
+
+    // Counter lines for /stats
+    virtual void appendStats(String &out) const = 0;
+
+protected:
+    RadioSentLog _sent; // note() every value when it is written, not when it is set()
+};
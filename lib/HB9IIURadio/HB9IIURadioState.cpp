@@ -0,0 +1,137 @@
+#include "HB9IIURadioState.h"
+
+static const char *const PARAM_NAMES[RADIO_PARAM_COUNT] = {
+    "freq", "mode", "filter", "afgain", "power"};
+
+RadioState::RadioState()
+{
+    for (uint8_t i = 0; i < RADIO_PARAM_COUNT; i++)
+    {
+        _f[i].desired = -1;
+        _f[i].confirmed = -1;
+        _f[i].version = 0;
+        _f[i].confirmedAtMs = 0;
+        _f[i].wantedAtMs = 0;
+        _f[i].settleLastMs = 0;
+        _f[i].settleMaxMs = 0;
+        _f[i].settleSumMs = 0;
+        _f[i].settleCount = 0;
+        _f[i].replay = false;
+    }
+}
+
+bool RadioState::want(RadioParam p, int32_t value)
+{
+    RadioField &f = _f[p];
+    if (f.desired == value)
+        return false;
+    f.desired = value;
+    f.version++;
+
+    uint32_t now = millis();
+    f.wantedAtMs = now ? now : 1;
+    if (_linkDown)
+        f.replay = true;
+    return true;
+}
+
+void RadioState::confirm(RadioParam p, int32_t value)
+{
+    RadioField &f = _f[p];
+    f.confirmedAtMs = millis();
+    if (f.confirmedAtMs == 0)
+        f.confirmedAtMs = 1; // 0 means "never"
+
+    // first report of the value we last asked for: the change has settled
+    if (f.wantedAtMs && value == f.desired)
+    {
+        uint32_t ms = f.confirmedAtMs - f.wantedAtMs;
+        f.wantedAtMs = 0;
+        f.settleLastMs = ms;
+        if (ms > f.settleMaxMs)
+            f.settleMaxMs = ms;
+        f.settleSumMs += ms;
+        f.settleCount++;
+    }
+
+    if (f.confirmed == value)
+        return;
+    f.confirmed = value;
+    f.version++;
+}
+
+void RadioState::adopt(RadioParam p, int32_t value)
+{
+    RadioField &f = _f[p];
+    if (f.desired != value)
+    {
+        f.desired = value; // not ours: no echo window, no settle sample
+        f.version++;
+    }
+    f.wantedAtMs = 0;
+    confirm(p, value);
+}
+
+bool RadioState::fresh(RadioParam p, uint32_t maxAgeMs) const
+{
+    const RadioField &f = _f[p];
+    return f.known() && f.confirmedAtMs != 0 && millis() - f.confirmedAtMs <= maxAgeMs;
+}
+
+void RadioState::invalidate()
+{
+    for (uint8_t i = 0; i < RADIO_PARAM_COUNT; i++)
+    {
+        if (_f[i].confirmed >= 0)
+            _f[i].version++;
+        _f[i].confirmed = -1;
+        _f[i].confirmedAtMs = 0;
+        _f[i].wantedAtMs = 0;
+    }
+    _linkDown = true;
+}
+
+uint8_t RadioState::takeReplay()
+{
+    uint8_t mask = 0;
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < RADIO_PARAM_COUNT; i++)
+    {
+        if (!_f[i].replay)
+            continue;
+        _f[i].replay = false;
+        _f[i].wantedAtMs = now ? now : 1; // settle time counts from the replay
+        mask |= 1 << i;
+    }
+    _linkDown = false;
+    return mask;
+}
+
+void RadioState::appendStats(String &out) const
+{
+    uint32_t now = millis();
+    for (uint8_t i = 0; i < RADIO_PARAM_COUNT; i++)
+    {
+        const RadioField &f = _f[i];
+        out += "state ";
+        out += PARAM_NAMES[i];
+        out += ": " + String(f.desired);
+        if (!f.known())
+            out += " (unconfirmed)";
+        else if (!f.inSync())
+            out += " (radio " + String(f.confirmed) + ")";
+        out += " v" + String(f.version);
+        if (f.confirmedAtMs)
+            out += " age=" + String(now - f.confirmedAtMs) + "ms";
+        if (f.settleCount)
+        {
+            out += " settle last=" + String(f.settleLastMs);
+            out += " avg=" + String(f.settleSumMs / f.settleCount);
+            out += " max=" + String(f.settleMaxMs) + "ms";
+        }
+        out += "\n";
+    }
+    out += "state muted: ";
+    out += muted ? "yes" : "no";
+    out += " restore=" + String(restoreVolume) + "\n";
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <Arduino.h>
+#include "HB9IIURadioBackend.h"
+
+// One shadowed radio setting
+struct RadioField
+{
+    int32_t desired;        // what we want the radio to have (what the UI shows)
+    int32_t confirmed;      // what the radio last reported, -1 = never
+    uint32_t version;       // bumps whenever desired or confirmed changes
+    uint32_t confirmedAtMs; // millis() of the last report, 0 = never
+
+    // settle time: last want() until the radio confirms that value
+    uint32_t wantedAtMs; // 0 = nothing waiting for confirmation
+    uint32_t settleLastMs;
+    uint32_t settleMaxMs;
+    uint32_t settleSumMs;
+    uint32_t settleCount;
+
+    bool replay; // changed while the link was down: send on reconnect
+
+    bool known() const { return confirmed >= 0; }
+    bool inSync() const { return desired == confirmed; }
+};
+
+// Local shadow of the radio's state.
+// Knobs and buttons change `desired` (want()), reports from the radio
+// set `confirmed` (confirm()) - or both, when the change came from
+// elsewhere (adopt()). Everything that only needs to know a value reads
+// it from here instead of asking the radio.
+class RadioState
+{
+public:
+    RadioState();
+
+    // Current value (desired) - what actions, LEDs and the console use
+    int32_t get(RadioParam p) const { return _f[p].desired; }
+    const RadioField &field(RadioParam p) const { return _f[p]; }
+
+    // Local intent; true if the desired value actually changed
+    bool want(RadioParam p, int32_t value);
+    // The radio reported `value` (echo, poll answer, query reply)
+    void confirm(RadioParam p, int32_t value);
+    // Change made elsewhere (SmartSDR, resync): the radio's value wins
+    void adopt(RadioParam p, int32_t value);
+
+    bool known(RadioParam p) const { return _f[p].known(); }
+    // Confirmed by the radio within the last maxAgeMs
+    bool fresh(RadioParam p, uint32_t maxAgeMs) const;
+    uint32_t version(RadioParam p) const { return _f[p].version; }
+
+    // Link lost: nothing is confirmed any more (desired values stay, and
+    // what is wanted from now on is remembered for replay)
+    void invalidate();
+    // Link back: bit per RadioParam changed while it was down. Only the
+    // final desired value of each is worth sending, not the history.
+    uint8_t takeReplay();
+
+    // Local-only state (never on the wire)
+    bool muted = false;
+    int16_t restoreVolume = 50; // last non-zero AF gain, restored on unmute
+
+    // One line per field for /stats
+    void appendStats(String &out) const;
+
+private:
+    RadioField _f[RADIO_PARAM_COUNT];
+    bool _linkDown = false;
+};
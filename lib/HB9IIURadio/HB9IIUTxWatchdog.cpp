@@ -0,0 +1,67 @@
+#include "HB9IIUTxWatchdog.h"
+
+bool TxWatchdog::begin(TxWatchdogHandler onFire)
+{
+    _onFire = onFire;
+    if (_timer)
+        return true;
+
+    esp_timer_create_args_t args = {};
+    args.callback = onTimer;
+    args.arg = this;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "txwd";
+    return esp_timer_create(&args, &_timer) == ESP_OK;
+}
+
+void TxWatchdog::arm(uint32_t maxMs)
+{
+    if (!_timer)
+        return;
+    esp_timer_stop(_timer); // restart: fails harmlessly if not running
+    _armed = maxMs > 0;
+    if (_armed)
+        esp_timer_start_once(_timer, (uint64_t)maxMs * 1000ULL);
+}
+
+void TxWatchdog::disarm()
+{
+    if (_timer)
+        esp_timer_stop(_timer);
+    _armed = false;
+}
+
+// esp_timer task: the loop may be stuck, so un-key from here
+void TxWatchdog::onTimer(void *arg)
+{
+    TxWatchdog &self = *static_cast<TxWatchdog *>(arg);
+    self._armed = false;
+    self._handled = self._onFire && self._onFire();
+    self._firedAtMs[self._fired % HISTORY] = millis();
+    self._fired++;
+    self._pending = true;
+}
+
+bool TxWatchdog::takeFired()
+{
+    if (!_pending)
+        return false;
+    _pending = false;
+    return true;
+}
+
+void TxWatchdog::appendStats(String &out) const
+{
+    out += "tx watchdog: ";
+    out += _armed ? "armed" : "idle";
+    out += " fired=" + String(_fired);
+    uint32_t now = millis();
+    uint32_t n = _fired < HISTORY ? _fired : HISTORY;
+    for (uint32_t i = 0; i < n; i++)
+    {
+        uint32_t at = _firedAtMs[(_fired - 1 - i) % HISTORY];
+        out += i ? ", " : " at ";
+        out += String((now - at) / 1000) + "s ago";
+    }
+    out += "\n";
+}
@@ -0,0 +1,45 @@
+#pragma once
+#include <Arduino.h>
+#include <esp_timer.h>
+
+// Called from the esp_timer task when the key-down limit is reached.
+// Must not wait on the main loop; true if the un-key went out on a path
+// that does not need it (the loop then only cleans up).
+typedef bool (*TxWatchdogHandler)();
+
+// Maximum key-down time, enforced by a one-shot esp_timer (hardware timer,
+// callbacks dispatched from its own high-priority task), so it fires even
+// when loop() is stuck in a scan, a slow web client or a reboot path.
+// arm() on every key-down, disarm() on un-key; the loop picks up what
+// happened with takeFired().
+class TxWatchdog
+{
+public:
+    static const uint8_t HISTORY = 4; // fire times kept for /stats
+
+    bool begin(TxWatchdogHandler onFire);
+
+    // Start (or restart) the countdown; maxMs 0 = no limit
+    void arm(uint32_t maxMs);
+    void disarm();
+    bool armed() const { return _armed; }
+
+    // Loop side: true once per firing
+    bool takeFired();
+    bool lastHandled() const { return _handled; } // emergency path reached the radio
+
+    uint32_t fired() const { return _fired; }
+    void appendStats(String &out) const;
+
+private:
+    static void onTimer(void *arg);
+
+    esp_timer_handle_t _timer = nullptr;
+    TxWatchdogHandler _onFire = nullptr;
+
+    volatile bool _armed = false;
+    volatile bool _pending = false; // fired, loop has not looked yet
+    volatile bool _handled = false;
+    volatile uint32_t _fired = 0;
+    uint32_t _firedAtMs[HISTORY] = {}; // millis() of the last firings (ring)
+};
@@ -0,0 +1,158 @@
+#include "HB9IIUTrace.h"
+
+static_assert(sizeof(Trace::Record) == 48, "dump format: 48-byte records");
+static_assert(sizeof(Trace::DumpHeader) == 16, "dump format: 16-byte header");
+
+// Format strings stay in flash; only their ids travel through the ring
+#define HB9IIU_TRACE_FORMAT(id, fmt) fmt,
+static const char *const FORMATS[TRACE_ID_COUNT] = {HB9IIU_TRACE_MESSAGES(HB9IIU_TRACE_FORMAT)};
+#undef HB9IIU_TRACE_FORMAT
+
+static Trace::Record ring[Trace::RING_RECORDS];
+static uint32_t head = 0; // records ever written
+static uint32_t tail = 0; // next one for next()
+static uint32_t lost = 0;
+static portMUX_TYPE traceMux = portMUX_INITIALIZER_UNLOCKED;
+
+void Trace::record(TraceId id, uint8_t count, const uint32_t *args)
+{
+    if (count > MAX_ARGS)
+        count = MAX_ARGS;
+    uint32_t now = micros();
+    portENTER_CRITICAL(&traceMux);
+    Trace::Record &r = ring[head % Trace::RING_RECORDS];
+    head++;
+    r.us = now;
+    r.id = id;
+    r.len = count;
+    r.flags = 0;
+    if (count)
+        memcpy(r.args, args, count * sizeof(uint32_t));
+    portEXIT_CRITICAL(&traceMux);
+}
+
+void Trace::text(TraceId id, const char *s, size_t len)
+{
+    if (len > TEXT_MAX * TEXT_CHAIN)
+        len = TEXT_MAX * TEXT_CHAIN;
+    uint32_t now = micros();
+
+    // all pieces under one lock, so they sit next to each other in the ring
+    portENTER_CRITICAL(&traceMux);
+    uint8_t flags = FLAG_TEXT;
+    do
+    {
+        uint8_t n = len < TEXT_MAX ? (uint8_t)len : TEXT_MAX;
+        Trace::Record &r = ring[head % Trace::RING_RECORDS];
+        head++;
+        r.us = now;
+        r.id = id;
+        r.len = n;
+        r.flags = flags;
+        memcpy(r.text, s, n);
+        s += n;
+        len -= n;
+        flags = FLAG_TEXT | FLAG_CONT;
+    } while (len > 0);
+    portEXIT_CRITICAL(&traceMux);
+}
+
+const char *Trace::format(uint16_t id)
+{
+    return id < TRACE_ID_COUNT ? FORMATS[id] : nullptr;
+}
+
+bool Trace::next(char *out, size_t size)
+{
+    Record r;
+    portENTER_CRITICAL(&traceMux);
+    if (tail == head)
+    {
+        portEXIT_CRITICAL(&traceMux);
+        return false;
+    }
+    if (head - tail > RING_RECORDS)
+    {
+        lost += head - tail - RING_RECORDS; // overwritten before we got here
+        tail = head - RING_RECORDS;
+    }
+    r = ring[tail % RING_RECORDS];
+    tail++;
+
+    // text spread over several records: join the pieces that follow
+    char text[TEXT_MAX * TEXT_CHAIN + 1];
+    size_t textLen = 0;
+    if (r.flags & FLAG_TEXT)
+    {
+        const Record *piece = &r;
+        for (;;)
+        {
+            uint8_t n = piece->len < TEXT_MAX ? piece->len : TEXT_MAX;
+            if (textLen + n > TEXT_MAX * TEXT_CHAIN)
+                n = TEXT_MAX * TEXT_CHAIN - textLen;
+            memcpy(text + textLen, piece->text, n);
+            textLen += n;
+            if (tail == head || !(ring[tail % RING_RECORDS].flags & FLAG_CONT))
+                break;
+            piece = &ring[tail % RING_RECORDS];
+            tail++;
+        }
+    }
+    text[textLen] = '\0';
+    portEXIT_CRITICAL(&traceMux);
+
+    const char *fmt = format(r.id);
+    if (!fmt)
+        snprintf(out, size, "[TRACE] unknown id %u", r.id);
+    else if (r.flags & FLAG_TEXT)
+        snprintf(out, size, fmt, text);
+    else
+    {
+        // unused slots are passed too and ignored by the format
+        uint32_t a[MAX_ARGS] = {0};
+        memcpy(a, r.args, (r.len < MAX_ARGS ? r.len : MAX_ARGS) * sizeof(uint32_t));
+        snprintf(out, size, fmt, a[0], a[1], a[2], a[3]);
+    }
+    return true;
+}
+
+size_t Trace::dumpSize()
+{
+    return sizeof(DumpHeader) + sizeof(ring);
+}
+
+size_t Trace::dump(uint8_t *out, size_t size)
+{
+    if (size < dumpSize())
+        return 0;
+
+    DumpHeader h;
+    memcpy(h.magic, "HBTR", 4);
+    h.version = DUMP_VERSION;
+    h.recordSize = sizeof(Record);
+
+    // one copy under the lock (a few microseconds), oldest record first
+    portENTER_CRITICAL(&traceMux);
+    uint32_t n = head < RING_RECORDS ? head : RING_RECORDS;
+    uint32_t first = head - n;
+    for (uint32_t i = 0; i < n; i++)
+        memcpy(out + sizeof(h) + i * sizeof(Record), &ring[(first + i) % RING_RECORDS], sizeof(Record));
+    h.count = (uint16_t)n;
+    h.lost = lost;
+    h.nowUs = micros();
+    portEXIT_CRITICAL(&traceMux);
+
+    memcpy(out, &h, sizeof(h));
+    return sizeof(h) + n * sizeof(Record);
+}
+
+void Trace::appendStats(String &out)
+{
+    portENTER_CRITICAL(&traceMux);
+    uint32_t written = head;
+    uint32_t pending = head - tail;
+    uint32_t dropped = lost;
+    portEXIT_CRITICAL(&traceMux);
+    out += "trace: records=" + String(written) + " pending=" + String(pending);
+    out += " lost=" + String(dropped) + " ids=" + String((unsigned)TRACE_ID_COUNT) + "\n";
+}
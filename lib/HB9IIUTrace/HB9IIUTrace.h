@@ -0,0 +1,88 @@
+#pragma once
+#include <Arduino.h>
+#include "HB9IIUTraceMessages.h"
+
+// Deferred-format logging. A call stores (message id, micros(), raw args)
+// in a RAM ring and returns; no printf, no String, no UART on the caller's
+// side. The text is built later, when the log task drains the ring (next())
+// or on the host from a binary dump (dump() -> tools/trace_decode.py).
+// Safe from any task (not from ISRs); the ring keeps the newest RING_RECORDS
+// entries, a reader that falls behind loses the oldest ones.
+namespace Trace
+{
+    static const uint8_t MAX_ARGS = 4;
+    static const uint8_t TEXT_MAX = 40;       // %s bytes per record
+    static const uint8_t TEXT_CHAIN = 6;      // records one %s may span (longer is cut)
+    static const uint16_t RING_RECORDS = 128; // 6 KB
+    static const uint8_t DUMP_VERSION = 1;
+
+    enum : uint8_t
+    {
+        FLAG_TEXT = 0x01, // payload is text, not integer args
+        FLAG_CONT = 0x02  // more text of the record before (same id)
+    };
+
+    // One ring entry; also the on-the-wire record of dump() (little endian)
+    struct Record
+    {
+        uint32_t us;   // micros() when logged
+        uint16_t id;   // TraceId
+        uint8_t len;   // integer args, or text bytes with FLAG_TEXT
+        uint8_t flags;
+        union
+        {
+            uint32_t args[MAX_ARGS];
+            char text[TEXT_MAX]; // not NUL terminated when full
+        };
+    };
+
+    // Dump header, followed by `count` records, oldest first
+    struct DumpHeader
+    {
+        char magic[4]; // "HBTR"
+        uint8_t version;
+        uint8_t recordSize;
+        uint16_t count;
+        uint32_t lost;  // records the log task never formatted
+        uint32_t nowUs; // micros() at dump time
+    };
+
+    void record(TraceId id, uint8_t count, const uint32_t *args);
+    // %s argument: copied as is, over several records if it is longer
+    // than TEXT_MAX (next() and the decoder join them again)
+    void text(TraceId id, const char *s, size_t len);
+    inline void text(TraceId id, const char *s) { text(id, s, strnlen(s, TEXT_MAX * TEXT_CHAIN)); }
+
+    inline void log(TraceId id) { record(id, 0, nullptr); }
+    inline void log(TraceId id, uint32_t a)
+    {
+        uint32_t v[1] = {a};
+        record(id, 1, v);
+    }
+    inline void log(TraceId id, uint32_t a, uint32_t b)
+    {
+        uint32_t v[2] = {a, b};
+        record(id, 2, v);
+    }
+    inline void log(TraceId id, uint32_t a, uint32_t b, uint32_t c)
+    {
+        uint32_t v[3] = {a, b, c};
+        record(id, 3, v);
+    }
+    inline void log(TraceId id, uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+    {
+        uint32_t v[4] = {a, b, c, d};
+        record(id, 4, v);
+    }
+
+    // Format the oldest unread record into `out`; false when none is left.
+    // Meant for one reader (the log task).
+    bool next(char *out, size_t size);
+
+    // Binary snapshot of the whole ring; returns bytes written (0 if too small)
+    size_t dumpSize();
+    size_t dump(uint8_t *out, size_t size);
+
+    const char *format(uint16_t id);
+    void appendStats(String &out);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+// Trace message catalogue: X(id, "format"). The id is the position in this
+// list, so append new messages at the end and never reorder or remove one
+// while old dumps are still around (tools/trace_decode.py reads this file).
+// Formats take up to TRACE_MAX_ARGS integer args (%d %u %x %c, width/flags
+// allowed, no length modifiers) or a single %s.
+#define HB9IIU_TRACE_MESSAGES(X)                                                     \
+    X(TR_RADIO_LINE, "%s")                                                           \
+    X(TR_FILT_CLAMPED, "[FILT] Requested preset %u, clamped to %u (valid range 0-7).") \
+    X(TR_FILT_OFFLINE, "[FILT] Radio not connected; preset %u sent on reconnect.")   \
+    X(TR_FILT_SET, "[FILT] Setting filter preset index to %u")                       \
+    X(TR_FILT_REPLY, "[FILTER] Current preset = %d")                                 \
+    X(TR_FILT_NO_REPLY, "[FILTER] No reply; defaulting to 0")                        \
+    X(TR_VOL_CLAMPED, "[VOL] Requested %u%%, clamped to %u%%.")                      \
+    X(TR_VOL_OFFLINE, "[VOL] Radio not connected; %u%% sent on reconnect.")          \
+    X(TR_VOL_SET, "[VOL] Setting AF gain to %u%%")                                   \
+    X(TR_VOL_NO_REPLY, "[VOL] No AF gain reply.")                                    \
+    X(TR_VOL_RANGE, "[VOL] Parsed volume out of range: %d")                          \
+    X(TR_VOL_REPLY, "[VOL] Parsed current AF gain: %d%%")                            \
+    X(TR_EXT_FREQ, "[EXT] Radio -> %u.%06u MHz (sync)")                              \
+    X(TR_EXT_MODE, "[EXT] Radio -> MD%d (sync)")                                     \
+    X(TR_EXT_FILTER, "[EXT] Radio -> filter preset %d (sync)")                       \
+    X(TR_EXT_AFGAIN, "[EXT] Radio -> AF gain %d%% (sync)")                           \
+    X(TR_MUTE_ON, "[MUTE] ON")                                                       \
+    X(TR_MUTE_OFF, "[MUTE] OFF -> %d%%")                                             \
+    X(TR_FREQ_SET, "[ACTION] VFO set to %u.%06u MHz")                                \
+    X(TR_MD_OFFLINE, "[MD] Cannot set mode to '%s' - radio not connected.")          \
+    X(TR_MD_UNMAPPED, "[MD] Requested mode '%s' is not mapped to any MD code. Ignoring.") \
+    X(TR_MD_SET, "[MD] Setting mode to MD%d")                                        \
+    X(TR_PTT_OFFLINE, "[PTT] Cannot set PTT %s - radio not connected.")              \
+    X(TR_PTT_SET, "[PTT] Setting PTT %s")                                            \
+    X(TR_PTT_FAILED, "[PTT] ERROR: Failed to send PTT command.")                     \
+    X(TR_PTT_SENT, "[PTT] PTT command sent successfully.")                           \
+    X(TR_PWR_OFFLINE, "[PWR] Cannot set power to %u%% - radio not connected.")       \
+    X(TR_PWR_CLAMPED, "[PWR] Requested %u%%, clamped to %u%%.")                      \
+    X(TR_PWR_SET, "[PWR] Setting RF power to %u%%")                                  \
+    X(TR_PWR_NO_REPLY, "[PWR] No RF power reply.")                                   \
+    X(TR_PWR_RANGE, "[PWR] Parsed power value out of range: %d")                     \
+    X(TR_PWR_REPLY, "[PWR] Parsed current RF power: %d%%")                           \
+    X(TR_MD_CODE_OFFLINE, "[MD] Cannot set mode code MD%d - radio not connected.")   \
+    X(TR_MD_CODE_SET, "[MD] Setting mode by code: MD%d")                             \
+    X(TR_INPUT, "[INPUT] input %u gesture %u -> action %u")                         \
+    X(TR_RADIO_TX, ">> %s")                                                          \
+    X(TR_RADIO_RX, "<< %s")                                                          \
+    X(TR_ENC_NO_PCNT, "[ENC] %s: no pulse counter, using the GPIO interrupt")        \
+    X(TR_SCAN_DONE, "[SCAN] %u hosts probed in %u ms")                               \
+    X(TR_CAT_CONNECTING, "[CAT] Connecting %u.%u.%u.%u")                             \
+    X(TR_CAT_CONNECTED, "[CAT] Connected in %u ms.")                                 \
+    X(TR_CAT_TRY, "[CAT] Try %u/4")                                                  \
+    X(TR_DISC_NONE, "[DISC] No discovery broadcast heard.")                          \
+    X(TR_DISC_RADIO, "[DISC] Radio at %u.%u.%u.%u")                                  \
+    X(TR_DISC_INFO, "[DISC]   %s")                                                   \
+    X(TR_DISC_NOT_FOUND, "[DISC] No %s on the discovered hosts.")                    \
+    X(TR_CACHE_NONE, "[CACHE] None of %u known hosts answered.")                     \
+    X(TR_CACHE_RACE, "[CACHE] %u known hosts raced, %u ms")                          \
+    X(TR_SCAN_START, "[SCAN] Scanning subnet for TCP %u ...")                        \
+    X(TR_SCAN_NONE, "[SCAN] No %s found.")                                           \
+    X(TR_SAVE_RANKING, "[SAVE] Host ranking updated, %u.%u.%u.%u first.")            \
+    X(TR_LINK_SB_NONE, "[LINK] Standby: no other known host.")                       \
+    X(TR_LINK_SB_UNAVAILABLE, "[LINK] Standby not available (%s backend / query port).") \
+    X(TR_LINK_SB_HOST, "[LINK] Standby %u.%u.%u.%u (next known host)")               \
+    X(TR_LINK_SB_PORT, "[LINK] Standby port %u on the same host")                    \
+    X(TR_LINK_DOWN, "[LINK] Radio link down; reconnecting in the background.")       \
+    X(TR_LINK_BACK, "[LINK] Back after %u ms; %u setting(s) replayed.")              \
+    X(TR_LINK_REBOOT, "[LINK] No link for %u s; rebooting...")                       \
+    X(TR_LINK_ANSWERED, "[LINK] %u.%u.%u.%u answered")                               \
+    X(TR_CACHE_ANSWERED, "[CACHE] %u.%u.%u.%u answered")                             \
+    X(TR_DISC_ANSWERED, "[DISC] %u.%u.%u.%u answered")                               \
+    X(TR_SCAN_ANSWERED, "[SCAN] %u.%u.%u.%u answered")                               \
+    X(TR_LINK_PROBED, "[LINK] %u hosts probed in %u ms")                             \
+    X(TR_SYNC_NO_FA, "[SYNC] No FA reply; pushing local once.")                      \
+    X(TR_SYNC_START, "[SYNC] Start at %u.%06u MHz")                                  \
+    X(TR_SYNC_ANSWERED, "[SYNC] VFO/filter/volume/mode answered in %u ms")           \
+    X(TR_SYNC_INCOMPLETE, "[SYNC] VFO/filter/volume/mode answered in %u ms (incomplete)") \
+    X(TR_MODE_CYCLE, "[MODE] Cycle -> %s")                                           \
+    X(TR_MODE_CYCLE_FAILED, "[MODE] Failed to set mode in cycle")                    \
+    X(TR_MODE_CYCLE_OFFLINE, "[MODE] Cycle ignored (radio not connected)")           \
+    X(TR_MODE_FORCE_RX, "[MODE/PTT] Forcing RX after mode change")                   \
+    X(TR_PTT_WATCHDOG_SENT, "[PTT] TX watchdog: key-down over %u s; emergency un-key sent.") \
+    X(TR_PTT_WATCHDOG, "[PTT] TX watchdog: key-down over %u s; un-keying now.")      \
+    X(TR_VOL_AUTO_UNMUTE, "[VOL] Encoder rotated while muted -> auto-unmute")        \
+    X(TR_INPUT_REBOOT, "[INPUT] Rebooting")                                          \
+    X(TR_RADIO_BACKEND_SET, "[RADIO] Backend set to %s; rebooting.")                 \
+    X(TR_PORTAL_WAITING, "Waiting in CAPTIVE PORTAL mode for Wifi Credentials: %u seconds")
+
+#define HB9IIU_TRACE_ENUM(id, fmt) id,
+enum TraceId : uint16_t
+{
+    HB9IIU_TRACE_MESSAGES(HB9IIU_TRACE_ENUM)
+    TRACE_ID_COUNT
+};
+#undef HB9IIU_TRACE_ENUM
@@ -1,4 +1,6 @@
 #include "HB9IIUWebConsoleLogger.h"
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
 
 // ================== INTERNAL STATE ===================
 static WebServer *g_server = nullptr;
@@ -8,16 +10,77 @@ static const int LOG_LINES = 100;
 static String logBuffer[LOG_LINES];
 static int logIndex = 0;
 
+// log task: callers queue fixed-size lines, the task prints and stores them
+static const int LOG_QUEUE_LINES = 32;
+static const size_t LOG_LINE_MAX = 128; // longer lines are cut
+static QueueHandle_t logQueue = nullptr;
+static SemaphoreHandle_t logMutex = nullptr; // logBuffer: log task vs. web handlers
+static volatile uint32_t logDropped = 0;
+static LogSourceFn logSource = nullptr;
+static const TickType_t LOG_SOURCE_POLL = pdMS_TO_TICKS(20); // source latency
+
 // -------- Internal helpers --------
+static void lockLog() {
+  if (logMutex) xSemaphoreTake(logMutex, portMAX_DELAY);
+}
+
+static void unlockLog() {
+  if (logMutex) xSemaphoreGive(logMutex);
+}
+
 static void addLogLine(const String &line) {
+  lockLog();
   logBuffer[logIndex] = line;
   logIndex = (logIndex + 1) % LOG_LINES;
+  unlockLog();
+}
+
+static void logTask(void *) {
+  char line[LOG_LINE_MAX];
+  for (;;) {
+    if (xQueueReceive(logQueue, line, logSource ? LOG_SOURCE_POLL : portMAX_DELAY) == pdTRUE) {
+      Serial.println(line);
+      addLogLine(String(line));
+    }
+    while (logSource && logSource(line, sizeof(line))) {
+      Serial.println(line);
+      addLogLine(String(line));
+    }
+  }
 }
 
 // Public logging function
 void logPrintln(const String &msg) {
-  Serial.println(msg);
-  addLogLine(msg);
+  if (!logQueue) {
+    // before the task runs (setup): print right here
+    Serial.println(msg);
+    addLogLine(msg);
+    return;
+  }
+  char line[LOG_LINE_MAX];
+  strlcpy(line, msg.c_str(), sizeof(line));
+  if (xQueueSend(logQueue, line, 0) != pdTRUE) logDropped++;
+}
+
+bool WebConsoleLogger_startTask(BaseType_t core, UBaseType_t priority) {
+  if (logQueue) return true;
+  logMutex = xSemaphoreCreateMutex();
+  QueueHandle_t q = xQueueCreate(LOG_QUEUE_LINES, LOG_LINE_MAX);
+  if (!logMutex || !q) return false;
+  logQueue = q;
+  if (xTaskCreatePinnedToCore(logTask, "log", 3072, nullptr, priority, nullptr, core) != pdPASS) {
+    logQueue = nullptr; // keep printing in place
+    return false;
+  }
+  return true;
+}
+
+void WebConsoleLogger_setSource(LogSourceFn fn) {
+  logSource = fn;
+}
+
+uint32_t WebConsoleLogger_dropped() {
+  return logDropped;
 }
 
 // ============= HTTP HANDLERS =====================
@@ -30,6 +93,7 @@ static void handleLogs() {
   if (!g_server) return;
 
   String text;
+  lockLog();
   int idx = logIndex;
   for (int i = 0; i < LOG_LINES; i++) {
     int pos = (idx + i) % LOG_LINES;
@@ -37,7 +101,8 @@ static void handleLogs() {
       text += logBuffer[pos] + "\n";
     }
   }
-  g_server->send(200, "text/plain", text);
+  unlockLog();
+  g_server->send(200, "text/plain", text); // socket write outside the lock
 }
 
 static void handleRestart() {
@@ -51,10 +116,12 @@ static void handleRestart() {
 
 static void handleClearLogs() {
   logPrintln("Web request: clear logs");
+  lockLog();
   for (int i = 0; i < LOG_LINES; i++) {
     logBuffer[i] = "";
   }
   logIndex = 0;
+  unlockLog();
   if (g_server) {
     g_server->send(200, "text/plain", "Logs cleared");
   }
@@ -8,4 +8,18 @@
 void WebConsoleLogger_begin(WebServer &server, const char *htmlPage);
 
 // Logging function to use instead of Serial.println():
+// from any task; once the log task runs it only queues the line
 void logPrintln(const String &msg);
+
+// Move Serial output and the web buffer into a low-priority task, so a
+// blocking UART or a /logs reader never holds up the caller
+bool WebConsoleLogger_startTask(BaseType_t core, UBaseType_t priority);
+
+// Extra line source drained by the log task (e.g. deferred-format trace
+// records): returns false when it has nothing left. Set before the task
+// starts; without the task the source is never read.
+typedef bool (*LogSourceFn)(char *line, size_t size);
+void WebConsoleLogger_setSource(LogSourceFn fn);
+
+// Lines lost because the log queue was full
+uint32_t WebConsoleLogger_dropped();
@@ -24,6 +24,23 @@
 #include <WiFi.h>
 #include <WebServer.h>
 #include <Preferences.h>
+#include "HB9IIURadioBackend.h"
+#include "HB9IIUCatBackend.h"
+#include "HB9IIUFlexApiBackend.h"
+#include "HB9IIURadioState.h"
+#include "HB9IIUFlexDiscovery.h"
+#include "HB9IIUSubnetProbe.h"
+#include "HB9IIUHostCache.h"
+#include "HB9IIUTxWatchdog.h"
+#include "HB9IIUPcntEncoder.h"
+#include "HB9IIUIsrEncoderBank.h"
+#include "HB9IIUTuningAccel.h"
+#include "HB9IIULoopEvents.h"
+#include "HB9IIUInputEngine.h"
+#include "HB9IIUInputBindings.h"
+#include "HB9IIUTrace.h"
+#include <soc/soc.h>
+#include <soc/gpio_reg.h>
 
 // --- LEDS ---
 const int PIN_LED_GREEN = 13;
@@ -56,10 +73,20 @@ const char *OTA_HOSTNAME = "flexcontroller"; // should match with platformio.ini
 bool webDebug = true;
 String debugMessage;
 
-const uint16_t CAT_PORT = 5002;
+const uint16_t CAT_PORT = CatBackend::DEFAULT_PORT; // SmartSDR CAT; the TCP API uses 4992
 
 // --- discovery timeouts (fast) ---
 const uint32_t TCP_CONNECT_TIMEOUT_MS = 150;
+const uint32_t DISCOVERY_WAIT_MS = 1500; // radios broadcast about once a second
+const uint32_t PROBE_TIMEOUT_MS = 250;   // per host, several in flight
+const uint32_t KNOWN_HOST_TIMEOUT_MS = 600; // race between cached hosts
+const uint32_t RECONNECT_BACKOFF_MIN_MS = 500; // doubles per round up to 8 s, +-25 % jitter
+const uint8_t RECONNECT_SCAN_EVERY = 4;        // subnet scan every Nth reconnect round
+const uint32_t RECONNECT_SCAN_SLICE_MS = 30;   // scan time per loop() pass
+const uint16_t RECONNECT_REBOOT_BUDGET_S = 600; // reboot after this long without link (0 = never)
+const uint32_t SCAN_BUDGET_MS = 15000;   // whole subnet scan
+const uint8_t PROBE_GATEWAY_RADIUS = 8;  // hosts either side of the gateway probed first
+const bool SCAN_WIDE_SUBNETS = false;    // sweep prefixes wider than /24 (down to /20)
 WebServer server(80);
 
 // ===== LED BLINK TASK STUFF =====
@@ -74,21 +101,15 @@ const uint32_t FT8_20M_HZ = 14074000UL; // 14.074 MHz
 
 // Blink task
 void ledBlinkTask(void *parameter);
-// Read CAT-line
-bool readLine(String &out, uint32_t waitMs);
 // Send VFO
 bool sendFA(uint32_t hz);
 // Send filter
 bool sendFilterPreset(uint8_t idx);
-// Read filter
-void readFilterPresetOnce();
 // Set volume
 bool setVolumeA(uint8_t lvl);
-// Read volume
-int readVolumeA();
-// Sync VFO
-bool initialSyncFromRadio();
-// Pump CAT
+// Sync VFO + filter + volume + mode (one round trip)
+bool resyncFromRadio(); // async: replies land in radioState
+// Pump radio backend
 void pumpIncoming();
 // Connect host
 bool tryConnectHost(const IPAddress &host);
@@ -106,22 +127,23 @@ inline void setFT8_40m() { setFrequencyHz(FT8_40M_HZ); }
 inline void setFT8_20m() { setFrequencyHz(FT8_20M_HZ); }
 // Set mode
 bool setMode(const String &mode);
-// Get mode
-int getMode(); // returns MD code or -1 on fail
 // Set mode-code
 bool setModeCode(int code); // send MDn; directly
 // Set PTT
 bool setPTT(bool on);
 // Set RF-power
 bool setPowerPct(uint8_t pct); // ZZPC 000..100
-// Get RF-power
-int getPowerPct(); // 0..100 or -1
+// Parse RF-power reply
+int parsePowerPct(int32_t value); // 0..100 or -1 (value -1 = no reply)
 // Cycle modes
 void cycleModeSequence(); // USB -> LSB -> CW -> FM -> ...
 // Start tune
 void startTune(uint16_t ms = 1200, uint8_t tunePower = 10, const String &tuneMode = "AM");
 // Service tune
 void serviceTune();
+// Service delayed RX after mode change
+void serviceForceRx();
+void serviceTxWatchdog();
 // Startup banner
 void printStartupHeader();
 // Mute toggle
@@ -130,6 +152,17 @@ void muteUnmute();
 void updateGreenLed();
 // Reboot ESP
 void rebootESP();
+// /stats page
+void handleStats();
+int statsReply(String &out);
+// /trace binary dump
+void handleTrace();
+// /backend page (CAT or TCP API)
+void handleBackend();
+int backendReply(String &out);
+// /inputs page (binding map)
+void handleInputs();
+int inputsReply(String &out);
 
 //---------------------------------------------------------------------------------------------------------------------
 
@@ -162,12 +195,19 @@ const int VOLUME_STEP = 5; // change to 2/5/10 as you like
 
 #define ENC_INPUT_MODE INPUT_PULLUP
 
-// Frequency step/behavior
-const int32_t STEP_HZ = 1;
-const uint32_t SEND_INTERVAL_MS = 60;
-const uint32_t RESYNC_MS = 800;
-const uint32_t ACCEL_T1_MS = 35;
-const uint32_t ACCEL_T2_MS = 80;
+// Frequency step/behavior (base step per mode: see tuningStepHz())
+const uint32_t VFO_MIN_HZ = 30000;
+const uint32_t VFO_MAX_HZ = 54000000;
+const uint32_t SEND_INTERVAL_MS = 60; // scheduler tick (one CAT write max); starting point for CAT
+const uint16_t SEND_INTERVAL_MIN_MS = 30;  // CAT adapts between these from RTT and
+const uint16_t SEND_INTERVAL_MAX_MS = 250; // socket backpressure (equal = fixed)
+
+// External changes (SmartSDR, other clients) arrive as backend reports
+const uint32_t OWN_ECHO_WINDOW_MS = 1500; // reports matching our own writes this recent are echoes
+
+// CAT write budget (token bucket, one token per command)
+const uint8_t CAT_BUDGET_BURST = 8;     // commands in a burst
+const uint16_t CAT_BUDGET_PER_SEC = 40; // sustained commands per second
 
 // ---- TTP223 TOUCH PINS (active-HIGH, idle LOW) ----
 const int PIN_TOUCH1 = 23;
@@ -176,73 +216,204 @@ const int PIN_TOUCH3 = 21;
 const int PIN_TOUCH4 = 19;
 const int PIN_TOUCH5 = 18;
 
-// Simple debounce
+// ---- INPUT TABLE: pads and encoder clicks, one scan for all (InputEngine) ----
 const uint16_t TOUCH_DEBOUNCE_MS = 100;
-bool touchLast1 = false, touchLast2 = false, touchLast3 = false, touchLast4 = false, touchLast5 = false;
-uint32_t touchT1 = 0, touchT2 = 0, touchT3 = 0, touchT4 = 0, touchT5 = 0;
-
-// Encoder click debounce (active-LOW)
 const uint16_t CLICK_DEBOUNCE_MS = 50;
-bool clickLastBW = false, clickLastVol = false; // "pressed" state (LOW) after inversion
-uint32_t clickTBW = 0, clickTVol = 0;
-
-WiFiClient cat;
+const uint16_t INPUT_LONG_MS = 800;
+const uint16_t INPUT_DOUBLE_MS = 300;
+const uint16_t INPUT_SCAN_MS = 10; // sampling while a gesture is in progress (else: pin interrupts)
+const InputPin INPUT_TABLE[] = {
+    {"pad1", PIN_TOUCH1, true, TOUCH_DEBOUNCE_MS, INPUT_LONG_MS, INPUT_DOUBLE_MS},
+    {"pad2", PIN_TOUCH2, true, TOUCH_DEBOUNCE_MS, INPUT_LONG_MS, INPUT_DOUBLE_MS},
+    {"pad3", PIN_TOUCH3, true, TOUCH_DEBOUNCE_MS, INPUT_LONG_MS, INPUT_DOUBLE_MS},
+    {"pad4", PIN_TOUCH4, true, TOUCH_DEBOUNCE_MS, INPUT_LONG_MS, INPUT_DOUBLE_MS},
+    {"pad5", PIN_TOUCH5, true, TOUCH_DEBOUNCE_MS, INPUT_LONG_MS, INPUT_DOUBLE_MS},
+    {"bw", PIN_ENC_BW_SW, false, CLICK_DEBOUNCE_MS, INPUT_LONG_MS, INPUT_DOUBLE_MS},
+    {"vol", PIN_ENC_VOL_SW, false, CLICK_DEBOUNCE_MS, INPUT_LONG_MS, INPUT_DOUBLE_MS},
+};
+const uint8_t INPUT_COUNT = sizeof(INPUT_TABLE) / sizeof(INPUT_TABLE[0]);
+
+// What an input can trigger. The numbers are stored in NVS: only append.
+enum InputAction : uint8_t
+{
+  ACT_NONE = 0,
+  ACT_FT8_40M,
+  ACT_FT8_20M,
+  ACT_PTT_ON,
+  ACT_PTT_OFF,
+  ACT_TUNE,
+  ACT_MODE_CYCLE,
+  ACT_MUTE,
+  ACT_REBOOT,
+  ACT_COUNT
+};
+const char *const ACTION_NAMES[ACT_COUNT] = {"none", "ft8_40m", "ft8_20m", "ptt_on", "ptt_off",
+                                             "tune", "mode_cycle", "mute", "reboot"};
+
+// Default bindings (rows of INPUT_TABLE): the controller's original behaviour
+const InputBinding DEFAULT_BINDINGS[] = {
+    {0, GESTURE_PRESS, ACT_FT8_40M},
+    {1, GESTURE_PRESS, ACT_FT8_20M},
+    {2, GESTURE_PRESS, ACT_PTT_ON},
+    {2, GESTURE_RELEASE, ACT_PTT_OFF},
+    {3, GESTURE_PRESS, ACT_TUNE},
+    {4, GESTURE_PRESS, ACT_MODE_CYCLE},
+    {5, GESTURE_PRESS, ACT_REBOOT},
+    {6, GESTURE_PRESS, ACT_MUTE},
+};
+InputEngine inputEngine;
+InputBindings inputBindings; // changed with /inputs, kept in NVS ("inbind")
+
+CatBackend catBackend(SEND_INTERVAL_MS, CAT_BUDGET_BURST, CAT_BUDGET_PER_SEC); // SmartSDR CAT (PC)
+FlexApiBackend apiBackend(SEND_INTERVAL_MS);                                    // radio TCP API
+RadioBackend *radio = &catBackend; // chosen from Preferences in setup()
+uint16_t radioPort = CAT_PORT;
 Preferences prefs;
 IPAddress currentHost;
+uint32_t lastConnectMs = 0; // TCP connect time of the current link
+HostCache hostCache;        // ranked endpoints that worked before
+FlexDiscovery discovery; // VITA-49 broadcasts on UDP 4992
+
+RadioState radioState;           // desired vs confirmed radio settings, read locally
+uint8_t resyncKeepLocal = 0;     // RadioParam bits replayed after a reconnect: keep ours
+const uint32_t DEFAULT_VFO_HZ = 14110000; // until the radio tells us
+const uint32_t TUNE_POWER_FRESH_MS = 10000; // older RF power readings are re-queried
+const uint16_t TX_MAX_KEYDOWN_S = 120;       // TX watchdog default, Preferences "txmax" (0 = off)
+
+TxWatchdog txWatchdog; // un-keys after txMaxS even if loop() is stuck
+uint16_t txMaxS = TX_MAX_KEYDOWN_S;
+
+// ---------- Rotary encoders ----------
+// Pulse-counter units decode in hardware; one shared GPIO interrupt
+// (timestamped detents) is the fallback
+const bool ENCODER_USE_PCNT = true;
+
+// optical VFO encoder: no bounce, but fast edges; mechanical ones: widest filter
+PcntEncoder vfoPcnt(PCNT_UNIT_0, PIN_ENC_A, PIN_ENC_B, ENC_INPUT_MODE, 250 /* ~3 us */);
+PcntEncoder filtPcnt(PCNT_UNIT_1, PIN_FILT_A, PIN_FILT_B, ENC_INPUT_MODE);
+PcntEncoder volPcnt(PCNT_UNIT_2, PIN_VOL_A, PIN_VOL_B, ENC_INPUT_MODE);
+IsrEncoderBank encoderBank(ENC_INPUT_MODE); // only encoders without a counter unit
+
+EncoderDriver *vfoEnc = &vfoPcnt; // chosen in setup()
+EncoderDriver *filtEnc = &filtPcnt;
+EncoderDriver *volEnc = &volPcnt;
+EncoderDetents vfoDetents, filtDetents, volDetents;
+TuningAccel tuningAccel; // velocity -> step multiplier (default curve)
+EncoderDetents *bankDetents[IsrEncoderBank::MAX_CHANNELS] = {}; // bank channel id -> detents
+bool needResetEncoderBaseline = false;
+
+// loop() wake-up bits (task notification value of the loop task)
+enum : uint32_t
+{
+  EV_CAT = 1 << 0,     // radio replies queued or link dropped (transport task)
+  EV_ENCODER = 1 << 1, // an idle encoder started moving (ISR)
+  EV_SCAN = 1 << 2,    // encoders moving: read the counters (timer)
+  EV_INPUT = 1 << 3,   // touch / click pin changed (ISR), gesture sampling (timer)
+  EV_NET = 1 << 4,     // discovery, reconnect, API backend poll (timer)
+  EV_UI = 1 << 5,      // LED flash/blink, tune and force-RX timing, pending reboot (timer)
+  EV_WEB = 1 << 6      // a web handler waits in webCalls (net task)
+};
+const uint16_t LOOP_NET_MS = 10;     // also bounds how late a paced CAT write goes out
+const uint16_t LOOP_UI_MS = 20;
+const uint16_t ENCODER_SCAN_MS = 2;  // counter reads while a knob moves
+const uint16_t ENCODER_IDLE_MS = 150; // no detent this long: back to wake-on-edge
+LoopEvents loopEvents;
+bool encodersScanning = false;
+uint32_t encoderMovedMs = 0;
+
+// Task layout (core / priority):
+//   control  (Arduino loop)  1 / 3  encoders, inputs, CAT scheduler, radio state
+//   CAT transport            0 / 2  sockets (CatTransport, per link)
+//   net                      0 / 1  web server, OTA, captive portal
+//   log                      0 / 1  Serial and the web console buffer
+// Radio and UI state belong to the control task. The others reach it only
+// through queues: CAT rings, webCalls (below) and the log queue.
+const UBaseType_t CONTROL_TASK_PRIORITY = 3;
+const BaseType_t NET_TASK_CORE = 0;
+const UBaseType_t NET_TASK_PRIORITY = 1;
+const uint16_t NET_TASK_PERIOD_MS = 5;
+const BaseType_t LOG_TASK_CORE = 0;
+const UBaseType_t LOG_TASK_PRIORITY = 1;
+TaskHandle_t netTaskHandle = nullptr;
+
+// A web request handed to the control task. The net task stays parked until
+// it is done, so fn may read server.arg(); the reply goes back in out.
+struct WebCall
+{
+  int (*fn)(String &out); // returns the HTTP status
+  String out;
+  int status;
+  TaskHandle_t waiter;
+};
+QueueHandle_t webCalls = nullptr; // WebCall * (net -> control)
+uint32_t rebootAtMs = 0;          // set by a web call: reboot once the reply is out (0 = no)
+
+// An address as the four %u of a catalogue message
+static void traceHost(TraceId id, const IPAddress &ip)
+{
+  Trace::log(id, ip[0], ip[1], ip[2], ip[3]);
+}
 
-uint32_t vfoHz = 14110000, lastSentHz = vfoHz;
+// Encoder ISRs (PCNT wake edge, GPIO fallback detent)
+static void IRAM_ATTR onEncoderWake(void *)
+{
+  loopEvents.postFromIsr(EV_ENCODER);
+}
 
-// ---------- Quadrature decoder (ISR) : MAIN ----------
-static const int8_t QDEC_TAB[16] = {
-    0, -1, +1, 0, +1, 0, 0, -1, -1, 0, 0, +1, 0, +1, -1, 0};
-volatile uint8_t vfo_q_last = 0;
-volatile int32_t q_edges = 0;
-volatile uint32_t lastDetentMs = 0;
-volatile int32_t detentPending = 0;
-volatile bool needResetEncoderBaseline = false;
+// Touch / click pin changed
+static void IRAM_ATTR onInputPin()
+{
+  loopEvents.postFromIsr(EV_INPUT);
+}
 
-inline uint8_t fastReadAB()
+// Every GPIO level at once (bit n = GPIO n) for the input scan
+static uint64_t readInputLevels()
 {
-  return (uint8_t(digitalRead(PIN_ENC_A)) << 1) | uint8_t(digitalRead(PIN_ENC_B));
+  return ((uint64_t)REG_READ(GPIO_IN1_REG) << 32) | REG_READ(GPIO_IN_REG);
 }
 
-void IRAM_ATTR encISR()
+static EncoderDriver *startEncoder(PcntEncoder &hw, uint8_t pinA, uint8_t pinB,
+                                   EncoderDetents &detents, const char *label)
 {
-  uint8_t now = fastReadAB();
-  uint8_t idx = (vfo_q_last << 2) | now;
-  int8_t d = QDEC_TAB[idx];
-  if (d)
+  if (ENCODER_USE_PCNT && hw.begin())
+    return &hw;
+  Trace::text(TR_ENC_NO_PCNT, label);
+  IsrEncoderBank::Channel *ch = encoderBank.add(pinA, pinB);
+  for (uint8_t i = 0; i < IsrEncoderBank::MAX_CHANNELS; i++)
   {
-    q_edges += d;
-    detentPending += d;
-    if (detentPending >= 4 || detentPending <= -4)
+    if (!bankDetents[i])
     {
-      lastDetentMs = millis();
-      detentPending = 0;
+      bankDetents[i] = &detents; // channels are numbered in add() order
+      break;
     }
   }
-  vfo_q_last = now;
+  return ch;
 }
 
-// ---------- FILTER ENCODER ----------
-volatile uint8_t f_q_last = 0;
-volatile int32_t f_edges = 0;
-int8_t filterIdx = 0; // 0..7
-
-inline uint8_t fastReadAB_filt()
+// Detents since the last pass, from timestamped events or the edge count
+static int32_t readDetents(EncoderDriver *enc, EncoderDetents &detents, uint32_t nowUs)
 {
-  return (uint8_t(digitalRead(PIN_FILT_A)) << 1) | uint8_t(digitalRead(PIN_FILT_B));
+  return enc->timestamped() ? detents.takeAdded() : detents.take(enc->edges(), nowUs);
 }
 
-void IRAM_ATTR filtISR()
+// Base VFO step for the current mode (MD codes); acceleration multiplies it
+static uint32_t tuningStepHz()
 {
-  uint8_t now = fastReadAB_filt();
-  uint8_t idx = (f_q_last << 2) | now;
-  int8_t d = QDEC_TAB[idx];
-  if (d)
-    f_edges += d;
-  f_q_last = now;
+  switch (radioState.get(RADIO_MODE))
+  {
+  case 3: // CW
+  case 6: // DIGL
+  case 9: // DIGU
+    return 1;
+  case 5: // AM
+    return 1000;
+  case 4: // FM
+    return 5000;
+  default: // LSB/USB, or mode not known yet
+    return 10;
+  }
 }
+
 // ---- LED helpers ----
 inline void ledsOff()
 {
@@ -293,69 +464,67 @@ inline void flashRedLed(uint16_t ms = 120)
   digitalWrite(PIN_LED_RED, HIGH); // start flash
 }
 
-// ---------- VOLUME ENCODER ----------
-volatile uint8_t v_q_last = 0;
-volatile int32_t v_edges = 0;
-int16_t volumePct = 50; // 0..100
-bool isMuted = false;
-int16_t muteRestoreVolume = 50; // last non-zero volume to restore
-
-inline uint8_t fastReadAB_vol()
-{
-  return (uint8_t(digitalRead(PIN_VOL_A)) << 1) | uint8_t(digitalRead(PIN_VOL_B));
-}
-
-void IRAM_ATTR volISR()
-{
-  uint8_t now = fastReadAB_vol();
-  uint8_t idx = (v_q_last << 2) | now;
-  int8_t d = QDEC_TAB[idx];
-  if (d)
-    v_edges += d;
-  v_q_last = now;
-}
-
 // ---------- Discovery helpers ----------
 static bool tryConnectQuick(IPAddress host)
 {
   WiFiClient probe;
-  bool ok = probe.connect(host, CAT_PORT, TCP_CONNECT_TIMEOUT_MS);
+  bool ok = probe.connect(host, radioPort, TCP_CONNECT_TIMEOUT_MS);
   probe.stop();
   return ok;
 }
+// Backend id in the host cache (the CAT host is the SmartSDR PC, the API host the radio)
+enum BackendId : uint8_t
+{
+  BACKEND_CAT = 0,
+  BACKEND_API = 1
+};
+static uint8_t backendId()
+{
+  return radio == &apiBackend ? BACKEND_API : BACKEND_CAT;
+}
+// Probe the subnet with several connects in flight, likely hosts first
+static void prepareScan(SubnetProbe &probe)
+{
+  probe.begin(WiFi.localIP(), radioPort, PROBE_TIMEOUT_MS);
+  probe.addNeighbours(WiFi.gatewayIP(), PROBE_GATEWAY_RADIUS);
+  probe.addArpTable();
+  probe.sweep(WiFi.subnetMask(), SCAN_WIDE_SUBNETS);
+}
 static bool scanFirstOpen(IPAddress &found)
 {
-  IPAddress me = WiFi.localIP();
-  IPAddress net(me[0], me[1], me[2], 0);
-  delay(100);
-  for (int last = 1; last <= 254; last++)
-  {
-    if (last == (int)me[3])
-      continue;
-    IPAddress ip(net[0], net[1], net[2], last);
-    Serial.print("Trying IP: ");
-    Serial.println(ip);
-    digitalWrite(PIN_LED_RED, HIGH);
-    digitalWrite(PIN_LED_GREEN, LOW);
-    if (tryConnectQuick(ip))
-    {
-      found = ip;
-      return true;
-      ledsOff();
-    }
-    delay(50);
-    digitalWrite(PIN_LED_RED, LOW);
-    digitalWrite(PIN_LED_GREEN, HIGH);
-    delay(80);
-  }
+  SubnetProbe probe;
+  prepareScan(probe);
+
+  digitalWrite(PIN_LED_RED, HIGH); // scanning
+  digitalWrite(PIN_LED_GREEN, HIGH);
+  bool ok = probe.run(found, SCAN_BUDGET_MS);
   ledsOff();
-  return false;
+
+  Trace::log(TR_SCAN_DONE, probe.probed(), probe.elapsedMs());
+  return ok;
 }
 // ---------- FlexRadio Discovery ----------
+// One blocking connect attempt, no delays (boot path)
+static bool connectOnce(const IPAddress &host)
+{
+  if (radio->connected())
+    radio->stop();
+
+  traceHost(TR_CAT_CONNECTING, host);
+  uint32_t t0 = millis();
+  if (!radio->connect(host, radioPort, TCP_CONNECT_TIMEOUT_MS))
+    return false;
+  lastConnectMs = millis() - t0;
+  Trace::log(TR_CAT_CONNECTED, lastConnectMs);
+  ledGreenSolid(); // ✅ solid green when CAT is up
+  return true;
+}
+
+// Up to four attempts with backoff (boot only: blocks for seconds)
 bool tryConnectHost(const IPAddress &host)
 {
-  if (cat.connected())
-    cat.stop();
+  if (radio->connected())
+    radio->stop();
   delay(120);
 
   const uint16_t backoff[] = {600, 1200, 2000, 3500};
@@ -371,17 +540,9 @@ bool tryConnectHost(const IPAddress &host)
     delay(120);
     ledsOff();
 
-    Serial.printf("[CAT] Connecting %s:%u (try %u/4)\n",
-                  host.toString().c_str(), CAT_PORT, i + 1);
-
-    if (cat.connect(host, CAT_PORT, TCP_CONNECT_TIMEOUT_MS))
-    {
-      cat.setNoDelay(true);
-      cat.setTimeout(1200);
-      Serial.println("[CAT] Connected.");
-      ledGreenSolid(); // ✅ solid green when CAT is up
+    Trace::log(TR_CAT_TRY, i + 1);
+    if (connectOnce(host))
       return true;
-    }
 
     // connection failed -> alternate-blink during backoff window
     blinkAlt(backoff[i]); // ⏳ replaces delay(backoff[i])
@@ -391,480 +552,678 @@ bool tryConnectHost(const IPAddress &host)
   ledRedSolid(); // ❌ solid red (you reboot after this anyway)
   return false;
 }
-bool catConnect()
+// Hosts one discovered radio points at: the radio itself for the TCP API,
+// its SmartSDR clients (where the CAT server runs) for CAT
+static uint8_t discoveredHosts(const FlexRadioInfo &r, IPAddress *out)
 {
-  String cached = prefs.getString("host", "");
-  if (cached.length())
+  uint8_t n = 0;
+  if (radio == &apiBackend)
+    out[n++] = r.ip;
+  else
+    for (uint8_t k = 0; k < r.clientCount; k++)
+      out[n++] = r.clients[k];
+  return n;
+}
+
+// Boot: wait for a broadcast, then try what it points at
+static bool connectDiscovered(uint32_t waitMs)
+{
+  if (!discovery.waitForRadio(waitMs))
   {
-    IPAddress ip;
-    if (ip.fromString(cached))
-    {
-      Serial.printf("[CACHE] Trying cached host: %s\n", cached.c_str());
+    Trace::log(TR_DISC_NONE);
+    return false;
+  }
+
+  for (uint8_t i = 0; i < discovery.count(); i++)
+  {
+    const FlexRadioInfo &r = discovery.radio(i);
+    char info[64];
+    snprintf(info, sizeof(info), "%s '%s' (%s)", r.model, r.nickname, r.status);
+    traceHost(TR_DISC_RADIO, r.ip);
+    Trace::text(TR_DISC_INFO, info);
 
-      if (tryConnectHost(ip))
+    IPAddress candidates[1 + FlexRadioInfo::MAX_CLIENTS];
+    uint8_t n = discoveredHosts(r, candidates);
+    for (uint8_t k = 0; k < n; k++)
+    {
+      if (tryConnectQuick(candidates[k]) && tryConnectHost(candidates[k]))
       {
-        currentHost = ip;
+        currentHost = candidates[k];
         return true;
       }
-      Serial.println("[CACHE] Cached host failed.");
     }
   }
+  Trace::text(TR_DISC_NOT_FOUND, radio->name());
+  return false;
+}
+
+// Boot: race the hosts that worked before, the first to accept wins
+// (ties go to the better-ranked one, it is started first)
+static bool connectKnownHost()
+{
+  IPAddress known[HostCache::MAX_HOSTS];
+  uint8_t n = hostCache.candidates(backendId(), radioPort, known, HostCache::MAX_HOSTS);
+  if (n == 0)
+    return false;
+
+  SubnetProbe race;
+  race.begin(WiFi.localIP(), radioPort, KNOWN_HOST_TIMEOUT_MS);
+  for (uint8_t i = 0; i < n; i++)
+    race.add(known[i]);
 
-  Serial.println("[SCAN] Scanning subnet for CAT (TCP 5002) ...");
+  IPAddress winner;
+  if (!race.run(winner, KNOWN_HOST_TIMEOUT_MS + 100))
+  {
+    for (uint8_t i = 0; i < n; i++)
+      hostCache.noteFailure(known[i], radioPort, backendId());
+    Trace::log(TR_CACHE_NONE, n);
+    return false;
+  }
+
+  traceHost(TR_CACHE_ANSWERED, winner);
+  Trace::log(TR_CACHE_RACE, n, race.elapsedMs());
+  if (tryConnectHost(winner))
+  {
+    currentHost = winner;
+    return true;
+  }
+  hostCache.noteFailure(winner, radioPort, backendId());
+  return false;
+}
+
+bool catConnect()
+{
+  if (connectKnownHost())
+    return true;
+
+  if (connectDiscovered(DISCOVERY_WAIT_MS))
+    return true;
+
+  // last resort (radio not broadcasting here, CAT on another PC)
+  Trace::log(TR_SCAN_START, radioPort);
   IPAddress found;
   if (scanFirstOpen(found))
   {
-    Serial.printf("[SCAN] Found CAT at %s\n", found.toString().c_str());
+    traceHost(TR_SCAN_ANSWERED, found);
     if (tryConnectHost(found))
     {
       currentHost = found;
       return true;
     }
   }
-  Serial.println("[SCAN] No CAT found.");
+  Trace::text(TR_SCAN_NONE, radio->name());
+  hostCache.save(prefs); // keep the failure counts
   return false;
 }
 void saveCurrentHostIfNeeded()
 {
-  String cached = prefs.getString("host", "");
-  String nowStr = currentHost.toString();
-  if (cached != nowStr)
-  {
-    prefs.putString("host", nowStr);
-    Serial.printf("[SAVE] Stored CAT host: %s\n", nowStr.c_str());
-  }
+  hostCache.noteSuccess(currentHost, radioPort, backendId(), lastConnectMs);
+  if (hostCache.save(prefs)) // only when the ranking changed
+    traceHost(TR_SAVE_RANKING, currentHost);
 }
-// ---------------------------------------
 
-bool readLine(String &out, uint32_t waitMs)
+// Older firmware kept exactly one host string per backend: import it once
+static void importLegacyHost(const char *key, uint8_t backend, uint16_t port)
 {
-  uint32_t t0 = millis();
-  while (millis() - t0 < waitMs)
+  String legacy = prefs.getString(key, "");
+  IPAddress ip;
+  if (legacy.length() && ip.fromString(legacy))
+    hostCache.noteSuccess(ip, port, backend, 0);
+  if (prefs.isKey(key))
+    prefs.remove(key);
+}
+
+// ---------- Reconnect state machine ----------
+// One short step per loop() pass, so the knobs stay live while the link
+// is down: probes run in slices of RECONNECT_SCAN_SLICE_MS, the backend
+// connect is started and then polled. The knobs keep writing the desired
+// state; once the link is back only the final value of each changed
+// setting is sent.
+enum LinkState : uint8_t
+{
+  LINK_UP,
+  LINK_BACKOFF,        // waiting for the next round
+  LINK_TRY_CURRENT,    // the host we just lost
+  LINK_TRY_KNOWN,      // race the host cache
+  LINK_TRY_DISCOVERED, // hosts from discovery broadcasts
+  LINK_PROBE,          // linkProbe running, in slices
+  LINK_CONNECTING      // backend connect in flight, polled
+};
+// Candidate list a probe or connect came from (decides what comes next)
+enum LinkStage : uint8_t
+{
+  STAGE_CURRENT,
+  STAGE_KNOWN,
+  STAGE_DISCOVERED,
+  STAGE_SCAN
+};
+static const TraceId STAGE_ANSWERED[] = {TR_LINK_ANSWERED, TR_CACHE_ANSWERED, TR_DISC_ANSWERED,
+                                         TR_SCAN_ANSWERED};
+LinkState linkState = LINK_UP;
+LinkStage linkStage = STAGE_CURRENT;
+uint32_t linkDownSinceMs = 0;
+uint32_t linkNextTryMs = 0;
+uint8_t linkRound = 0;
+uint16_t rebootBudgetS = RECONNECT_REBOOT_BUDGET_S; // Preferences "rcbudget"
+SubnetProbe linkProbe;
+IPAddress linkTarget;
+uint32_t linkConnectStartMs = 0;
+uint16_t standbyPort = 0; // Preferences "sbport"; 0 = no warm standby
+
+// Warm standby: a second CAT port on the same host, or, with the same
+// port as the primary, the next known host. The backend fails over to it
+// by itself; the reconnect machine only runs if both are gone.
+static void configureStandby()
+{
+  if (!standbyPort)
+  {
+    radio->setStandby(IPAddress(), 0);
+    return;
+  }
+
+  IPAddress host = currentHost;
+  if (standbyPort == radioPort)
   {
-    if (cat.available())
+    IPAddress known[HostCache::MAX_HOSTS];
+    uint8_t n = hostCache.candidates(backendId(), radioPort, known, HostCache::MAX_HOSTS);
+    uint8_t i = 0;
+    while (i < n && known[i] == currentHost)
+      i++;
+    if (i == n)
     {
-      String s = cat.readStringUntil(';');
-      if (s.length())
-      {
-        out = s + ';';
-        return true;
-      }
+      Trace::log(TR_LINK_SB_NONE);
+      radio->setStandby(IPAddress(), 0);
+      return;
     }
-    delay(2);
-    yield();
+    host = known[i];
   }
-  return false;
-}
 
-bool sendFA(uint32_t hz)
-{
-  if (!cat.connected())
-    return false;
-  char digits[16];
-  snprintf(digits, sizeof(digits), "%011u", hz);
-  char cmd[24];
-  snprintf(cmd, sizeof(cmd), "FA%s;", digits);
-  Serial.print(">> ");
-  Serial.println(cmd);
-  if (webDebug)
+  if (!radio->setStandby(host, standbyPort))
   {
-    String debugMessage = String(">> ") + cmd;
-    logPrintln(debugMessage);
+    Trace::text(TR_LINK_SB_UNAVAILABLE, radio->name());
+    return;
   }
-  return cat.print(cmd) == (int)strlen(cmd);
+  if (standbyPort == radioPort)
+    traceHost(TR_LINK_SB_HOST, host);
+  else
+    Trace::log(TR_LINK_SB_PORT, standbyPort);
 }
 
-// ----- Filter preset (ZZFI) -----
-bool sendFilterPreset(uint8_t idx)
+static void linkBackoff()
+{
+  uint32_t base = RECONNECT_BACKOFF_MIN_MS << (linkRound < 4 ? linkRound : 4);
+  uint32_t jitter = base / 4; // so several knobs don't hammer a restarting PC in step
+  linkNextTryMs = millis() + base - jitter + (uint32_t)random((long)(2 * jitter + 1));
+  if (linkRound < 255)
+    linkRound++;
+  linkState = LINK_BACKOFF;
+}
+
+static void onLinkDown()
 {
-  if (!cat.connected())
+  radioState.invalidate(); // nothing the radio said before still counts
+  linkDownSinceMs = millis();
+  linkRound = 0;
+  linkBackoff();
+
+  Trace::log(TR_LINK_DOWN);
+}
+
+static void onLinkUp()
+{
+  linkProbe.cancel();
+  linkState = LINK_UP;
+  saveCurrentHostIfNeeded();
+  configureStandby();
+
+  // what the knobs did meanwhile wins over the radio's old values
+  uint8_t replay = radioState.takeReplay();
+  uint8_t replayed = 0;
+  for (uint8_t p = 0; p < RADIO_PARAM_COUNT; p++)
   {
-    Serial.printf("[FILT] Cannot set filter preset to %u – CAT not connected.\n", idx);
-    if (webDebug)
-    {
-      String msg = "[FILT] Cannot set filter preset to ";
-      msg += String(idx);
-      msg += " – CAT not connected.";
-      logPrintln(msg);
-    }
-    return false;
+    if (!(replay & (1 << p)))
+      continue;
+    radio->set((RadioParam)p, radioState.get((RadioParam)p));
+    replayed++;
   }
+  resyncKeepLocal = replay;
+  resyncFromRadio(); // everything else: the radio's values
 
-  uint8_t requested = idx;
-  if (idx > 7)
-    idx = 7;
+  Trace::log(TR_LINK_BACK, millis() - linkDownSinceMs, replayed);
+}
 
-  if (idx != requested)
+// Current stage found nothing: on to the next one, or wait for the next round
+static void linkNextStage()
+{
+  switch (linkStage)
   {
-    Serial.printf("[FILT] Requested preset %u, clamped to %u (valid range 0–7).\n", requested, idx);
-    if (webDebug)
+  case STAGE_CURRENT:
+    linkState = LINK_TRY_KNOWN;
+    break;
+  case STAGE_KNOWN:
+    linkState = LINK_TRY_DISCOVERED;
+    break;
+  case STAGE_DISCOVERED:
+    if (linkRound % RECONNECT_SCAN_EVERY == 1)
     {
-      String msg = "[FILT] Requested preset ";
-      msg += String(requested);
-      msg += ", clamped to ";
-      msg += String(idx);
-      msg += " (valid range 0–7).";
-      logPrintln(msg);
+      prepareScan(linkProbe);
+      linkStage = STAGE_SCAN;
+      linkState = LINK_PROBE;
     }
+    else
+      linkBackoff();
+    break;
+  default:
+    linkBackoff();
+    break;
   }
+}
+
+static void startLinkConnect(const IPAddress &host, LinkStage stage)
+{
+  if (radio->connected())
+    radio->stop();
+  traceHost(TR_CAT_CONNECTING, host);
+  linkStage = stage;
+  linkTarget = host;
+  linkConnectStartMs = millis();
+  radio->beginConnect(host, radioPort, TCP_CONNECT_TIMEOUT_MS);
+  linkState = LINK_CONNECTING;
+}
 
-  char cmd[16];
-  snprintf(cmd, sizeof(cmd), "ZZFI%02u;", idx);
+// Race the host cache; false if it is empty
+static bool startKnownProbe()
+{
+  IPAddress known[HostCache::MAX_HOSTS];
+  uint8_t n = hostCache.candidates(backendId(), radioPort, known, HostCache::MAX_HOSTS);
+  if (n == 0)
+    return false;
+  linkProbe.begin(WiFi.localIP(), radioPort, KNOWN_HOST_TIMEOUT_MS);
+  for (uint8_t i = 0; i < n; i++)
+    linkProbe.add(known[i]);
+  linkStage = STAGE_KNOWN;
+  linkState = LINK_PROBE;
+  return true;
+}
 
-  // High-level intent
-  Serial.printf("[FILT] Setting filter preset index to %u (%s)\n", idx, cmd);
-  if (webDebug)
+// Probe what the discovery table points at (kept fresh by discovery.service())
+static bool startDiscoveredProbe()
+{
+  linkProbe.begin(WiFi.localIP(), radioPort, TCP_CONNECT_TIMEOUT_MS);
+  uint8_t total = 0;
+  for (uint8_t i = 0; i < discovery.count(); i++)
   {
-    String msg = "[FILT] Setting filter preset index to ";
-    msg += String(idx);
-    msg += " (";
-    msg += cmd;
-    msg += ")";
-    logPrintln(msg);
+    IPAddress hosts[1 + FlexRadioInfo::MAX_CLIENTS];
+    uint8_t n = discoveredHosts(discovery.radio(i), hosts);
+    for (uint8_t k = 0; k < n; k++)
+      linkProbe.add(hosts[k]);
+    total += n;
   }
+  if (total == 0)
+    return false;
+  linkStage = STAGE_DISCOVERED;
+  linkState = LINK_PROBE;
+  return true;
+}
 
-  // Raw CAT command
-  Serial.print(">> ");
-  Serial.println(cmd);
-  if (webDebug)
+void serviceLink()
+{
+  uint32_t now = millis();
+  if (linkState == LINK_UP)
   {
-    String debugMessage = ">> ";
-    debugMessage += cmd;
-    logPrintln(debugMessage);
+    if (!radio->connected())
+      onLinkDown();
+    return;
   }
 
-  bool ok = (cat.print(cmd) == (int)strlen(cmd));
-  if (!ok)
+  if (rebootBudgetS && now - linkDownSinceMs > (uint32_t)rebootBudgetS * 1000UL)
   {
-    Serial.println("[FILT] ERROR: Failed to send ZZFI command over CAT.");
-    if (webDebug)
-      logPrintln("[FILT] ERROR: Failed to send ZZFI command over CAT.");
+    Trace::log(TR_LINK_REBOOT, rebootBudgetS);
+    hostCache.save(prefs);
+    delay(500);
+    rebootESP();
   }
-  else
+
+  switch (linkState)
   {
-    Serial.println("[FILT] Filter preset command sent successfully.");
-    if (webDebug)
-      logPrintln("[FILT] Filter preset command sent successfully.");
-  }
+  case LINK_BACKOFF:
+    if ((int32_t)(now - linkNextTryMs) >= 0)
+      linkState = LINK_TRY_CURRENT;
+    break;
 
-  return ok;
-}
+  case LINK_TRY_CURRENT:
+    if ((uint32_t)currentHost == 0)
+      linkState = LINK_TRY_KNOWN;
+    else
+      startLinkConnect(currentHost, STAGE_CURRENT);
+    break;
 
-void readFilterPresetOnce()
-{
-  if (!cat.connected())
-    return;
-  cat.print("ZZFI;");
-  String line;
-  if (readLine(line, 800) && line.startsWith("ZZFI") && line.endsWith(";") && line.length() >= 6)
-  {
-    filterIdx = line.substring(4, line.length() - 1).toInt();
-    if (filterIdx < 0)
-      filterIdx = 0;
-    if (filterIdx > 7)
-      filterIdx = 7;
-    Serial.printf("[FILTER] Current preset = %d\n", filterIdx);
-    if (webDebug)
+  case LINK_TRY_KNOWN:
+    if (!startKnownProbe())
     {
-      String debugMessage = "[FILTER] Current preset = " + String(filterIdx) + "\n";
-      logPrintln(debugMessage);
+      linkStage = STAGE_KNOWN;
+      linkNextStage();
     }
-  }
-  else
-  {
-    Serial.println("[FILTER] No reply; defaulting to 0");
+    break;
 
-    if (webDebug)
+  case LINK_TRY_DISCOVERED:
+    if (!startDiscoveredProbe())
     {
-      logPrintln("[FILTER] No reply; defaulting to 0");
+      linkStage = STAGE_DISCOVERED;
+      linkNextStage();
     }
+    break;
 
-    filterIdx = 0;
-  }
-}
-
-// ----- Volume (Flex ZZAGnnn; 000..100) -----
-bool setVolumeA(uint8_t lvl)
-{
-  if (!cat.connected())
+  case LINK_PROBE:
   {
-    Serial.printf("[VOL] Cannot set volume to %u%% – CAT not connected.\n", lvl);
-    if (webDebug)
+    IPAddress found;
+    if (linkProbe.run(found, RECONNECT_SCAN_SLICE_MS))
     {
-      String msg = "[VOL] Cannot set volume to ";
-      msg += String(lvl);
-      msg += "% – CAT not connected.";
-      logPrintln(msg);
+      traceHost(STAGE_ANSWERED[linkStage], found);
+      Trace::log(TR_LINK_PROBED, linkProbe.probed(), linkProbe.elapsedMs());
+      startLinkConnect(found, linkStage);
     }
-    return false;
+    else if (linkProbe.exhausted())
+    {
+      if (linkStage == STAGE_KNOWN)
+      {
+        IPAddress known[HostCache::MAX_HOSTS];
+        uint8_t n = hostCache.candidates(backendId(), radioPort, known, HostCache::MAX_HOSTS);
+        for (uint8_t i = 0; i < n; i++)
+          hostCache.noteFailure(known[i], radioPort, backendId());
+      }
+      linkNextStage();
+    }
+    break;
   }
 
-  uint8_t requested = lvl;
-  if (lvl > 100)
-    lvl = 100;
-
-  if (lvl != requested)
-  {
-    Serial.printf("[VOL] Requested %u%%, clamped to %u%%.\n", requested, lvl);
-    if (webDebug)
+  case LINK_CONNECTING:
+    switch (radio->pollConnect())
     {
-      String msg = "[VOL] Requested ";
-      msg += String(requested);
-      msg += "%, clamped to ";
-      msg += String(lvl);
-      msg += "%.";
-      logPrintln(msg);
+    case RADIO_CONNECT_PENDING:
+      break;
+    case RADIO_CONNECT_UP:
+      lastConnectMs = millis() - linkConnectStartMs;
+      Trace::log(TR_CAT_CONNECTED, lastConnectMs);
+      ledGreenSolid(); // ✅ solid green when CAT is up
+      currentHost = linkTarget;
+      onLinkUp();
+      break;
+    default:
+      hostCache.noteFailure(linkTarget, radioPort, backendId());
+      linkNextStage();
+      break;
     }
+    break;
+
+  default:
+    break;
   }
+}
+// ---------------------------------------
 
-  char cmd[16];
-  snprintf(cmd, sizeof(cmd), "ZZAG%03u;", lvl);
+bool sendFA(uint32_t hz)
+{
+  radioState.want(RADIO_FREQ, hz); // offline too: replayed on reconnect
+  if (!radio->connected())
+    return false;
+  radio->set(RADIO_FREQ, hz); // newest value wins, sent on the next tick
+  return true;
+}
 
-  // High-level intent
-  Serial.printf("[VOL] Setting AF gain to %u%% (%s)\n", lvl, cmd);
-  if (webDebug)
-  {
-    String msg = "[VOL] Setting AF gain to ";
-    msg += String(lvl);
-    msg += "% (";
-    msg += cmd;
-    msg += ")";
-    logPrintln(msg);
-  }
+// ----- Filter preset (ZZFI) -----
+bool sendFilterPreset(uint8_t idx)
+{
+  uint8_t requested = idx;
+  if (idx > 7)
+    idx = 7;
+
+  if (idx != requested)
+    Trace::log(TR_FILT_CLAMPED, requested, idx);
 
-  // Raw CAT command
-  Serial.print(">> ");
-  Serial.println(cmd);
-  if (webDebug)
+  radioState.want(RADIO_FILTER, idx);
+  if (!radio->connected())
   {
-    String debugMessage = ">> ";
-    debugMessage += cmd;
-    logPrintln(debugMessage);
+    Trace::log(TR_FILT_OFFLINE, idx);
+    return false;
   }
 
-  bool ok = (cat.print(cmd) == (int)strlen(cmd));
-  if (!ok)
+  // Goes out with the next backend tick (newer values overwrite it)
+  Trace::log(TR_FILT_SET, idx);
+  radio->set(RADIO_FILTER, idx);
+  return true;
+}
+
+static void onFilterPresetReply(int32_t value)
+{
+  // value: preset from the radio, -1 = no reply in time
+  if (value >= 0)
   {
-    Serial.println("[VOL] ERROR: Failed to send ZZAG command over CAT.");
-    if (webDebug)
-      logPrintln("[VOL] ERROR: Failed to send ZZAG command over CAT.");
+    if (value > 7)
+      value = 7;
+    radioState.adopt(RADIO_FILTER, value);
+    Trace::log(TR_FILT_REPLY, value);
   }
   else
   {
-    Serial.println("[VOL] Volume command sent successfully.");
-    if (webDebug)
-      logPrintln("[VOL] Volume command sent successfully.");
+    Trace::log(TR_FILT_NO_REPLY);
+    radioState.want(RADIO_FILTER, 0);
   }
-
-  return ok;
 }
 
-int readVolumeA()
+// ----- Volume (Flex ZZAGnnn; 000..100) -----
+bool setVolumeA(uint8_t lvl)
 {
-  // returns 0..100 or -1 on fail
-  if (!cat.connected())
-  {
-    Serial.println("[VOL] Cannot read volume – CAT not connected.");
-    if (webDebug)
-      logPrintln("[VOL] Cannot read volume – CAT not connected.");
-    return -1;
-  }
-
-  // Log query
-  Serial.println("[VOL] Querying current AF gain (ZZAG;)");
-  if (webDebug)
-    logPrintln(">> ZZAG;");
+  uint8_t requested = lvl;
+  if (lvl > 100)
+    lvl = 100;
 
-  // Send query
-  cat.print("ZZAG;");
+  if (lvl != requested)
+    Trace::log(TR_VOL_CLAMPED, requested, lvl);
 
-  String line;
-  if (!readLine(line, 800))
+  radioState.want(RADIO_AFGAIN, lvl);
+  if (!radio->connected())
   {
-    Serial.println("[VOL] No reply to ZZAG; within 800 ms.");
-    if (webDebug)
-      logPrintln("[VOL] No reply to ZZAG; within 800 ms.");
-    return -1; // timeout
+    Trace::log(TR_VOL_OFFLINE, lvl);
+    return false;
   }
 
-  // Log raw reply
-  Serial.print("[VOL] Raw reply: ");
-  Serial.println(line);
-  if (webDebug)
+  // Goes out with the next backend tick (newer values overwrite it)
+  Trace::log(TR_VOL_SET, lvl);
+  radio->set(RADIO_AFGAIN, lvl);
+  return true;
+}
+
+static void onVolumeReply(int32_t value)
+{
+  // value: AF gain from the radio, -1 = no reply in time
+  if (value < 0)
   {
-    String debugMessage = "<< " + line;
-    logPrintln(debugMessage);
+    Trace::log(TR_VOL_NO_REPLY);
+    return;
   }
 
-  // Expect "ZZAGnnn;"
-  if (!line.startsWith("ZZAG") || !line.endsWith(";"))
+  if (value > 100)
   {
-    Serial.println("[VOL] Unexpected reply format (expected 'ZZAGnnn;').");
-    if (webDebug)
-      logPrintln("[VOL] Unexpected reply format (expected 'ZZAGnnn;').");
-    return -1;
+    Trace::log(TR_VOL_RANGE, value);
+    return;
   }
 
-  String numStr = line.substring(4, line.length() - 1);
-  int value = numStr.toInt();
+  Trace::log(TR_VOL_REPLY, value);
 
-  if (value < 0 || value > 100)
-  {
-    Serial.printf("[VOL] Parsed volume out of range: %d (from '%s')\n", value, numStr.c_str());
-    if (webDebug)
-    {
-      String msg = "[VOL] Parsed volume out of range: ";
-      msg += String(value);
-      msg += " (from '";
-      msg += numStr;
-      msg += "')";
-      logPrintln(msg);
-    }
-    return -1;
-  }
+  radioState.adopt(RADIO_AFGAIN, value);
+  if (value > 0)
+    radioState.restoreVolume = value; // remember for unmute
+}
 
-  Serial.printf("[VOL] Parsed current AF gain: %d%%\n", value);
-  if (webDebug)
+// ----- Sync VFO from radio -----
+static void onInitialSyncReply(int32_t hz)
+{
+  if (hz < 0)
   {
-    String msg = "[VOL] Parsed current AF gain: ";
-    msg += String(value);
-    msg += "%";
-    logPrintln(msg);
+    Trace::log(TR_SYNC_NO_FA);
+    sendFA(radioState.get(RADIO_FREQ));
+    return;
   }
+  radioState.adopt(RADIO_FREQ, hz);
+  vfoEnc->resync();
+  vfoDetents.reset(vfoEnc->edges());
+  Trace::log(TR_SYNC_START, hz / 1000000, hz % 1000000);
+}
 
-  return value;
+static const RadioParam RESYNC_PARAMS[] = {RADIO_FREQ, RADIO_FILTER, RADIO_AFGAIN, RADIO_MODE};
+
+static void onResyncSnapshot(const RadioSnapshot &s)
+{
+  bool complete = s.complete(RESYNC_PARAMS, 4);
+  Trace::log(complete ? TR_SYNC_ANSWERED : TR_SYNC_INCOMPLETE, s.elapsedMs);
+
+  // settings replayed after a reconnect keep our value; the answer only confirms
+  uint8_t keep = resyncKeepLocal;
+  resyncKeepLocal = 0;
+  for (uint8_t p = 0; p < RADIO_PARAM_COUNT; p++)
+    if ((keep & (1 << p)) && s.has((RadioParam)p))
+      radioState.confirm((RadioParam)p, s.get((RadioParam)p));
+
+  if (!(keep & (1 << RADIO_FREQ)))
+    onInitialSyncReply(s.get(RADIO_FREQ));
+  if (!(keep & (1 << RADIO_FILTER)))
+    onFilterPresetReply(s.get(RADIO_FILTER));
+  if (!(keep & (1 << RADIO_AFGAIN)))
+    onVolumeReply(s.get(RADIO_AFGAIN));
+  if (!(keep & (1 << RADIO_MODE)) && s.has(RADIO_MODE))
+    radioState.adopt(RADIO_MODE, s.get(RADIO_MODE));
 }
 
-// ----- Sync VFO from radio -----
-bool initialSyncFromRadio()
+bool resyncFromRadio()
 {
-  if (!cat.connected())
+  if (!radio->connected())
     return false;
-  cat.print("FA;");
-  String line;
-  if (!readLine(line, 1500))
-    return false;
-  if (!line.startsWith("FA") || line.length() < 14)
+
+  // one round trip, one deadline
+  return radio->query(RESYNC_PARAMS, 4, 1500, onResyncSnapshot);
+}
+
+// ----- Incoming reports -----
+// Values the radio reported (SmartSDR changes, echoes, poll answers).
+// Every report confirms the shadow. One that disagrees with what we want,
+// isn't ours still on its way out and isn't a late echo of an older write
+// of ours is an external change and wins.
+
+static bool isExternal(RadioParam p, int32_t value)
+{
+  if (value == radioState.get(p) || radio->pending(p))
     return false;
-  String d = line.substring(2, 13);
-  vfoHz = (uint32_t)d.toInt();
-  lastSentHz = vfoHz;
-  noInterrupts();
-  q_edges = 0;
-  detentPending = 0;
-  vfo_q_last = fastReadAB();
-  interrupts();
-  Serial.printf("[SYNC] Start at %.6f MHz\n", vfoHz / 1e6);
+  // e.g. an FA answer for a step the spinning knob has already passed;
+  // matched against what the backend actually wrote, not every set()
+  return !radio->sentRecently(p, value, OWN_ECHO_WINDOW_MS);
+}
+
+static void onRadioFrequency(int32_t value)
+{
+  radioState.confirm(RADIO_FREQ, value);
 
-  if (webDebug)
+  if (isExternal(RADIO_FREQ, value))
   {
-    String debugMessage = "[SYNC] Start at ";
-    debugMessage += String(vfoHz / 1e6, 6); // 6 decimal places
-    debugMessage += " MHz";
-    logPrintln(debugMessage); // assumes it adds newline
+    radioState.adopt(RADIO_FREQ, value);
+    radio->cancel(RADIO_FREQ); // don't push an older local value back
+    needResetEncoderBaseline = true;
+
+    Trace::log(TR_EXT_FREQ, value / 1000000, value % 1000000);
   }
+}
 
-  return true;
+static void onRadioMode(int32_t value)
+{
+  radioState.confirm(RADIO_MODE, value);
+  if (!isExternal(RADIO_MODE, value))
+    return;
+
+  radioState.adopt(RADIO_MODE, value);
+
+  Trace::log(TR_EXT_MODE, value);
 }
 
-// ----- Incoming CAT pump -----
-void pumpIncoming()
+static void onRadioFilter(int32_t value)
 {
-  while (cat.connected() && cat.available())
-  {
-    String s = cat.readStringUntil(';');
-    if (!s.length())
-      break;
+  if (value < 0 || value > 7)
+    return;
+  radioState.confirm(RADIO_FILTER, value);
+  if (!isExternal(RADIO_FILTER, value))
+    return;
 
-    s += ';'; // restore the ';' so we see the full CAT command
+  radioState.adopt(RADIO_FILTER, value);
 
-    if (s == "?;")
-    {
-      // Ignore but still show/log it
-      Serial.println("<< ?; (ignored)");
-      if (webDebug)
-      {
-        logPrintln("<< ?; (ignored)");
-      }
-    }
-    else if (s.startsWith("FA") && s.length() >= 14)
-    {
-      // FA + 11 digits + ';'
-      String d = s.substring(2, 13); // frequency digits only
-      uint32_t rxHz = (uint32_t)d.toInt();
-
-      // Log the raw CAT line
-      Serial.print("<< ");
-      Serial.println(s);
-      if (webDebug)
-      {
-        String debugMessage = "<< " + s;
-        logPrintln(debugMessage);
-      }
+  Trace::log(TR_EXT_FILTER, value);
+}
 
-      if (rxHz != vfoHz)
-      {
-        vfoHz = rxHz;
-        lastSentHz = rxHz;
-        needResetEncoderBaseline = true;
-
-        Serial.printf("[EXT] Radio → %.6f MHz (sync)\n", vfoHz / 1e6);
-        if (webDebug)
-        {
-          String debugMessage = "[EXT] Radio → ";
-          debugMessage += String(vfoHz / 1e6, 6); // 6 decimal places, MHz
-          debugMessage += " MHz (sync)";
-          logPrintln(debugMessage);
-        }
-      }
-    }
-    else
-    {
-      // Any other CAT line
-      Serial.print("<< ");
-      Serial.println(s);
+static void onRadioAfGain(int32_t value)
+{
+  if (value < 0 || value > 100)
+    return;
+  radioState.confirm(RADIO_AFGAIN, value);
+  if (!isExternal(RADIO_AFGAIN, value))
+    return;
 
-      if (webDebug)
-      {
-        String debugMessage = "<< " + s;
-        logPrintln(debugMessage);
-      }
-    }
+  radioState.adopt(RADIO_AFGAIN, value);
+  if (value > 0)
+  {
+    radioState.restoreVolume = value;
+    radioState.muted = false;
   }
+
+  Trace::log(TR_EXT_AFGAIN, value);
+}
+
+static void onRadioPower(int32_t value)
+{
+  // only kept for TUNE's restore value; no log, no action
+  if (value < 0 || value > 100)
+    return;
+  radioState.confirm(RADIO_POWER, value);
+  if (isExternal(RADIO_POWER, value))
+    radioState.adopt(RADIO_POWER, value);
+}
+
+// Dispatch table, indexed by RadioParam
+typedef void (*RadioValueHandler)(int32_t value);
+static const RadioValueHandler REPORT_HANDLERS[RADIO_PARAM_COUNT] = {
+    onRadioFrequency, // RADIO_FREQ
+    onRadioMode,      // RADIO_MODE
+    onRadioFilter,    // RADIO_FILTER
+    onRadioAfGain,    // RADIO_AFGAIN
+    onRadioPower,     // RADIO_POWER
+};
+
+static void onRadioReport(RadioParam param, int32_t value)
+{
+  if (param < RADIO_PARAM_COUNT && REPORT_HANDLERS[param])
+    REPORT_HANDLERS[param](value);
+}
+
+// Raw traffic from the backend: the hottest log path, so the bytes are only
+// copied into the trace ring here (the direction is the id, no formatting)
+// and the ">> " / "<< " line is built by the log task
+static void onRadioLog(RadioLogKind kind, const char *text, size_t len)
+{
+  static const TraceId IDS[] = {TR_RADIO_LINE, TR_RADIO_TX, TR_RADIO_RX};
+  Trace::text(IDS[kind], text, len);
+}
+
+// Drain everything the backend received (never blocks)
+void pumpIncoming()
+{
+  radio->service();
 }
 
 // ====== SIMPLE ACTIONS ======
 void setFrequencyHz(uint32_t hz)
 {
-  vfoHz = hz;
-
-  if (cat.connected())
-  {
-    if (sendFA(vfoHz))
-    {
-      lastSentHz = vfoHz;
-    }
-    else
-    {
-      Serial.println("[CAT] Send failed; stopping socket.");
-      if (webDebug)
-      {
-        logPrintln("[CAT] Send failed; stopping socket.");
-      }
-      cat.stop();
-    }
-  }
+  sendFA(hz);
 
   needResetEncoderBaseline = true;
 
-  Serial.printf("[ACTION] VFO set to %.6f MHz\n", vfoHz / 1e6);
-  if (webDebug)
-  {
-    String debugMessage = "[ACTION] VFO set to ";
-    debugMessage += String(vfoHz / 1e6, 6); // 6 decimal places, MHz
-    debugMessage += " MHz";
-    logPrintln(debugMessage); // newline added by logPrintln()
-  }
+  Trace::log(TR_FREQ_SET, hz / 1000000, hz % 1000000);
 }
 
 // --- implementation (place with your CAT helpers)
@@ -890,16 +1249,9 @@ static int mdCodeFromString(String m)
 bool setMode(const String &mode)
 {
   // 1) Guard: CAT must be connected
-  if (!cat.connected())
+  if (!radio->connected())
   {
-    Serial.printf("[MD] Cannot set mode to '%s' – CAT not connected.\n", mode.c_str());
-    if (webDebug)
-    {
-      String msg = "[MD] Cannot set mode to '";
-      msg += mode;
-      msg += "' – CAT not connected.";
-      logPrintln(msg);
-    }
+    Trace::text(TR_MD_OFFLINE, mode.c_str());
     return false;
   }
 
@@ -907,148 +1259,47 @@ bool setMode(const String &mode)
   int code = mdCodeFromString(mode);
   if (code < 0)
   {
-    Serial.printf("[MD] Requested mode '%s' is not mapped to any MD code. Ignoring.\n", mode.c_str());
-    if (webDebug)
-    {
-      String msg = "[MD] Requested mode '";
-      msg += mode;
-      msg += "' is not mapped to any MD code. Ignoring.";
-      logPrintln(msg);
-    }
+    Trace::text(TR_MD_UNMAPPED, mode.c_str());
     return false;
   }
 
-  // 3) Build CAT command (MDn;)
-  char cmd[12];
-  snprintf(cmd, sizeof(cmd), "MD%d;", code);
-
-  // 4) Log intent *before* sending
-  Serial.printf("[MD] Setting mode to '%s' (MD%d)\n", mode.c_str(), code);
-  Serial.print(">> ");
-  Serial.println(cmd);
-
-  if (webDebug)
-  {
-    String msg = "[MD] Setting mode to '";
-    msg += mode;
-    msg += "' (MD";
-    msg += String(code);
-    msg += ")";
-    logPrintln(msg);
-
-    String raw = ">> ";
-    raw += cmd;
-    logPrintln(raw); // raw CAT command line
-  }
-
-  // 5) Send and log result
-  bool ok = (cat.print(cmd) == (int)strlen(cmd));
-  if (!ok)
-  {
-    Serial.println("[MD] ERROR: Failed to send MD command over CAT.");
-    if (webDebug)
-      logPrintln("[MD] ERROR: Failed to send MD command over CAT.");
-  }
-  else
-  {
-    Serial.println("[MD] Mode command sent successfully.");
-    if (webDebug)
-      logPrintln("[MD] Mode command sent successfully.");
-  }
-
-  return ok;
-}
-
-int getMode()
-{ // reads current mode (MDn) -> n
-  if (!cat.connected())
-    return -1;
-
-  // Optional: log the query when webDebug is on
-  if (webDebug)
-  {
-    logPrintln(">> MD;");
-  }
-
-  cat.print("MD;");
-  String line;
-  if (!readLine(line, 800))
-    return -1; // expect "MDn;"
-
-  if (!line.startsWith("MD") || !line.endsWith(";"))
-    return -1;
-
-  if (webDebug)
-  {
-    String debugMessage = "<< " + line;
-    logPrintln(debugMessage);
-  }
-
-  return line.substring(2, line.length() - 1).toInt();
+  // 3) Goes out with the next backend tick (newer values overwrite it)
+  Trace::log(TR_MD_SET, code);
+  radioState.want(RADIO_MODE, code); // so the report/poll answer is not seen as external
+  radio->set(RADIO_MODE, code);
+  return true;
 }
 
 bool setPTT(bool on)
 {
-  if (!cat.connected())
+  if (!radio->connected())
   {
-    Serial.printf("[PTT] Cannot set PTT %s – CAT not connected.\n", on ? "ON" : "OFF");
-    if (webDebug)
-    {
-      String msg = "[PTT] Cannot set PTT ";
-      msg += on ? "ON" : "OFF";
-      msg += " – CAT not connected.";
-      logPrintln(msg);
-    }
+    Trace::text(TR_PTT_OFFLINE, on ? "ON" : "OFF");
     return false;
   }
 
-  const char *cmd = on ? "ZZTX1;" : "ZZTX0;";
-
-  // High-level intent log
-  Serial.printf("[PTT] Setting PTT %s (%s)\n", on ? "ON" : "OFF", cmd);
-  if (webDebug)
-  {
-    String msg = "[PTT] Setting PTT ";
-    msg += on ? "ON" : "OFF";
-    msg += " (";
-    msg += cmd;
-    msg += ")";
-    logPrintln(msg);
-  }
-
-  // Raw CAT command log
-  Serial.print(">> ");
-  Serial.println(cmd);
-  if (webDebug)
-  {
-    String debugMessage = ">> ";
-    debugMessage += cmd;
-    logPrintln(debugMessage); // logPrintln adds newline
-  }
-
-  bool ok = (cat.print(cmd) == (int)strlen(cmd));
-  if (!ok)
-  {
-    Serial.println("[PTT] ERROR: Failed to send ZZTX command over CAT.");
-    if (webDebug)
-      logPrintln("[PTT] ERROR: Failed to send ZZTX command over CAT.");
-  }
-  else
-  {
-    Serial.println("[PTT] PTT command sent successfully.");
-    if (webDebug)
-      logPrintln("[PTT] PTT command sent successfully.");
-  }
+  // Backend flushes queued mode/power changes (e.g. TUNE prep) before keying
+  // and refuses to key if it cannot; un-keying jumps every queue.
+  // Queue it before any logging.
+  bool ok = radio->setPtt(on);
+  if (!on)
+    txWatchdog.disarm();
+  else if (ok)
+    txWatchdog.arm((uint32_t)txMaxS * 1000UL);
+  if (ok)
+    digitalWrite(PIN_LED_RED, on ? HIGH : LOW); // red = the backend took the key
 
+  Trace::text(TR_PTT_SET, on ? "ON" : "OFF");
+  Trace::log(ok ? TR_PTT_SENT : TR_PTT_FAILED);
   return ok;
 }
 
-// Cleanly close CAT + Wi-Fi before rebooting (very small + safe)
+// Cleanly close the radio link + Wi-Fi before rebooting (very small + safe)
 inline void cleanCloseNet()
 {
-  if (cat.connected())
+  if (radio->connected())
   {
-    cat.stop(); // closes TCP with FIN
+    radio->stop(); // closes TCP with FIN
     delay(50);
   }
   WiFi.disconnect(true, true); // drop STA and forget current link
@@ -1058,16 +1309,9 @@ inline void cleanCloseNet()
 // --- RF Power via ZZPC (SmartSDR CAT)
 bool setPowerPct(uint8_t pct)
 {
-  if (!cat.connected())
+  if (!radio->connected())
   {
-    Serial.printf("[PWR] Cannot set power to %u%% – CAT not connected.\n", pct);
-    if (webDebug)
-    {
-      String msg = "[PWR] Cannot set power to ";
-      msg += String(pct);
-      msg += "% – CAT not connected.";
-      logPrintln(msg);
-    }
+    Trace::log(TR_PWR_OFFLINE, pct);
     return false;
   }
 
@@ -1077,248 +1321,63 @@ bool setPowerPct(uint8_t pct)
     pct = 100;
 
   if (pct != requested)
-  {
-    Serial.printf("[PWR] Requested %u%%, clamped to %u%%.\n", requested, pct);
-    if (webDebug)
-    {
-      String msg = "[PWR] Requested ";
-      msg += String(requested);
-      msg += "%, clamped to ";
-      msg += String(pct);
-      msg += "%.";
-      logPrintln(msg);
-    }
-  }
-
-  // Build command ZZPCnnn;
-  char cmd[12];
-  snprintf(cmd, sizeof(cmd), "ZZPC%03u;", pct);
-
-  // High-level intent
-  Serial.printf("[PWR] Setting RF power to %u%% (%s)\n", pct, cmd);
-  if (webDebug)
-  {
-    String msg = "[PWR] Setting RF power to ";
-    msg += String(pct);
-    msg += "% (";
-    msg += cmd;
-    msg += ")";
-    logPrintln(msg);
-  }
-
-  // Raw CAT command
-  Serial.print(">> ");
-  Serial.println(cmd);
-  if (webDebug)
-  {
-    String debugMessage = ">> ";
-    debugMessage += cmd;
-    logPrintln(debugMessage); // logPrintln adds newline
-  }
-
-  bool ok = (cat.print(cmd) == (int)strlen(cmd));
-  if (!ok)
-  {
-    Serial.println("[PWR] ERROR: Failed to send ZZPC command over CAT.");
-    if (webDebug)
-      logPrintln("[PWR] ERROR: Failed to send ZZPC command over CAT.");
-  }
-  else
-  {
-    Serial.println("[PWR] Power command sent successfully.");
-    if (webDebug)
-      logPrintln("[PWR] Power command sent successfully.");
-  }
+    Trace::log(TR_PWR_CLAMPED, requested, pct);
 
-  return ok;
+  // Goes out with the next backend tick (newer values overwrite it)
+  Trace::log(TR_PWR_SET, pct);
+  radioState.want(RADIO_POWER, pct);
+  radio->set(RADIO_POWER, pct);
+  return true;
 }
 
-int getPowerPct()
+int parsePowerPct(int32_t value)
 {
   // returns 0..100 or -1 on fail
-  if (!cat.connected())
-  {
-    Serial.println("[PWR] Cannot read power – CAT not connected.");
-    if (webDebug)
-      logPrintln("[PWR] Cannot read power – CAT not connected.");
-    return -1;
-  }
-
-  // Log query
-  Serial.println("[PWR] Querying current RF power (ZZPC;)");
-  if (webDebug)
-    logPrintln(">> ZZPC;");
-
-  // Send query
-  cat.print("ZZPC;");
-
-  String line;
-  if (!readLine(line, 800))
+  if (value < 0)
   {
-    Serial.println("[PWR] No reply to ZZPC; within 800 ms.");
-    if (webDebug)
-      logPrintln("[PWR] No reply to ZZPC; within 800 ms.");
+    Trace::log(TR_PWR_NO_REPLY);
     return -1; // timeout
   }
 
-  // Log raw reply
-  Serial.print("[PWR] Raw reply: ");
-  Serial.println(line);
-  if (webDebug)
-  {
-    String debugMessage = "<< " + line;
-    logPrintln(debugMessage);
-  }
-
-  // Expect "ZZPCnnn;"
-  if (!line.startsWith("ZZPC") || !line.endsWith(";"))
+  if (value > 100)
   {
-    Serial.println("[PWR] Unexpected reply format (expected 'ZZPCnnn;').");
-    if (webDebug)
-      logPrintln("[PWR] Unexpected reply format (expected 'ZZPCnnn;').");
+    Trace::log(TR_PWR_RANGE, value);
     return -1;
   }
 
-  String numStr = line.substring(4, line.length() - 1);
-  int value = numStr.toInt();
-
-  if (value < 0 || value > 100)
-  {
-    Serial.printf("[PWR] Parsed power value out of range: %d (from '%s')\n", value, numStr.c_str());
-    if (webDebug)
-    {
-      String msg = "[PWR] Parsed power value out of range: ";
-      msg += String(value);
-      msg += " (from '";
-      msg += numStr;
-      msg += "')";
-      logPrintln(msg);
-    }
-    // still return the raw value so caller can see the problem
-    return -1;
-  }
-
-  Serial.printf("[PWR] Parsed current RF power: %d%%\n", value);
-  if (webDebug)
-  {
-    String msg = "[PWR] Parsed current RF power: ";
-    msg += String(value);
-    msg += "%";
-    logPrintln(msg);
-  }
-
+  Trace::log(TR_PWR_REPLY, value);
   return value;
 }
 
 // --- Mode by code (MDn;) so we can restore without mapping back to a string
 bool setModeCode(int code)
 {
-  if (!cat.connected())
+  if (!radio->connected())
   {
-    Serial.printf("[MD] Cannot set mode code MD%d – CAT not connected.\n", code);
-    if (webDebug)
-    {
-      String msg = "[MD] Cannot set mode code MD";
-      msg += String(code);
-      msg += " – CAT not connected.";
-      logPrintln(msg);
-    }
+    Trace::log(TR_MD_CODE_OFFLINE, code);
     return false;
   }
 
-  // Optional: map known codes to human-readable names
-  const char *name = nullptr;
-  switch (code)
-  {
-  case 1:
-    name = "LSB";
-    break;
-  case 2:
-    name = "USB";
-    break;
-  case 3:
-    name = "CW";
-    break;
-  case 4:
-    name = "FM";
-    break;
-  case 5:
-    name = "AM";
-    break;
-  case 6:
-    name = "DIGL";
-    break;
-  case 9:
-    name = "DIGU";
-    break;
-  default:
-    name = "UNKNOWN";
-    break;
-  }
-
-  char cmd[12];
-  snprintf(cmd, sizeof(cmd), "MD%d;", code);
-
-  // High-level intent log
-  if (name && strcmp(name, "UNKNOWN") != 0)
-    Serial.printf("[MD] Setting mode by code: MD%d (%s)\n", code, name);
-  else
-    Serial.printf("[MD] Setting mode by code: MD%d (name unknown)\n", code);
-
-  if (webDebug)
-  {
-    String msg = "[MD] Setting mode by code: MD";
-    msg += String(code);
-    msg += " (";
-    msg += name;
-    msg += ")";
-    logPrintln(msg);
-  }
-
-  // Raw CAT command log
-  Serial.print(">> ");
-  Serial.println(cmd);
-  if (webDebug)
-  {
-    String debugMessage = ">> ";
-    debugMessage += cmd;
-    logPrintln(debugMessage); // logPrintln adds newline
-  }
+  // Goes out with the next backend tick (newer values overwrite it)
+  Trace::log(TR_MD_CODE_SET, code); // MD codes: 1 LSB, 2 USB, 3 CW, 4 FM, 5 AM, 6 DIGL, 9 DIGU
+  radioState.want(RADIO_MODE, code); // so the report/poll answer is not seen as external
+  radio->set(RADIO_MODE, code);
+  return true;
+}
 
-  bool ok = (cat.print(cmd) == (int)strlen(cmd));
-  if (!ok)
-  {
-    Serial.println("[MD] ERROR: Failed to send MDn command over CAT.");
-    if (webDebug)
-      logPrintln("[MD] ERROR: Failed to send MDn command over CAT.");
-  }
-  else
-  {
-    Serial.println("[MD] Mode code command sent successfully.");
-    if (webDebug)
-      logPrintln("[MD] Mode code command sent successfully.");
-  }
+// ---- delayed RX after a mode change ----
+bool forceRxPending = false;
+uint32_t forceRxAtMs = 0;
 
-  return ok;
-}
+// Mode cycle order: USB -> LSB - ...
+static const int cycleModes[] = {1, 2}; // MD codes
+static const char *cycleNames[] = {"USB", "LSB"};
 
-void cycleModeSequence()
+static void cycleModeFrom(int currentCode)
 {
-  if (!cat.connected())
-  {
-    Serial.println("[MODE] Cycle ignored (CAT not connected)");
-    if (webDebug)
-      logPrintln("[MODE] Cycle ignored (CAT not connected)");
-    return;
-  }
+  const size_t numModes = sizeof(cycleModes) / sizeof(cycleModes[0]);
 
-  // Mode cycle order: USB -> LSB - ...
-  const int modes[] = {1,2}; // MD codes
-  const char *names[] = {"USB", "LSB"};
-  const size_t numModes = sizeof(modes) / sizeof(modes[0]);
-
-  // --- Read current mode from radio ---
-  int currentCode = getMode(); // MDn;
+  // --- currentCode: MD code, -1 if unknown ---
   size_t idx = 0;
 
   if (currentCode > 0)
@@ -1326,7 +1385,7 @@ void cycleModeSequence()
     bool found = false;
     for (size_t i = 0; i < numModes; ++i)
     {
-      if (modes[i] == currentCode)
+      if (cycleModes[i] == currentCode)
       {
         idx = i;
         found = true;
@@ -1341,69 +1400,143 @@ void cycleModeSequence()
   }
   else
   {
-    // If getMode() failed, start from first in sequence
-    idx = 0;
+    // Mode unknown, start from first in sequence
+    idx = 0;
+  }
+
+  size_t nextIdx = (idx + 1) % numModes;
+  int nextCode = cycleModes[nextIdx];
+
+  // --- Actually change mode on the radio ---
+  if (setModeCode(nextCode))
+  {
+    Trace::text(TR_MODE_CYCLE, cycleNames[nextIdx]); // MD code: setModeCode() logged it
+
+    // 🛑 SAFETY BELT: force RX AFTER the mode change has taken effect
+    // Give SmartSDR a moment to do its internal shenanigans, then send ZZTX0;
+    // (serviceForceRx() does it 120 ms from now, without blocking the loop)
+    forceRxPending = true;
+    forceRxAtMs = millis() + 120;
+  }
+  else
+  {
+    Trace::log(TR_MODE_CYCLE_FAILED);
+  }
+}
+
+static void onCycleModeReply(const RadioSnapshot &s)
+{
+  if (s.has(RADIO_MODE))
+    radioState.adopt(RADIO_MODE, s.get(RADIO_MODE));
+  cycleModeFrom(s.get(RADIO_MODE));
+}
+
+void cycleModeSequence()
+{
+  if (!radio->connected())
+  {
+    Trace::log(TR_MODE_CYCLE_OFFLINE);
+    return;
   }
 
-  size_t nextIdx = (idx + 1) % numModes;
-  int nextCode = modes[nextIdx];
+  // --- Current mode from the shadow: one write, no round trip ---
+  if (radioState.get(RADIO_MODE) > 0)
+  {
+    cycleModeFrom(radioState.get(RADIO_MODE));
+    return;
+  }
 
-  // --- Actually change mode on the radio ---
-  if (setModeCode(nextCode))
+  // Never heard the mode yet: ask, the reply finishes the cycle
+  static const RadioParam CYCLE_QUERY[] = {RADIO_MODE};
+  if (!radio->query(CYCLE_QUERY, 1, 800, onCycleModeReply))
   {
-    char buf[64];
-    snprintf(buf, sizeof(buf), "[MODE] Cycle -> %s (MD%d)", names[nextIdx], nextCode);
-    Serial.println(buf);
-    if (webDebug)
-      logPrintln(String(buf));
+    RadioSnapshot none = {};
+    onCycleModeReply(none);
+  }
+}
 
-    // 🛑 SAFETY BELT: force RX AFTER the mode change has taken effect
-    // Give SmartSDR a moment to do its internal shenanigans, then send ZZTX0;
-    delay(120); // small, but explicit — you *will* see it in timing/logs
+void serviceForceRx()
+{
+  if (!forceRxPending || (int32_t)(millis() - forceRxAtMs) < 0)
+    return;
+  forceRxPending = false;
 
-    Serial.println("[MODE/PTT] Forcing RX after mode change (ZZTX0;)");
-    if (webDebug)
-      logPrintln("[MODE/PTT] Forcing RX after mode change (ZZTX0;)");
+  Trace::log(TR_MODE_FORCE_RX);
 
-    setPTT(false); // sends ZZTX0; and logs [PTT]... if it actually runs
-  }
-  else
-  {
-    Serial.println("[MODE] Failed to set mode in cycle");
-    if (webDebug)
-      logPrintln("[MODE] Failed to set mode in cycle");
-  }
+  setPTT(false); // unkeys and logs [PTT]... if it actually runs
 }
 
 // ---- TUNE state ----
 bool tuneActive = false;
+bool tunePreparing = false; // waiting for the mode/power snapshot
 uint32_t tuneUntilMs = 0;
 int savedModeCode = -1;
 int savedPowerPct = -1;
+uint16_t tuneDurationMs = 0;
+uint8_t tuneDrivePct = 0;
+String tuneModeName;
+
+// snapshot is in (or timed out): prep carrier and key
+static void keyTune()
+{
+  tunePreparing = false;
+
+  // prep carrier: set AM (or your choice) and low drive
+  setMode(tuneModeName);
+  setPowerPct(tuneDrivePct);
+
+  // key MOX; refused if mode/power could not go out first, then the
+  // normal end of TUNE restores them right away
+  bool keyed = setPTT(true); // lights the red LED if it went out
+
+  tuneUntilMs = millis() + (keyed ? tuneDurationMs : 0);
+  tuneActive = true;
+}
+
+static void onTuneSnapshot(const RadioSnapshot &s)
+{
+  if (s.has(RADIO_MODE))
+    radioState.adopt(RADIO_MODE, s.get(RADIO_MODE));
+  savedPowerPct = parsePowerPct(s.get(RADIO_POWER)); // -1 if no reply
+  if (savedPowerPct >= 0)
+    radioState.adopt(RADIO_POWER, savedPowerPct);
+  savedModeCode = radioState.get(RADIO_MODE); // -1 if still unknown
+  keyTune();
+}
 
 void startTune(uint16_t ms, uint8_t tunePower, const String &tuneMode)
 {
-  if (tuneActive || !cat.connected())
+  if (tuneActive || tunePreparing || !radio->connected())
     return;
 
-  // snapshot current settings
-  savedModeCode = getMode();     // MD?;
-  savedPowerPct = getPowerPct(); // ZZPC?;
-  if (savedModeCode < 0)
-    savedModeCode = -1;
-  if (savedPowerPct < 0)
-    savedPowerPct = -1;
+  tuneDurationMs = ms;
+  tuneDrivePct = tunePower;
+  tuneModeName = tuneMode;
+  tunePreparing = true;
 
-  // prep carrier: set AM (or your choice) and low drive
-  setMode(tuneMode);
-  setPowerPct(tunePower);
+  // restore values come from the shadow; only ask for what it can't vouch for
+  RadioParam ask[2];
+  uint8_t n = 0;
+  if (radioState.get(RADIO_MODE) <= 0)
+    ask[n++] = RADIO_MODE;
+  if (!radioState.fresh(RADIO_POWER, TUNE_POWER_FRESH_MS))
+    ask[n++] = RADIO_POWER;
 
-  // key MOX
-  setPTT(true);
-  digitalWrite(PIN_LED_RED, HIGH); // show TX
+  if (n == 0)
+  {
+    savedModeCode = radioState.get(RADIO_MODE);
+    savedPowerPct = radioState.get(RADIO_POWER);
+    keyTune();
+    return;
+  }
 
-  tuneUntilMs = millis() + ms;
-  tuneActive = true;
+  // one round trip, then key
+  if (!radio->query(ask, n, 800, onTuneSnapshot))
+  {
+    savedModeCode = radioState.get(RADIO_MODE);
+    savedPowerPct = -1;
+    keyTune();
+  }
 }
 
 void serviceTune()
@@ -1422,6 +1555,29 @@ void serviceTune()
   digitalWrite(PIN_LED_RED, LOW);
   tuneActive = false;
 }
+
+// esp_timer task: loop() may be stuck, so only the backend's own path
+static bool onTxWatchdog()
+{
+  return radio->emergencyUnkey();
+}
+
+// The watchdog fired: tell, and finish the un-key from the loop side
+void serviceTxWatchdog()
+{
+  if (!txWatchdog.takeFired())
+    return;
+
+  bool sent = txWatchdog.lastHandled();
+  Trace::log(sent ? TR_PTT_WATCHDOG_SENT : TR_PTT_WATCHDOG, txMaxS);
+
+  if (!sent)
+    setPTT(false);
+  if (tuneActive)
+    tuneUntilMs = millis(); // serviceTune() restores mode and power
+  digitalWrite(PIN_LED_RED, LOW);
+}
+
 void printStartupHeader()
 {
 
@@ -1437,47 +1593,39 @@ void printStartupHeader()
 
 void muteUnmute()
 {
-  if (!isMuted)
+  if (!radioState.muted)
   {
     // going to MUTE
-    if (volumePct > 0)
-      muteRestoreVolume = volumePct; // remember last useful volume
+    if (radioState.get(RADIO_AFGAIN) > 0)
+      radioState.restoreVolume = radioState.get(RADIO_AFGAIN); // remember last useful volume
 
-    volumePct = 0;
-    setVolumeA(0); // send ZZAG000;
-    isMuted = true;
+    setVolumeA(0);
+    radioState.muted = true;
 
-    Serial.println("[MUTE] ON");
-    if (webDebug)
-      logPrintln("[MUTE] ON");
+    Trace::log(TR_MUTE_ON);
   }
   else
   {
     // going to UNMUTE
-    volumePct = muteRestoreVolume;
-    if (volumePct < 0)
-      volumePct = 0;
-    if (volumePct > 100)
-      volumePct = 100;
+    int16_t vol = radioState.restoreVolume;
+    if (vol < 0)
+      vol = 0;
+    if (vol > 100)
+      vol = 100;
 
-    setVolumeA((uint8_t)volumePct);
-    isMuted = false;
+    setVolumeA((uint8_t)vol);
+    radioState.muted = false;
 
-    Serial.printf("[MUTE] OFF -> %d%%\n", volumePct);
-    if (webDebug)
-    {
-      String msg = "[MUTE] OFF -> " + String(volumePct) + "%";
-      logPrintln(msg);
-    }
+    Trace::log(TR_MUTE_OFF, vol);
   }
 }
 
 void updateGreenLed()
 {
   // Only GREEN LED behaviour based on CAT & mute state
-  if (cat.connected())
+  if (radio->connected())
   {
-    if (isMuted)
+    if (radioState.muted)
     {
       // Blink GREEN when muted
       uint32_t now = millis();
@@ -1497,9 +1645,11 @@ void updateGreenLed()
   }
   else
   {
-    // No CAT -> GREEN off
+    // No link: alternate RED/GREEN while reconnecting in the background
     greenBlinkOn = false;
-    digitalWrite(PIN_LED_GREEN, LOW);
+    bool phase = (millis() / 150) & 1;
+    digitalWrite(PIN_LED_GREEN, phase ? HIGH : LOW);
+    digitalWrite(PIN_LED_RED, phase ? LOW : HIGH);
   }
 }
 
@@ -1518,9 +1668,257 @@ void rebootESP()
   ESP.restart();
 }
 
+// Net task: run fn in the control task, then send what it wrote
+static void replyFromControl(int (*fn)(String &out))
+{
+  WebCall call;
+  call.fn = fn;
+  call.status = 503;
+  call.waiter = xTaskGetCurrentTaskHandle();
+  WebCall *p = &call;
+  if (webCalls && xQueueSend(webCalls, &p, portMAX_DELAY) == pdTRUE)
+  {
+    loopEvents.post(EV_WEB);
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+  server.send(call.status, "text/plain", call.out);
+}
+
+// Control task: answer the web calls that are waiting
+static void serviceWebCalls()
+{
+  WebCall *call;
+  while (xQueueReceive(webCalls, &call, 0) == pdTRUE)
+  {
+    call->status = call->fn(call->out);
+    xTaskNotifyGive(call->waiter);
+  }
+}
+
+void handleStats()
+{
+  replyFromControl(statsReply);
+}
+
+void handleBackend()
+{
+  replyFromControl(backendReply);
+}
+
+void handleInputs()
+{
+  replyFromControl(inputsReply);
+}
+
+// Binary trace ring for tools/trace_decode.py; the ring has its own lock,
+// so this one is answered straight from the net task
+void handleTrace()
+{
+  size_t size = Trace::dumpSize();
+  uint8_t *buf = (uint8_t *)malloc(size);
+  if (!buf)
+  {
+    server.send(503, "text/plain", "Out of memory");
+    return;
+  }
+  size_t n = Trace::dump(buf, size);
+  server.setContentLength(n);
+  server.send(200, "application/octet-stream", "");
+  server.sendContent((const char *)buf, n);
+  free(buf);
+}
+
+// Plain-text counters for the web console (/stats; ?reset=1 restarts the
+// input latency figures, tools/latency_stress.py does that per phase)
+int statsReply(String &out)
+{
+  if (server.hasArg("reset"))
+    loopEvents.resetLatency();
+  out.reserve(512);
+  out += "radio link (";
+  out += radio->name();
+  out += "): ";
+  out += radio->connected() ? "up\n" : "down\n";
+  radioState.appendStats(out);
+  loopEvents.appendStats(out);
+  txWatchdog.appendStats(out);
+  out += "encoders: vfo=" + String(vfoEnc->name()) + " irq=" + String(vfoEnc->interrupts());
+  out += " filter=" + String(filtEnc->name()) + " irq=" + String(filtEnc->interrupts());
+  out += " volume=" + String(volEnc->name()) + " irq=" + String(volEnc->interrupts());
+  out += " isr_dropped=" + String(encoderBank.dropped()) + "\n";
+  out += "tuning: step=" + String(tuningStepHz()) + "Hz velocity=" + String(tuningAccel.velocity());
+  out += "det/s x" + String(tuningAccel.multiplier()) + "\n";
+  radio->appendStats(out);
+  hostCache.appendStats(out);
+  discovery.appendStats(out);
+  out += "tasks: control core=" + String(xPortGetCoreID()) + " prio=" + String(uxTaskPriorityGet(nullptr));
+  out += " stack_free=" + String(uxTaskGetStackHighWaterMark(nullptr));
+  out += " net stack_free=" + String(netTaskHandle ? uxTaskGetStackHighWaterMark(netTaskHandle) : 0);
+  out += " log_dropped=" + String(WebConsoleLogger_dropped()) + "\n";
+  Trace::appendStats(out);
+  return 200;
+}
+
+// Show / choose the radio backend: /backend?use=cat|api[&port=N]
+// The choice lives in Preferences and takes effect after a reboot.
+int backendReply(String &out)
+{
+  if (server.hasArg("rcbudget"))
+  {
+    rebootBudgetS = (uint16_t)server.arg("rcbudget").toInt();
+    prefs.putUShort("rcbudget", rebootBudgetS);
+    out = "ok, reboot after " + String(rebootBudgetS) + " s without link\n";
+    return 200;
+  }
+
+  if (server.hasArg("txmax"))
+  {
+    txMaxS = (uint16_t)server.arg("txmax").toInt();
+    prefs.putUShort("txmax", txMaxS);
+    out = "ok, TX watchdog " + String(txMaxS) + " s (0 = off)\n";
+    return 200;
+  }
+
+  if (server.hasArg("qport"))
+  {
+    uint16_t qport = (uint16_t)server.arg("qport").toInt();
+    prefs.putUShort("qport", qport);
+    catBackend.setQueryPort(qport);
+    out = "ok, query port " + String(qport) + " (0 = shared) from the next connect\n";
+    return 200;
+  }
+
+  if (server.hasArg("standby"))
+  {
+    standbyPort = (uint16_t)server.arg("standby").toInt();
+    prefs.putUShort("sbport", standbyPort);
+    if (radio->connected())
+      configureStandby();
+    out = "ok, standby port " + String(standbyPort) + " (0 = off)\n";
+    return 200;
+  }
+
+  if (!server.hasArg("use"))
+  {
+    out = "backend: ";
+    out += radio->name();
+    out += " port ";
+    out += String(radioPort);
+    out += "\nchange with /backend?use=cat or /backend?use=api (optional &port=N)\n";
+    out += "reboot after " + String(rebootBudgetS) + " s without link (0 = never), change with /backend?rcbudget=N\n";
+    out += "TX watchdog " + String(txMaxS) + " s max key-down (0 = off), change with /backend?txmax=N\n";
+    out += "CAT query port " + String(catBackend.queryPort()) + " (0 = shared with writes), change with /backend?qport=N\n";
+    out += "standby port " + String(standbyPort) + " (0 = off, same as port = next known host), change with /backend?standby=N\n";
+    return 200;
+  }
+
+  String use = server.arg("use");
+  if (use != "cat" && use != "api")
+  {
+    out = "use must be cat or api\n";
+    return 400;
+  }
+  prefs.putString("backend", use);
+  if (server.hasArg("port"))
+    prefs.putUShort("port", (uint16_t)server.arg("port").toInt());
+  else
+    prefs.remove("port"); // backend default (5002 / 4992)
+
+  Trace::text(TR_RADIO_BACKEND_SET, use.c_str());
+  out = "ok, rebooting\n";
+  rebootAtMs = millis() + 300; // EV_UI, after the net task has sent this
+  return 200;
+}
+
+// Show / change the input bindings:
+// /inputs?input=pad3&gesture=long&action=tune (action=none removes), /inputs?reset=1
+int inputsReply(String &out)
+{
+  if (server.hasArg("reset"))
+  {
+    inputBindings.reset(prefs);
+    out = "ok, default bindings\n";
+    return 200;
+  }
+
+  if (server.hasArg("input"))
+  {
+    int input = -1, gesture = -1, action = -1;
+    for (uint8_t i = 0; i < INPUT_COUNT; i++)
+      if (server.arg("input") == INPUT_TABLE[i].name)
+        input = i;
+    for (uint8_t g = 0; g < GESTURE_COUNT; g++)
+      if (server.arg("gesture") == InputEngine::gestureName((InputGesture)g))
+        gesture = g;
+    for (uint8_t a = 0; a < ACT_COUNT; a++)
+      if (server.arg("action") == ACTION_NAMES[a])
+        action = a;
+    if (input < 0 || gesture < 0 || action < 0)
+    {
+      out = "unknown input, gesture or action (see /inputs)\n";
+      return 400;
+    }
+    if (!inputBindings.bind(input, (InputGesture)gesture, action))
+    {
+      out = "binding map full\n";
+      return 507;
+    }
+    inputBindings.save(prefs);
+    out = "ok, " + server.arg("input") + " " + server.arg("gesture") + " -> " + server.arg("action") + "\n";
+    return 200;
+  }
+
+  out = "inputs:";
+  for (uint8_t i = 0; i < INPUT_COUNT; i++)
+  {
+    const InputPin &p = INPUT_TABLE[i];
+    out += " " + String(p.name) + "(gpio" + String(p.pin) + (inputEngine.active(i) ? ",down)" : ")");
+  }
+  out += "\ngestures:";
+  for (uint8_t g = 0; g < GESTURE_COUNT; g++)
+    out += " " + String(InputEngine::gestureName((InputGesture)g));
+  out += "\nactions:";
+  for (uint8_t a = 0; a < ACT_COUNT; a++)
+    out += " " + String(ACTION_NAMES[a]);
+  out += "\nbindings:\n";
+  for (uint8_t i = 0; i < inputBindings.count(); i++)
+  {
+    const InputBinding &b = inputBindings.at(i);
+    if (b.input >= INPUT_COUNT || b.action >= ACT_COUNT)
+      continue;
+    out += "  " + String(INPUT_TABLE[b.input].name) + " " + InputEngine::gestureName((InputGesture)b.gesture);
+    out += " -> " + String(ACTION_NAMES[b.action]) + "\n";
+  }
+  out += "change with /inputs?input=pad3&gesture=long&action=tune (action=none removes), /inputs?reset=1\n";
+  return 200;
+}
+
+// Net task (core 0): captive portal, OTA and the web server. A slow HTTP
+// client or an OTA transfer blocks here instead of in loop().
+static void netTask(void *)
+{
+  for (;;)
+  {
+    HB9IIUPortal::loop(); // MUST be called regularly
+    OtaHelper::handle();
+    if (!HB9IIUPortal::isInAPMode())
+      server.handleClient();
+    vTaskDelay(pdMS_TO_TICKS(NET_TASK_PERIOD_MS));
+  }
+}
+
+static void startNetTask()
+{
+  if (netTaskHandle)
+    return;
+  if (xTaskCreatePinnedToCore(netTask, "net", 6144, nullptr, NET_TASK_PRIORITY, &netTaskHandle, NET_TASK_CORE) != pdPASS)
+    Serial.println("[Setup] Net task could not be started!");
+}
+
 // ================== SETUP ========================
 void setup()
 {
+  Serial.setTxBufferSize(1024); // printf from the control task should not wait for the UART
   Serial.begin(115200);
   printStartupHeader();
   // Factory Reset Pins Configuration
@@ -1542,8 +1940,20 @@ void setup()
 
   ledBlinkActive = true; // start blinking
 
+  // loop() sleeps between events; network and logging get their own tasks
+  vTaskPrioritySet(nullptr, CONTROL_TASK_PRIORITY);
+  loopEvents.begin();
+  webCalls = xQueueCreate(4, sizeof(WebCall *));
+  WebConsoleLogger_setSource(Trace::next); // trace records are formatted on the log task
+  if (!WebConsoleLogger_startTask(LOG_TASK_CORE, LOG_TASK_PRIORITY))
+    Serial.println("[Setup] Log task could not be started; logging inline.");
+  loopEvents.every(EV_NET, LOOP_NET_MS);
+  loopEvents.every(EV_UI, LOOP_UI_MS);
+
   // Connect if possible, else start captive portal
   HB9IIUPortal::begin();
+  if (HB9IIUPortal::isInAPMode())
+    startNetTask(); // portal pages only
 
   // If we reach here: WiFi is configured (STA or AP mode is decided)
   if (!HB9IIUPortal::isInAPMode())
@@ -1553,6 +1963,10 @@ void setup()
 
     // Init web console logger (routes + handlers)
     WebConsoleLogger_begin(server, consoleHTML);
+    server.on("/stats", handleStats);
+    server.on("/backend", handleBackend);
+    server.on("/inputs", handleInputs);
+    server.on("/trace", handleTrace);
 
     // Start HTTP server
     server.begin();
@@ -1560,6 +1974,7 @@ void setup()
 
     // Setup OTA
     OtaHelper::begin(OTA_HOSTNAME);
+    startNetTask(); // routes are registered: from now on the web server runs on core 0
 
     // --- Stop LED blinking at end of setup() ---
     ledBlinkActive = false;
@@ -1574,375 +1989,318 @@ void setup()
 
     prefs.begin("cat", false);
 
-    // VFO encoder
-    pinMode(PIN_ENC_A, ENC_INPUT_MODE);
-    pinMode(PIN_ENC_B, ENC_INPUT_MODE);
-    vfo_q_last = fastReadAB();
-    attachInterrupt(digitalPinToInterrupt(PIN_ENC_A), encISR, CHANGE);
-    attachInterrupt(digitalPinToInterrupt(PIN_ENC_B), encISR, CHANGE);
-
-    // Filter encoder
-    pinMode(PIN_FILT_A, ENC_INPUT_MODE);
-    pinMode(PIN_FILT_B, ENC_INPUT_MODE);
-    f_q_last = fastReadAB_filt();
-    attachInterrupt(digitalPinToInterrupt(PIN_FILT_A), filtISR, CHANGE);
-    attachInterrupt(digitalPinToInterrupt(PIN_FILT_B), filtISR, CHANGE);
-
-    // Volume encoder
-    pinMode(PIN_VOL_A, ENC_INPUT_MODE);
-    pinMode(PIN_VOL_B, ENC_INPUT_MODE);
-    v_q_last = fastReadAB_vol();
-    attachInterrupt(digitalPinToInterrupt(PIN_VOL_A), volISR, CHANGE);
-    attachInterrupt(digitalPinToInterrupt(PIN_VOL_B), volISR, CHANGE);
-
-    // Encoder click buttons (active-LOW with pull-ups)
-    pinMode(PIN_ENC_BW_SW, INPUT_PULLUP);
-    pinMode(PIN_ENC_VOL_SW, INPUT_PULLUP);
-    clickLastBW = !digitalRead(PIN_ENC_BW_SW); // pressed = LOW -> !LOW = true
-    clickLastVol = !digitalRead(PIN_ENC_VOL_SW);
-
-    // TTP223 touch pins: INPUT_PULLDOWN (idle LOW, touch = HIGH)
-    pinMode(PIN_TOUCH1, INPUT_PULLDOWN);
-    pinMode(PIN_TOUCH2, INPUT_PULLDOWN);
-    pinMode(PIN_TOUCH3, INPUT_PULLDOWN);
-    pinMode(PIN_TOUCH4, INPUT_PULLDOWN);
-    pinMode(PIN_TOUCH5, INPUT_PULLDOWN);
+    // CAT via SmartSDR CAT (PC) or the radio's own TCP API, see /backend
+    if (prefs.getString("backend", "cat") == "api")
+      radio = &apiBackend;
+    radioPort = prefs.getUShort("port", radio->defaultPort());
+    catBackend.setQueryPort(prefs.getUShort("qport", 0));
+    catBackend.setRateBounds(SEND_INTERVAL_MIN_MS, SEND_INTERVAL_MAX_MS);
+    hostCache.load(prefs, "hosts");
+    importLegacyHost("host", BACKEND_CAT, CatBackend::DEFAULT_PORT);
+    importLegacyHost("apihost", BACKEND_API, FlexApiBackend::DEFAULT_PORT);
+    hostCache.save(prefs);
+    radio->begin(onRadioReport, onRadioLog);
+    radio->setWake(loopEvents.task(), EV_CAT); // both backends read in a task of their own
+    radioState.want(RADIO_FREQ, DEFAULT_VFO_HZ);
+    radioState.want(RADIO_FILTER, 0);
+    radioState.want(RADIO_AFGAIN, 50);
+    Serial.printf("[RADIO] Backend %s, port %u\n", radio->name(), radioPort);
+    discovery.begin();
+
+    // VFO, filter and volume encoders
+    tuningAccel.setRange(VFO_MIN_HZ, VFO_MAX_HZ);
+    vfoEnc = startEncoder(vfoPcnt, PIN_ENC_A, PIN_ENC_B, vfoDetents, "VFO");
+    filtEnc = startEncoder(filtPcnt, PIN_FILT_A, PIN_FILT_B, filtDetents, "Filter");
+    volEnc = startEncoder(volPcnt, PIN_VOL_A, PIN_VOL_B, volDetents, "Volume");
+    encoderBank.begin();
+    vfoEnc->setWake(onEncoderWake, nullptr);
+    filtEnc->setWake(onEncoderWake, nullptr);
+    volEnc->setWake(onEncoderWake, nullptr);
+    vfoDetents.reset(vfoEnc->edges());
+    filtDetents.reset(filtEnc->edges());
+    volDetents.reset(volEnc->edges());
+
+    // TTP223 pads: pulled down (touch = HIGH); encoder clicks: pulled up (pressed = LOW)
+    for (uint8_t i = 0; i < INPUT_COUNT; i++)
+    {
+      pinMode(INPUT_TABLE[i].pin, INPUT_TABLE[i].activeHigh ? INPUT_PULLDOWN : INPUT_PULLUP);
+      attachInterrupt(digitalPinToInterrupt(INPUT_TABLE[i].pin), onInputPin, CHANGE);
+    }
 
     // LEDs
     pinMode(PIN_LED_GREEN, OUTPUT);
     pinMode(PIN_LED_RED, OUTPUT);
     ledsOff();
 
-    // Init debounce baselines
-    touchLast1 = digitalRead(PIN_TOUCH1);
-    touchLast2 = digitalRead(PIN_TOUCH2);
-    touchLast3 = digitalRead(PIN_TOUCH3);
-    touchLast4 = digitalRead(PIN_TOUCH4);
-    touchLast5 = digitalRead(PIN_TOUCH5);
-    uint32_t now = millis();
-    touchT1 = touchT2 = touchT3 = touchT4 = touchT5 = now;
-    clickTBW = clickTVol = now;
+    // Input baselines and the binding map
+    inputEngine.begin(INPUT_TABLE, INPUT_COUNT, readInputLevels(), millis());
+    inputBindings.setDefaults(DEFAULT_BINDINGS, sizeof(DEFAULT_BINDINGS) / sizeof(DEFAULT_BINDINGS[0]));
+    inputBindings.load(prefs, "inbind");
 
+    rebootBudgetS = prefs.getUShort("rcbudget", RECONNECT_REBOOT_BUDGET_S);
+    standbyPort = prefs.getUShort("sbport", 0);
+    txMaxS = prefs.getUShort("txmax", TX_MAX_KEYDOWN_S);
+    if (!txWatchdog.begin(onTxWatchdog))
+      Serial.println("[PTT] TX watchdog timer could not be created!");
     if (!catConnect())
     {
-      Serial.println("[CAT] Could not connect to CAT. Rebooting...");
-      logPrintln("[CAT] Could not connect to CAT. Rebooting...");
-      delay(500);
-      rebootESP();
+      // keep trying from loop(); reboot only once the budget is spent
+      Serial.println("[CAT] Could not connect to CAT; retrying in the background.");
+      logPrintln("[CAT] Could not connect to CAT; retrying in the background.");
+      onLinkDown();
+      return;
     }
 
     saveCurrentHostIfNeeded();
+    configureStandby();
 
-    if (!initialSyncFromRadio())
-    {
-      Serial.println("[SYNC] No FA reply; pushing local once.");
-      sendFA(vfoHz);
-      lastSentHz = vfoHz;
-    }
-
-    // Init filter + volume from radio
-    readFilterPresetOnce();
-    int v = readVolumeA();
-    if (v >= 0)
-    {
-      volumePct = v;
-      muteRestoreVolume = v; // remember for unmute
-      Serial.printf("[VOL] %d%%\n", volumePct);
-    }
+    // VFO + filter + volume from radio (replies arrive via pumpIncoming())
+    if (!resyncFromRadio())
+      Serial.println("[SYNC] Could not query radio state.");
   }
 }
 
-// ================== LOOP =========================
-void loop()
+// ================== LOOP SERVICES =========================
+
+// Any set() value still waiting for the backend's tick spacing
+static bool radioPending()
 {
-  HB9IIUPortal::loop(); // MUST be called every loop()
-  OtaHelper::handle();  // Handle OTA updates
-  if (!HB9IIUPortal::isInAPMode())
+  for (uint8_t p = 0; p < RADIO_PARAM_COUNT; p++)
+    if (radio->pending((RadioParam)p))
+      return true;
+  return false;
+}
+
+// Turn detents into radio changes; true if any knob moved a detent
+static bool serviceEncoders(uint32_t nowUs)
+{
+  static uint32_t lastScanUs = 0;
+
+  // Timestamped detents from the GPIO fallback (no interrupt masking)
+  uint8_t encId;
+  int8_t encDir;
+  uint32_t encIntervalUs;
+  while (encoderBank.drain(encId, encDir, encIntervalUs))
+    if (bankDetents[encId])
+      bankDetents[encId]->add(encDir, encIntervalUs);
+
+  // VFO ENCODER: freq detents, velocity-accelerated on the mode's step grid
+  int32_t detents = readDetents(vfoEnc, vfoDetents, nowUs);
+  if (detents != 0 && radioState.get(RADIO_FREQ) > 0)
   {
-    // ✅ Normal application code here – CAT connected
-    server.handleClient(); // Handle web requests
+    uint32_t next = tuningAccel.apply((uint32_t)radioState.get(RADIO_FREQ), detents,
+                                      vfoDetents.intervalUs(), tuningStepHz());
+    // VFO follows the knob; the backend coalesces and paces the writes
+    sendFA(next);
+  }
+
+  // FILTER ENCODER: 4 edges = 1 detent; step 0..7
+  int32_t f_detents = readDetents(filtEnc, filtDetents, nowUs);
+  if (f_detents != 0)
+  {
+    int8_t dir = (f_detents > 0) ? +1 : -1;
+    int8_t curIdx = (int8_t)radioState.get(RADIO_FILTER);
+    if (curIdx < 0)
+      curIdx = 0;
+    int8_t newIdx = curIdx + dir;
+    if (newIdx < 0)
+      newIdx = 0;
+    if (newIdx > 7)
+      newIdx = 7;
+    if (newIdx != curIdx)
+      sendFilterPreset((uint8_t)newIdx);
+  }
 
-    if (cat.connected() && cat.available())
-      pumpIncoming();
+  // VOLUME ENCODER: each detent = VOLUME_STEP %, clamp 0..100 (scheduler throttles)
+  int32_t v_detents = readDetents(volEnc, volDetents, nowUs);
 
-    // reconnect if needed
-    static uint32_t lastTry = 0;
-    if (!cat.connected() && millis() - lastTry > 1200)
-    {
-      lastTry = millis();
-      if (!tryConnectHost(currentHost))
-      {
-        if (!catConnect())
-        {
-          Serial.println("[CAT] Reconnect failed; rebooting...");
-          delay(500);
-          ESP.restart();
-        }
-      }
-      saveCurrentHostIfNeeded();
-      if (!initialSyncFromRadio())
-      {
-        sendFA(vfoHz);
-        lastSentHz = vfoHz;
-      }
-      readFilterPresetOnce();
-      int v = readVolumeA();
-      if (v >= 0)
-      {
-        volumePct = v;
-        muteRestoreVolume = v; // keep restore value in sync after reconnect
-      }
-    }
+  if (v_detents != 0)
+  {
 
-    // External change sync baseline
-    static int32_t lastEdges = 0;
-    if (needResetEncoderBaseline)
-    {
-      noInterrupts();
-      q_edges = 0;
-      detentPending = 0;
-      interrupts();
-      needResetEncoderBaseline = false;
-      noInterrupts();
-      lastEdges = q_edges;
-      interrupts();
-    }
+    // 🔊 If user turns the knob while muted -> auto-unmute
+    int16_t curVol = (int16_t)radioState.get(RADIO_AFGAIN);
+    if (curVol < 0)
+      curVol = 0;
 
-    // VFO ENCODER: freq detents + accel
-    int32_t edges;
-    noInterrupts();
-    edges = q_edges;
-    interrupts();
-    int32_t deltaEdges = edges - lastEdges;
-    int32_t detents = deltaEdges / 4;
-    if (detents != 0)
+    // 🔊 If user turns the knob while muted -> auto-unmute
+    int16_t baseVol = curVol;
+    if (radioState.muted)
     {
-      lastEdges += detents * 4;
-      uint32_t nowMs = millis();
-      uint32_t dt = nowMs - lastDetentMs;
-      int accel = 1;
-      if (dt < ACCEL_T1_MS)
-        accel = 4;
-      else if (dt < ACCEL_T2_MS)
-        accel = 2;
-      long next = (long)vfoHz + (long)detents * STEP_HZ * accel;
-      if (next < 0)
-        next = 0;
-      vfoHz = (uint32_t)next;
-    }
+      Trace::log(TR_VOL_AUTO_UNMUTE);
 
-    // Rate-limited FA
-    static uint32_t lastSend = 0;
-    if (cat.connected() && millis() - lastSend >= SEND_INTERVAL_MS)
-    {
-      lastSend = millis();
-      if (vfoHz != lastSentHz)
+      radioState.muted = false;
+
+      // If we are at 0 but have a remembered volume, restore it first
+      if (baseVol == 0 && radioState.restoreVolume > 0)
       {
-        if (sendFA(vfoHz))
-          lastSentHz = vfoHz;
-        else if (cat.connected())
-          cat.stop();
+        baseVol = radioState.restoreVolume;
       }
     }
 
-    // Light periodic FA;
-    static uint32_t lastFAq = 0;
-    if (RESYNC_MS > 0 && cat.connected() && millis() - lastFAq > RESYNC_MS)
-    {
-      lastFAq = millis();
-      cat.print("FA;");
-    }
+    // Apply detent change
+    int16_t newVol = baseVol + (int16_t)v_detents * VOLUME_STEP;
+    if (newVol < 0)
+      newVol = 0;
+    if (newVol > 100)
+      newVol = 100;
 
-    // FILTER ENCODER: 4 edges = 1 detent; step 0..7
-    static int32_t f_lastEdges = 0;
-    int32_t fe;
-    noInterrupts();
-    fe = f_edges;
-    interrupts();
-    int32_t f_delta = fe - f_lastEdges;
-    int32_t f_detents = f_delta / 4;
-    if (f_detents != 0)
+    // Keep a good "last non-zero volume" for future mute/unmute
+    if (newVol > 0)
     {
-      f_lastEdges += f_detents * 4;
-      int8_t dir = (f_detents > 0) ? +1 : -1;
-      int8_t newIdx = filterIdx + dir;
-      if (newIdx < 0)
-        newIdx = 0;
-      if (newIdx > 7)
-        newIdx = 7;
-      if (newIdx != filterIdx)
-      {
-        filterIdx = newIdx;
-        sendFilterPreset((uint8_t)filterIdx);
-      }
+      radioState.restoreVolume = newVol;
     }
 
-    // VOLUME ENCODER: each detent = VOLUME_STEP %, clamp 0..100, throttle sends
-    static int32_t v_lastEdges = 0;
-    static uint32_t lastVolSend = 0;
-    static int16_t lastVolSent = -1;
+    if (newVol != curVol)
+      setVolumeA((uint8_t)newVol);
+  }
 
-    int32_t ve;
-    noInterrupts();
-    ve = v_edges;
-    interrupts();
-    int32_t v_delta = ve - v_lastEdges;
-    int32_t v_detents = v_delta / 4;
+  bool moved = detents != 0 || f_detents != 0 || v_detents != 0;
+  // Scanned counters have no edge time: the detent came after the previous
+  // read, so stamp that (an upper bound; an edge interrupt stamps first)
+  if (moved)
+    loopEvents.inputAt(lastScanUs ? lastScanUs : nowUs);
+  lastScanUs = nowUs;
+  return moved;
+}
 
-    if (v_detents != 0)
+// Knobs moving: read the counters every ENCODER_SCAN_MS. Idle for
+// ENCODER_IDLE_MS: stop scanning and let the next edge wake us instead.
+static void scheduleEncoders(uint32_t ev, bool moved)
+{
+  uint32_t now = millis();
+  if (moved || (ev & EV_ENCODER))
+  {
+    encoderMovedMs = now;
+    if (!encodersScanning)
     {
-      v_lastEdges += v_detents * 4;
-
-      // 🔊 If user turns the knob while muted -> auto-unmute
-      if (isMuted)
-      {
-        Serial.println("[VOL] Encoder rotated while muted -> auto-unmute");
-        if (webDebug)
-          logPrintln("[VOL] Encoder rotated while muted -> auto-unmute");
+      encodersScanning = true;
+      loopEvents.every(EV_SCAN, ENCODER_SCAN_MS);
+    }
+  }
+  else if (encodersScanning && now - encoderMovedMs >= ENCODER_IDLE_MS)
+  {
+    encodersScanning = false;
+    loopEvents.cancel(EV_SCAN);
+    vfoEnc->armWake();
+    filtEnc->armWake();
+    volEnc->armWake();
+    loopEvents.post(EV_SCAN); // one more read: an edge just before re-arming raised nothing
+  }
+}
 
-        isMuted = false;
+static void runAction(uint8_t action)
+{
+  switch (action)
+  {
+  case ACT_FT8_40M:
+    flashRedLed();
+    setFT8_40m();
+    setMode("LSB");
+    break;
+  case ACT_FT8_20M:
+    flashRedLed();
+    setFT8_20m();
+    setMode("USB");
+    break;
+  case ACT_PTT_ON:
+  case ACT_PTT_OFF:
+    setPTT(action == ACT_PTT_ON); // the LED follows what the backend accepted
+    break;
+  case ACT_TUNE:
+    startTune(/*ms*/ 1200, /*power%*/ 10, /*mode*/ "FM");
+    break;
+  case ACT_MODE_CYCLE:
+    flashRedLed();
+    cycleModeSequence();
+    break;
+  case ACT_MUTE:
+    muteUnmute();
+    break;
+  case ACT_REBOOT:
+    Trace::log(TR_INPUT_REBOOT);
+    if (webDebug)
+      delay(1000); // the log and net tasks get the line out
+    rebootESP();
+    break;
+  default:
+    break;
+  }
+}
 
-        // If we are at 0 but have a remembered volume, restore it first
-        if (volumePct == 0 && muteRestoreVolume > 0)
-        {
-          volumePct = muteRestoreVolume;
-        }
-      }
+// Pads and clicks: one scan of the input table, gestures through the binding map
+static void serviceInputs()
+{
+  InputEvent events[2 * InputEngine::MAX_INPUTS];
+  uint8_t n = inputEngine.scan(readInputLevels(), millis(), events, sizeof(events) / sizeof(events[0]));
+  for (uint8_t i = 0; i < n; i++)
+  {
+    uint8_t action = inputBindings.action(events[i].input, events[i].gesture);
+    if (action == ACT_NONE || action >= ACT_COUNT)
+      continue;
+    Trace::log(TR_INPUT, events[i].input, events[i].gesture, action); // names: /inputs
+    runAction(action);
+  }
 
-      // Apply detent change
-      int16_t newVol = volumePct + (int16_t)v_detents * VOLUME_STEP;
-      if (newVol < 0)
-        newVol = 0;
-      if (newVol > 100)
-        newVol = 100;
-      volumePct = newVol;
+  // held, waiting for a second tap or inside a debounce window: sample again
+  if (inputEngine.busy())
+    loopEvents.after(EV_INPUT, INPUT_SCAN_MS);
+}
 
-      // Keep a good "last non-zero volume" for future mute/unmute
-      if (!isMuted && volumePct > 0)
-      {
-        muteRestoreVolume = volumePct;
-      }
-    }
+// ================== LOOP =========================
+// Sleeps in loopEvents.wait() until an input interrupt, CAT data or a
+// timer slot; each kind of work only runs when its bit is set.
+void loop()
+{
+  uint32_t ev = loopEvents.wait();
 
-    if (cat.connected() && volumePct != lastVolSent && millis() - lastVolSend >= 120)
-    {
-      if (setVolumeA((uint8_t)volumePct))
-      {
-        lastVolSent = volumePct;
-        lastVolSend = millis();
-      }
-    }
+  if (!HB9IIUPortal::isInAPMode())
+  {
+    // ✅ Normal application code here – CAT connected
+    serviceTxWatchdog(); // first: a stuck key-down is the worst thing that can happen
+    pumpIncoming(); // CAT replies from the transport task (never blocks)
 
-    // ===== SIMPLE TOUCH HANDLING (active-HIGH, debounced) =====
-    uint32_t t = millis();
+    if (ev & EV_WEB)
+      serviceWebCalls(); // /stats, /backend
 
-    bool r1 = digitalRead(PIN_TOUCH1);
-    if (r1 != touchLast1 && (t - touchT1) >= TOUCH_DEBOUNCE_MS)
-    {
-      touchLast1 = r1;
-      touchT1 = t;
-      if (r1)
-      {
-        Serial.println("[TTP] 1 -> FT8 40m; mode: LSB");
-        flashRedLed();
-        setFT8_40m();
-        setMode("LSB");
-      }
-    }
-    bool r2 = digitalRead(PIN_TOUCH2);
-    if (r2 != touchLast2 && (t - touchT2) >= TOUCH_DEBOUNCE_MS)
-    {
-      touchLast2 = r2;
-      touchT2 = t;
-      if (r2)
-      {
-        Serial.println("[TTP] 2 -> FT8 20m; mode: USB");
-        flashRedLed();
-        setFT8_20m();
-        setMode("USB");
-      }
-    }
-    bool r3 = digitalRead(PIN_TOUCH3);
-    if (r3 != touchLast3 && (t - touchT3) >= TOUCH_DEBOUNCE_MS)
-    {
-      touchLast3 = r3;
-      touchT3 = t;
-      if (r3)
-      { // finger down
-        Serial.println("[TTP] 3 -> PTT ON");
-        setPTT(true);
-        digitalWrite(PIN_LED_RED, HIGH);
-      }
-      else
-      { // finger up
-        Serial.println("[TTP] 3 -> PTT OFF");
-        setPTT(false);
-        digitalWrite(PIN_LED_RED, LOW);
-      }
-    }
-    bool r4 = digitalRead(PIN_TOUCH4);
-    if (r4 != touchLast4 && (t - touchT4) >= TOUCH_DEBOUNCE_MS)
-    {
-      touchLast4 = r4;
-      touchT4 = t;
-      if (r4)
-      {
-        Serial.println("[TTP] 4 pressed -> TUNE");
-        startTune(/*ms*/ 1200, /*power%*/ 10, /*mode*/ "FM");
-      }
-    }
-    bool r5 = digitalRead(PIN_TOUCH5);
-    if (r5 != touchLast5 && (t - touchT5) >= TOUCH_DEBOUNCE_MS)
+    if (ev & EV_NET)
     {
-      touchLast5 = r5;
-      touchT5 = t;
-      if (r5)
-      {
-        Serial.println("[TTP] 5 pressed -> MODE CYCLE (USB/LSB/CW/FM)");
-        flashRedLed();
-        cycleModeSequence();
-      }
+      discovery.service(); // keeps the radio table fresh for reconnects
+
+      // reconnect if needed: one short step per pass, knobs keep working
+      serviceLink();
     }
 
-    // ===== ENCODER CLICK HANDLING (active-LOW, debounced) =====
-    bool cfRaw = !digitalRead(PIN_ENC_BW_SW); // pressed if LOW
-    if (cfRaw != clickLastBW && (t - clickTBW) >= CLICK_DEBOUNCE_MS)
+    // External change sync baseline
+    if (needResetEncoderBaseline)
     {
-      clickLastBW = cfRaw;
-      clickTBW = t;
-      if (cfRaw)
-      {
-        Serial.println("[CLICK] BW");
-        if (webDebug)
-        {
-          logPrintln("[CLICK] BW ->> Rebooting");
-          server.handleClient(); // Handle web requests
-          delay(1000);
-        }
-        rebootESP();
-      }
+      vfoDetents.reset(vfoEnc->edges());
+      tuningAccel.reset();
+      needResetEncoderBaseline = false;
     }
 
-    bool cvRaw = !digitalRead(PIN_ENC_VOL_SW); // pressed if LOW
-    if (cvRaw != clickLastVol && (t - clickTVol) >= CLICK_DEBOUNCE_MS)
+    if (ev & (EV_ENCODER | EV_SCAN))
+      scheduleEncoders(ev, serviceEncoders(micros()));
+
+    if (ev & EV_INPUT)
+      serviceInputs();
+
+    if (ev & EV_UI)
     {
-      clickLastVol = cvRaw;
-      clickTVol = t;
-      if (cvRaw)
+      if (redFlashActive && (int32_t)(millis() - redFlashUntil) >= 0)
       {
-        Serial.println("[CLICK] Vol -> Mute/Unmute");
-        muteUnmute();
+        redFlashActive = false;
+        digitalWrite(PIN_LED_RED, LOW); // end flash
       }
+      updateGreenLed(); // enforce GREEN LED: solid vs blink vs off
+      serviceTune();
+      serviceForceRx();
+      if (rebootAtMs && (int32_t)(millis() - rebootAtMs) >= 0)
+        rebootESP();
     }
-    if (redFlashActive && (int32_t)(millis() - redFlashUntil) >= 0)
-    {
-      redFlashActive = false;
-      digitalWrite(PIN_LED_RED, LOW); // end flash
-    }
-    updateGreenLed(); // enforce GREEN LED: solid vs blink vs off
-    serviceTune();
 
-    delay(1);
+    // Everything this pass changed goes out as one write
+    bool sent = radio->tick(false);
+    loopEvents.inputDone(sent, radioPending());
   }
   else
   {
@@ -1951,7 +2309,7 @@ void loop()
     if (millis() - lastLog > 1000)
     {
       lastLog = millis();
-      logPrintln("Waiting in CAPTIVE PORTAL mode for Wifi Credentials: " + String(millis() / 1000) + " seconds");
+      Trace::log(TR_PORTAL_WAITING, millis() / 1000);
     }
   }
 }
@@ -0,0 +1,173 @@
+// CatEncoder: digit-rewrite edge cases checked against snprintf, then a
+// timing comparison of encode() / write() / snprintf over a tuning sweep.
+// Runs on the board: pio test -e esp32dev-serial -f test_cat_encoder
+#include <Arduino.h>
+#include <unity.h>
+#include <stdio.h>
+#include "HB9IIUCatCommands.h"
+
+// What snprintf makes of it: the reference the encoder has to match
+template <typename Cmd>
+static const char *reference(char *dst, size_t size, uint32_t value)
+{
+    uint64_t limit = 1;
+    for (uint8_t i = 0; i < Cmd::DIGITS; i++)
+        limit *= 10;
+    snprintf(dst, size, "%s%0*llu;", Cmd::prefix(), (int)Cmd::DIGITS,
+             (unsigned long long)(value % limit)); // high digits beyond DIGITS are dropped
+    return dst;
+}
+
+// Encode a sequence with one encoder; every step must equal a fresh snprintf
+template <typename Cmd>
+static void checkSequence(const uint32_t *values, size_t count)
+{
+    CatEncoder<Cmd> enc;
+    char ref[24];
+    char msg[64];
+    for (size_t i = 0; i < count; i++)
+    {
+        const char *got = enc.encode(values[i]);
+        reference<Cmd>(ref, sizeof(ref), values[i]);
+        snprintf(msg, sizeof(msg), "step %u: %lu", (unsigned)i, (unsigned long)values[i]);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(ref, got, msg);
+        TEST_ASSERT_EQUAL_size_t(strlen(ref), CatEncoder<Cmd>::length());
+    }
+}
+
+static void test_initial_state()
+{
+    CatEncoder<CatCmdFA> fa;
+    TEST_ASSERT_EQUAL_STRING("FA00000000000;", fa.c_str());
+    TEST_ASSERT_EQUAL_STRING("FA00000000000;", fa.encode(0));
+    CatEncoder<CatCmdZZAG> ag;
+    TEST_ASSERT_EQUAL_STRING("ZZAG000;", ag.c_str());
+}
+
+// 099 -> 100, 0999999999 -> 1000000000: a carry rewrites every digit
+static void test_carry_across_all_digits()
+{
+    const uint32_t ag[] = {99, 100, 99, 0, 100, 9, 10};
+    checkSequence<CatCmdZZAG>(ag, sizeof(ag) / sizeof(ag[0]));
+
+    const uint32_t fa[] = {999999999UL, 1000000000UL, 999999999UL, 9, 10, 4294967295UL, 0, 4294967295UL};
+    checkSequence<CatCmdFA>(fa, sizeof(fa) / sizeof(fa[0]));
+
+    const uint32_t fi[] = {9, 10, 99, 0};
+    checkSequence<CatCmdZZFI>(fi, sizeof(fi) / sizeof(fi[0]));
+}
+
+// Fewer digits than last time (stale high digits must go) and more
+static void test_shorter_and_longer_values()
+{
+    const uint32_t fa[] = {14074000UL, 7, 14074000UL, 1840000UL, 50313000UL, 136000UL, 0, 1};
+    checkSequence<CatCmdFA>(fa, sizeof(fa) / sizeof(fa[0]));
+
+    const uint32_t pc[] = {100, 5, 50, 100, 1};
+    checkSequence<CatCmdZZPC>(pc, sizeof(pc) / sizeof(pc[0]));
+}
+
+// More digits than the command has: only the low ones are sent
+static void test_values_wider_than_the_field()
+{
+    const uint32_t md[] = {12, 13, 2, 9, 10, 3};
+    checkSequence<CatCmdMD>(md, sizeof(md) / sizeof(md[0]));
+
+    const uint32_t fi[] = {123, 124, 24, 100, 7};
+    checkSequence<CatCmdZZFI>(fi, sizeof(fi) / sizeof(fi[0]));
+}
+
+static void test_same_value_twice()
+{
+    const uint32_t fa[] = {14074000UL, 14074000UL, 14074001UL, 14074001UL};
+    checkSequence<CatCmdFA>(fa, sizeof(fa) / sizeof(fa[0]));
+}
+
+// Knob-like random walk plus jumps, deterministic (LCG)
+static void test_random_walk_matches_snprintf()
+{
+    static uint32_t fa[2000];
+    uint32_t seed = 12345;
+    uint32_t hz = 14074000UL;
+    for (size_t i = 0; i < sizeof(fa) / sizeof(fa[0]); i++)
+    {
+        seed = seed * 1103515245UL + 12345;
+        uint32_t r = seed >> 8;
+        if (r % 50 == 0)
+            hz = r % 54000000UL; // band change
+        else
+            hz += (int32_t)(r % 2001) - 1000;
+        fa[i] = hz;
+    }
+    checkSequence<CatCmdFA>(fa, sizeof(fa) / sizeof(fa[0]));
+}
+
+static void test_stateless_write()
+{
+    char buf[CatEncoder<CatCmdZZAG>::LEN + 1];
+    TEST_ASSERT_EQUAL_STRING("ZZAG007;", CatEncoder<CatCmdZZAG>::text(buf, 7));
+    TEST_ASSERT_EQUAL_STRING("ZZAG100;", CatEncoder<CatCmdZZAG>::text(buf, 100));
+
+    char raw[CatEncoder<CatCmdMD>::LEN];
+    TEST_ASSERT_EQUAL_size_t(4, CatEncoder<CatCmdMD>::write(raw, 2));
+    TEST_ASSERT_EQUAL_MEMORY("MD2;", raw, 4);
+}
+
+// 10 Hz steps as a spinning VFO produces them
+static void test_benchmark_against_snprintf()
+{
+    const uint32_t N = 20000;
+    uint32_t sink = 0;
+
+    CatEncoder<CatCmdFA> enc;
+    uint32_t t0 = micros();
+    for (uint32_t i = 0; i < N; i++)
+        sink += (uint8_t)enc.encode(14074000UL + i * 10)[12];
+    uint32_t encUs = micros() - t0;
+
+    char buf[24];
+    t0 = micros();
+    for (uint32_t i = 0; i < N; i++)
+    {
+        CatEncoder<CatCmdFA>::write(buf, 14074000UL + i * 10);
+        sink += (uint8_t)buf[12];
+    }
+    uint32_t writeUs = micros() - t0;
+
+    t0 = micros();
+    for (uint32_t i = 0; i < N; i++)
+    {
+        snprintf(buf, sizeof(buf), "FA%011lu;", (unsigned long)(14074000UL + i * 10));
+        sink += (uint8_t)buf[12];
+    }
+    uint32_t printfUs = micros() - t0;
+
+    char msg[160];
+    snprintf(msg, sizeof(msg), "FA x%lu: encode %lu ns, write %lu ns, snprintf %lu ns per command (sink %lu)",
+             (unsigned long)N, (unsigned long)((uint64_t)encUs * 1000 / N),
+             (unsigned long)((uint64_t)writeUs * 1000 / N), (unsigned long)((uint64_t)printfUs * 1000 / N),
+             (unsigned long)sink);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_LESS_THAN(printfUs, encUs);
+    TEST_ASSERT_LESS_THAN(printfUs, writeUs);
+}
+
+void setup()
+{
+    delay(2000); // let the test runner open the serial port
+    UNITY_BEGIN();
+    RUN_TEST(test_initial_state);
+    RUN_TEST(test_carry_across_all_digits);
+    RUN_TEST(test_shorter_and_longer_values);
+    RUN_TEST(test_values_wider_than_the_field);
+    RUN_TEST(test_same_value_twice);
+    RUN_TEST(test_random_walk_matches_snprintf);
+    RUN_TEST(test_stateless_write);
+    RUN_TEST(test_benchmark_against_snprintf);
+    UNITY_END();
+}
+
+void loop()
+{
+}
@@ -0,0 +1,242 @@
+// CatParser: framing edge cases, then a throughput benchmark over typical
+// auto-information traffic (frames/s, heap allocated per frame).
+// Runs on the board: pio test -e esp32dev-serial -f test_cat_parser
+#include <Arduino.h>
+#include <unity.h>
+#include <new>
+#include <stdlib.h>
+#include "HB9IIUCatParser.h"
+
+// Count every C++ allocation made while the benchmark runs
+static uint32_t allocCount = 0;
+static uint32_t allocBytes = 0;
+
+void *operator new(size_t n)
+{
+    allocCount++;
+    allocBytes += n;
+    void *p = malloc(n ? n : 1);
+    if (!p)
+        abort();
+    return p;
+}
+
+void *operator new[](size_t n)
+{
+    return operator new(n);
+}
+
+void operator delete(void *p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    free(p);
+}
+
+static void feed(CatParser &p, const char *s)
+{
+    p.write((const uint8_t *)s, strlen(s));
+}
+
+static void test_values_and_opcodes()
+{
+    CatParser p;
+    CatFrame f;
+    feed(p, "FA00014074000;MD2;ZZAG050;ZZFI03;ZZTX1;AI1;?;IF0001407400000000;");
+
+    TEST_ASSERT_TRUE(p.next(f));
+    TEST_ASSERT_EQUAL(CAT_OP_FA, f.op);
+    TEST_ASSERT_TRUE(f.hasValue);
+    TEST_ASSERT_EQUAL_INT32(14074000, f.value);
+    TEST_ASSERT_EQUAL_STRING("FA00014074000;", f.text);
+    TEST_ASSERT_EQUAL_UINT8(14, f.len);
+
+    TEST_ASSERT_TRUE(p.next(f));
+    TEST_ASSERT_EQUAL(CAT_OP_MD, f.op);
+    TEST_ASSERT_EQUAL_INT32(2, f.value);
+    TEST_ASSERT_TRUE(p.next(f));
+    TEST_ASSERT_EQUAL(CAT_OP_ZZAG, f.op);
+    TEST_ASSERT_EQUAL_INT32(50, f.value);
+    TEST_ASSERT_TRUE(p.next(f));
+    TEST_ASSERT_EQUAL(CAT_OP_ZZFI, f.op);
+    TEST_ASSERT_EQUAL_INT32(3, f.value);
+    TEST_ASSERT_TRUE(p.next(f));
+    TEST_ASSERT_EQUAL(CAT_OP_ZZTX, f.op);
+    TEST_ASSERT_EQUAL_INT32(1, f.value);
+    TEST_ASSERT_TRUE(p.next(f));
+    TEST_ASSERT_EQUAL(CAT_OP_AI, f.op);
+
+    TEST_ASSERT_TRUE(p.next(f));
+    TEST_ASSERT_EQUAL(CAT_OP_ERROR, f.op);
+    TEST_ASSERT_FALSE(f.hasValue);
+
+    TEST_ASSERT_TRUE(p.next(f));
+    TEST_ASSERT_EQUAL(CAT_OP_OTHER, f.op); // not ours: text only
+    TEST_ASSERT_FALSE(f.hasValue);
+
+    TEST_ASSERT_FALSE(p.next(f));
+}
+
+static void test_query_echo_has_no_value()
+{
+    CatParser p;
+    CatFrame f;
+    feed(p, "FA;ZZAG05x;");
+    TEST_ASSERT_TRUE(p.next(f));
+    TEST_ASSERT_EQUAL(CAT_OP_FA, f.op);
+    TEST_ASSERT_FALSE(f.hasValue);
+    TEST_ASSERT_TRUE(p.next(f));
+    TEST_ASSERT_EQUAL(CAT_OP_ZZAG, f.op);
+    TEST_ASSERT_FALSE(f.hasValue); // trailing junk: no half-parsed value
+    TEST_ASSERT_EQUAL_INT32(0, f.value);
+}
+
+// A frame split at every possible byte boundary comes out whole, once
+static void test_split_at_every_byte()
+{
+    const char *stream = "ZZAG075;FA00007100000;";
+    size_t len = strlen(stream);
+    for (size_t cut = 1; cut < len; cut++)
+    {
+        CatParser p;
+        CatFrame f;
+        uint8_t frames = 0;
+        p.write((const uint8_t *)stream, cut);
+        while (p.next(f))
+            frames++;
+        p.write((const uint8_t *)stream + cut, len - cut);
+        while (p.next(f))
+        {
+            frames++;
+            if (f.op == CAT_OP_FA)
+                TEST_ASSERT_EQUAL_INT32(7100000, f.value);
+        }
+        TEST_ASSERT_EQUAL_UINT8(2, frames);
+    }
+}
+
+static void test_noise_between_frames()
+{
+    CatParser p;
+    CatFrame f;
+    feed(p, "\r\n;;MD3;\r\n");
+    TEST_ASSERT_TRUE(p.next(f));
+    TEST_ASSERT_EQUAL_STRING("MD3;", f.text);
+    TEST_ASSERT_FALSE(p.next(f));
+}
+
+static void test_overlong_frame_is_skipped()
+{
+    CatParser p;
+    CatFrame f;
+    feed(p, "ZZ0123456789012345678901234567890123456789;MD1;");
+    TEST_ASSERT_TRUE(p.next(f));
+    TEST_ASSERT_EQUAL(CAT_OP_MD, f.op); // resynced on the next ';'
+    TEST_ASSERT_EQUAL_UINT32(1, p.malformed());
+}
+
+// Zero-copy fill across the ring wrap, as the transport task does it
+static void test_zero_copy_fill_wraps()
+{
+    CatParser p;
+    CatFrame f;
+    const char *frame = "ZZFI05;"; // 7 bytes: never lines up with the ring size
+    size_t len = strlen(frame);
+    uint32_t frames = 0;
+    for (uint16_t round = 0; round < 200; round++)
+    {
+        size_t done = 0;
+        while (done < len)
+        {
+            uint8_t *dst;
+            size_t room = p.writable(dst);
+            TEST_ASSERT_GREATER_THAN(0, room);
+            size_t n = len - done < room ? len - done : room;
+            memcpy(dst, frame + done, n);
+            p.commit(n);
+            done += n;
+        }
+        while (p.next(f))
+        {
+            TEST_ASSERT_EQUAL_INT32(5, f.value);
+            frames++;
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(200, frames);
+    TEST_ASSERT_EQUAL_UINT32(0, p.malformed());
+}
+
+// What SmartSDR pushes while someone spins the VFO, with the odd other report
+static const char TRAFFIC[] =
+    "FA00014074010;FA00014074020;FA00014074030;ZZAG050;FA00014074040;"
+    "MD2;FA00014074050;ZZFI03;FA00014074060;ZZTX0;";
+static const uint8_t TRAFFIC_FRAMES = 10;
+
+static void test_benchmark_throughput()
+{
+    const uint32_t ROUNDS = 5000;
+    const size_t CHUNK = 64; // socket reads come in pieces that split frames
+    size_t len = strlen(TRAFFIC);
+
+    CatParser p;
+    CatFrame f;
+    uint32_t frames = 0;
+    uint32_t checksum = 0;
+    uint32_t heapBefore = ESP.getFreeHeap();
+    allocCount = 0;
+    allocBytes = 0;
+
+    uint32_t t0 = micros();
+    for (uint32_t r = 0; r < ROUNDS; r++)
+    {
+        for (size_t off = 0; off < len; off += CHUNK)
+        {
+            p.write((const uint8_t *)TRAFFIC + off, len - off < CHUNK ? len - off : CHUNK);
+            while (p.next(f))
+            {
+                frames++;
+                checksum += f.value;
+            }
+        }
+    }
+    uint32_t us = micros() - t0;
+    uint32_t heapAfter = ESP.getFreeHeap();
+
+    char msg[160];
+    snprintf(msg, sizeof(msg),
+             "parser: %lu frames in %lu us = %lu frames/s, %lu ns/frame; "
+             "%lu allocations, %lu bytes (per frame: %lu); free heap %ld bytes",
+             (unsigned long)frames, (unsigned long)us,
+             (unsigned long)(us ? (uint64_t)frames * 1000000ULL / us : 0),
+             (unsigned long)(frames ? (uint64_t)us * 1000ULL / frames : 0),
+             (unsigned long)allocCount, (unsigned long)allocBytes,
+             (unsigned long)(frames ? allocBytes / frames : 0),
+             (long)heapAfter - (long)heapBefore);
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_EQUAL_UINT32(ROUNDS * TRAFFIC_FRAMES, frames);
+    TEST_ASSERT_GREATER_THAN(0, checksum);
+    TEST_ASSERT_EQUAL_UINT32(0, allocCount); // the whole point: nothing allocates
+    TEST_ASSERT_EQUAL_UINT32(0, p.malformed());
+}
+
+void setup()
+{
+    delay(2000); // let the test runner open the serial port
+    UNITY_BEGIN();
+    RUN_TEST(test_values_and_opcodes);
+    RUN_TEST(test_query_echo_has_no_value);
+    RUN_TEST(test_split_at_every_byte);
+    RUN_TEST(test_noise_between_frames);
+    RUN_TEST(test_overlong_frame_is_skipped);
+    RUN_TEST(test_zero_copy_fill_wraps);
+    RUN_TEST(test_benchmark_throughput);
+    UNITY_END();
+}
+
+void loop()
+{
+}
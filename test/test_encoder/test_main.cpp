@@ -0,0 +1,140 @@
+// EncoderDetents and TuningAccel driven through MockEncoder, the way
+// serviceEncoders() uses them. Runs on the board: pio test -e esp32dev-serial
+#include <Arduino.h>
+#include <unity.h>
+#include "HB9IIUMockEncoder.h"
+#include "HB9IIUTuningAccel.h"
+
+static void test_whole_detents()
+{
+    MockEncoder enc;
+    EncoderDetents d;
+    enc.begin();
+    d.reset(enc.edges());
+
+    enc.turn(3);
+    TEST_ASSERT_EQUAL_INT32(3, d.take(enc.edges(), 1000));
+    enc.turn(-2);
+    TEST_ASSERT_EQUAL_INT32(-2, d.take(enc.edges(), 2000));
+    TEST_ASSERT_EQUAL_INT32(0, d.take(enc.edges(), 3000)); // nothing new
+}
+
+static void test_partial_detents_carry_over()
+{
+    MockEncoder enc;
+    EncoderDetents d;
+    d.reset(enc.edges());
+
+    enc.step(3); // not a detent yet
+    TEST_ASSERT_EQUAL_INT32(0, d.take(enc.edges(), 1000));
+    enc.step(1);
+    TEST_ASSERT_EQUAL_INT32(1, d.take(enc.edges(), 2000));
+
+    enc.step(-5); // one back, one edge of the next pending
+    TEST_ASSERT_EQUAL_INT32(-1, d.take(enc.edges(), 3000));
+    enc.step(-3);
+    TEST_ASSERT_EQUAL_INT32(-1, d.take(enc.edges(), 4000));
+}
+
+static void test_contact_bounce_is_no_detent()
+{
+    MockEncoder enc;
+    EncoderDetents d;
+    d.reset(enc.edges());
+
+    for (uint8_t i = 0; i < 10; i++)
+    {
+        enc.step(3);
+        TEST_ASSERT_EQUAL_INT32(0, d.take(enc.edges(), i * 100));
+        enc.step(-3);
+        TEST_ASSERT_EQUAL_INT32(0, d.take(enc.edges(), i * 100 + 50));
+    }
+}
+
+static void test_interval_per_detent()
+{
+    MockEncoder enc;
+    EncoderDetents d;
+    d.reset(enc.edges());
+
+    enc.turn(1);
+    d.take(enc.edges(), 100000);
+    TEST_ASSERT_EQUAL_UINT32(EncoderDetents::SLOW_US, d.intervalUs()); // first one: no previous detent
+
+    enc.turn(3);
+    d.take(enc.edges(), 130000); // 3 detents in 30 ms
+    TEST_ASSERT_EQUAL_UINT32(10000, d.intervalUs());
+
+    enc.turn(-2);
+    d.take(enc.edges(), 134000);
+    TEST_ASSERT_EQUAL_UINT32(2000, d.intervalUs());
+}
+
+static void test_reset_drops_unseen_edges()
+{
+    MockEncoder enc;
+    EncoderDetents d;
+    d.reset(enc.edges());
+
+    enc.turn(5); // e.g. moved while the frequency was re-synced
+    d.reset(enc.edges());
+    TEST_ASSERT_EQUAL_INT32(0, d.take(enc.edges(), 1000));
+
+    d.add(1, 5000);
+    d.add(1, 5000);
+    d.reset(enc.edges());
+    TEST_ASSERT_EQUAL_INT32(0, d.takeAdded());
+}
+
+static void test_timestamped_detents()
+{
+    EncoderDetents d;
+    d.add(1, 8000);
+    d.add(1, 6000);
+    d.add(-1, 4000);
+    TEST_ASSERT_EQUAL_INT32(1, d.takeAdded());
+    TEST_ASSERT_EQUAL_UINT32(4000, d.intervalUs()); // latest one
+    TEST_ASSERT_EQUAL_INT32(0, d.takeAdded());
+}
+
+// The whole chain: knob -> detents -> frequency
+static void test_slow_turn_tunes_one_step_per_detent()
+{
+    MockEncoder enc;
+    EncoderDetents d;
+    TuningAccel accel;
+    d.reset(enc.edges());
+
+    uint32_t hz = 14074000;
+    uint32_t us = 0;
+    for (uint8_t i = 0; i < 5; i++)
+    {
+        enc.turn(1);
+        us += 200000; // 5 detents/s
+        hz = accel.apply(hz, d.take(enc.edges(), us), d.intervalUs(), 10);
+    }
+    TEST_ASSERT_EQUAL_UINT32(14074050, hz);
+
+    enc.turn(-2);
+    us += 200000;
+    hz = accel.apply(hz, d.take(enc.edges(), us), d.intervalUs(), 10);
+    TEST_ASSERT_EQUAL_UINT32(14074030, hz);
+}
+
+void setup()
+{
+    delay(2000); // let the test runner open the serial port
+    UNITY_BEGIN();
+    RUN_TEST(test_whole_detents);
+    RUN_TEST(test_partial_detents_carry_over);
+    RUN_TEST(test_contact_bounce_is_no_detent);
+    RUN_TEST(test_interval_per_detent);
+    RUN_TEST(test_reset_drops_unseen_edges);
+    RUN_TEST(test_timestamped_detents);
+    RUN_TEST(test_slow_turn_tunes_one_step_per_detent);
+    UNITY_END();
+}
+
+void loop()
+{
+}
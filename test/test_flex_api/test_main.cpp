@@ -0,0 +1,272 @@
+// FlexApiBackend's incremental line parser, fed the R/S lines a FLEX-6000
+// sends on port 4992: status tokens split at every byte, overlong tokens,
+// error replies before the first status, other slices. Last, a mock radio
+// on the loopback interface takes a whole session through the transport task.
+// Runs on the board: pio test -e esp32dev-serial -f test_flex_api
+#include <Arduino.h>
+#include <unity.h>
+#include <WiFi.h>
+#include <string.h>
+#include "HB9IIUFlexApiBackend.h"
+
+// One backend for the whole run: begin() starts its transport task
+static FlexApiBackend api(50, 0);
+
+static int32_t reported[RADIO_PARAM_COUNT];
+static uint8_t reports = 0;
+static char lastLog[96];
+
+static void onReport(RadioParam param, int32_t value)
+{
+    reported[param] = value;
+    reports++;
+}
+
+static void onLog(RadioLogKind kind, const char *text, size_t len)
+{
+    (void)kind;
+    if (len > sizeof(lastLog) - 1)
+        len = sizeof(lastLog) - 1;
+    memcpy(lastLog, text, len);
+    lastLog[len] = '\0';
+}
+
+void setUp()
+{
+    for (uint8_t i = 0; i < RADIO_PARAM_COUNT; i++)
+        reported[i] = -1;
+    reports = 0;
+    lastLog[0] = '\0';
+}
+
+void tearDown()
+{
+}
+
+static void feed(const char *s)
+{
+    api.feed(s, strlen(s));
+}
+
+// "name=<n>" out of appendStats()
+static uint32_t stat(const char *name)
+{
+    String s;
+    api.appendStats(s);
+    const char *p = strstr(s.c_str(), name);
+    return p ? (uint32_t)strtoul(p + strlen(name), nullptr, 10) : 0xFFFFFFFF;
+}
+
+static void test_slice_and_transmit_status()
+{
+    feed("S4F2A1B3C|slice 0 in_use=1 RF_frequency=14.074000 mode=USB filter_lo=100 filter_hi=2800 audio_level=35\n");
+    TEST_ASSERT_EQUAL_INT32(14074000, reported[RADIO_FREQ]);
+    TEST_ASSERT_EQUAL_INT32(2, reported[RADIO_MODE]);
+    TEST_ASSERT_EQUAL_INT32(4, reported[RADIO_FILTER]); // 2700 Hz wide = fifth SSB button
+    TEST_ASSERT_EQUAL_INT32(35, reported[RADIO_AFGAIN]);
+
+    feed("S4F2A1B3C|transmit freq=14.074000 rfpower=50 tunepower=10\r\n");
+    TEST_ASSERT_EQUAL_INT32(50, reported[RADIO_POWER]);
+    TEST_ASSERT_EQUAL_UINT8(5, reports);
+
+    // unchanged values are not reported again
+    feed("S4F2A1B3C|slice 0 RF_frequency=14.074000 mode=USB\n");
+    TEST_ASSERT_EQUAL_UINT8(5, reports);
+}
+
+static void test_split_at_every_byte()
+{
+    char line[96];
+    for (int k = 0; k < 60; k++)
+    {
+        int len = snprintf(line, sizeof(line), "S4F2A1B3C|slice 0 RF_frequency=7.%06d mode=LSB audio_level=%d\n",
+                           100 + k, k % 100);
+        TEST_ASSERT_TRUE(k < len);
+        api.feed(line, k);
+        api.feed(line + k, len - k);
+        TEST_ASSERT_EQUAL_INT32(7000100 + k, reported[RADIO_FREQ]);
+        TEST_ASSERT_EQUAL_INT32(k % 100, reported[RADIO_AFGAIN]);
+    }
+    TEST_ASSERT_EQUAL_INT32(1, reported[RADIO_MODE]);
+
+    // byte by byte
+    const char *s = "S4F2A1B3C|slice 0 RF_frequency=10.136000 mode=DIGU\n";
+    for (const char *p = s; *p; p++)
+        api.feed(p, 1);
+    TEST_ASSERT_EQUAL_INT32(10136000, reported[RADIO_FREQ]);
+    TEST_ASSERT_EQUAL_INT32(9, reported[RADIO_MODE]);
+}
+
+static void test_overlong_token_is_dropped()
+{
+    uint32_t before = stat("truncated=");
+
+    // longer than a token buffer: counted, the rest of the line still applies
+    feed("S4F2A1B3C|slice 0 ant_list=ANT1,ANT2,RX_A,RX_B,XVTA,XVTB,XVTC,XVTD,XVTE mode=CW RF_frequency=3.560000\n");
+    TEST_ASSERT_EQUAL_UINT32(before + 1, stat("truncated="));
+    TEST_ASSERT_EQUAL_INT32(3, reported[RADIO_MODE]);
+    TEST_ASSERT_EQUAL_INT32(3560000, reported[RADIO_FREQ]);
+
+    // an overlong value of ours must not be half-applied
+    feed("S4F2A1B3C|slice 0 RF_frequency=3.5600000000000000000000000000000000001\n");
+    TEST_ASSERT_EQUAL_UINT32(before + 2, stat("truncated="));
+    TEST_ASSERT_EQUAL_INT32(3560000, reported[RADIO_FREQ]);
+}
+
+static void test_replies_before_status()
+{
+    uint32_t before = stat("errors=");
+
+    // what a radio says right after connect, before any status arrives
+    feed("V1.4.0.0\nH2A3B4C5D\nM10000001|Client connected from IP 192.168.1.60\n");
+    feed("R1|50000016|Invalid slice receiver\n");
+    TEST_ASSERT_EQUAL_UINT32(before + 1, stat("errors="));
+    TEST_ASSERT_NOT_NULL(strstr(lastLog, "C1 failed: 0x50000016"));
+
+    lastLog[0] = '\0';
+    feed("R2|0|\nR3|0\n"); // success, with and without the message field
+    TEST_ASSERT_EQUAL_UINT32(before + 1, stat("errors="));
+    TEST_ASSERT_EQUAL_STRING("", lastLog);
+
+    // an error code cut off by the line end still counts
+    feed("R4|5000002D\n");
+    TEST_ASSERT_EQUAL_UINT32(before + 2, stat("errors="));
+    TEST_ASSERT_EQUAL_UINT8(0, reports);
+
+    // and status right behind it parses normally
+    feed("S4F2A1B3C|slice 0 RF_frequency=18.100000\n");
+    TEST_ASSERT_EQUAL_INT32(18100000, reported[RADIO_FREQ]);
+}
+
+static void test_other_slices_and_objects_ignored()
+{
+    feed("S4F2A1B3C|slice 1 RF_frequency=21.074000 mode=AM audio_level=80\n");
+    feed("S4F2A1B3C|display pan 0x40000000 center=21.074000 bandwidth=0.200000\n");
+    feed("S4F2A1B3C|meter 7.src=TX-#7.num=7#7.nam=RFPWR\n");
+    TEST_ASSERT_EQUAL_UINT8(0, reports);
+
+    // our slice on the next line is still picked up
+    feed("S4F2A1B3C|slice 0 RF_frequency=24.915000\n");
+    TEST_ASSERT_EQUAL_INT32(24915000, reported[RADIO_FREQ]);
+    TEST_ASSERT_EQUAL_UINT8(1, reports);
+}
+
+// ---------------- mock radio on 127.0.0.1 ----------------
+
+static const uint16_t MOCK_PORT = 14992;
+static WiFiServer mockServer(MOCK_PORT);
+
+// Keep the backend serviced while waiting, as the loop would
+static bool waitFor(bool (*done)(), uint32_t timeoutMs)
+{
+    uint32_t t0 = millis();
+    while (!done())
+    {
+        if (millis() - t0 > timeoutMs)
+            return false;
+        api.service();
+        delay(1);
+    }
+    return true;
+}
+
+// One line the backend wrote, without the '\n'
+static bool readLine(WiFiClient &c, char *out, size_t size, uint32_t timeoutMs)
+{
+    size_t n = 0;
+    uint32_t t0 = millis();
+    while (millis() - t0 < timeoutMs)
+    {
+        int b = c.read();
+        if (b < 0)
+        {
+            delay(1);
+            continue;
+        }
+        if (b == '\n')
+        {
+            out[n] = '\0';
+            return true;
+        }
+        if (n < size - 1)
+            out[n++] = (char)b;
+    }
+    out[n] = '\0';
+    return false;
+}
+
+static bool freqReported() { return reported[RADIO_FREQ] == 14250000; }
+static bool linkDown() { return !api.connected(); }
+
+static void test_session_against_mock_radio()
+{
+    mockServer.begin();
+    api.beginConnect(IPAddress(127, 0, 0, 1), MOCK_PORT, 1000);
+    RadioConnectState st = RADIO_CONNECT_PENDING;
+    uint32_t t0 = millis();
+    while (st == RADIO_CONNECT_PENDING && millis() - t0 < 2000)
+    {
+        delay(1);
+        st = api.pollConnect();
+    }
+    TEST_ASSERT_EQUAL(RADIO_CONNECT_UP, st);
+
+    WiFiClient radio;
+    t0 = millis();
+    while (!radio && millis() - t0 < 1000)
+    {
+        radio = mockServer.available();
+        delay(1);
+    }
+    TEST_ASSERT_TRUE(radio.connected());
+
+    // the subscriptions come first
+    char line[64];
+    TEST_ASSERT_TRUE(readLine(radio, line, sizeof(line), 500));
+    TEST_ASSERT_EQUAL_STRING("C1|sub slice all", line);
+    TEST_ASSERT_TRUE(readLine(radio, line, sizeof(line), 500));
+    TEST_ASSERT_EQUAL_STRING("C2|sub tx all", line);
+
+    // replies ahead of the status dump, status arriving in pieces
+    radio.print("R1|0|\nR2|0|\nS4F2A1B3C|slice 0 RF_freq");
+    delay(20);
+    radio.print("uency=14.250000 mode=USB\n");
+    TEST_ASSERT_TRUE(waitFor(freqReported, 1000));
+    TEST_ASSERT_EQUAL_INT32(2, reported[RADIO_MODE]);
+
+    // a retune, then a key that has to go out behind it
+    api.set(RADIO_FREQ, 14251000);
+    TEST_ASSERT_TRUE(api.setPtt(true));
+    TEST_ASSERT_TRUE(readLine(radio, line, sizeof(line), 500));
+    TEST_ASSERT_EQUAL_STRING("C3|slice tune 0 14.251000", line);
+    TEST_ASSERT_TRUE(readLine(radio, line, sizeof(line), 500));
+    TEST_ASSERT_EQUAL_STRING("C4|xmit 1", line);
+    TEST_ASSERT_TRUE(api.setPtt(false));
+    TEST_ASSERT_TRUE(readLine(radio, line, sizeof(line), 500));
+    TEST_ASSERT_EQUAL_STRING("C5|xmit 0", line);
+
+    // the radio hangs up: the transport notices, the backend reports it
+    radio.stop();
+    TEST_ASSERT_TRUE(waitFor(linkDown, 2000));
+    TEST_ASSERT_NOT_NULL(strstr(lastLog, "Connection closed"));
+    mockServer.end();
+}
+
+void setup()
+{
+    delay(2000); // let the test runner open the serial port
+    WiFi.mode(WIFI_STA); // brings up the network stack (loopback only, no AP needed)
+    api.begin(onReport, onLog);
+    UNITY_BEGIN();
+    RUN_TEST(test_slice_and_transmit_status);
+    RUN_TEST(test_split_at_every_byte);
+    RUN_TEST(test_overlong_token_is_dropped);
+    RUN_TEST(test_replies_before_status);
+    RUN_TEST(test_other_slices_and_objects_ignored);
+    RUN_TEST(test_session_against_mock_radio);
+    UNITY_END();
+}
+
+void loop()
+{
+}
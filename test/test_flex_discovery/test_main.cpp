@@ -0,0 +1,94 @@
+// FlexDiscovery::decode() against discovery packets laid out the way a
+// FLEX-6000 sends them. Runs on the board: pio test -e esp32dev-serial
+#include <Arduino.h>
+#include <unity.h>
+#include "HB9IIUFlexDiscovery.h"
+
+// Payload in the form a FLEX-6600 on SmartSDR v3 broadcasts (fields trimmed)
+static const char PAYLOAD[] =
+    "discovery_protocol_version=3.0.0.2 model=FLEX-6600 serial=1019-1234-6600-5678 "
+    "version=3.4.35.141 nickname=HB9IIU callsign=HB9IIU ip=192.168.1.50 port=4992 "
+    "status=In_Use inuse_ip=192.168.1.20 inuse_host=SHACK-PC max_licensed_version=v3 "
+    "radio_license_id=00-1C-2D-05-1A-2B requires_additional_license=0 fpc_mac= "
+    "wan_connected=1 licensed_clients=2 available_clients=1 max_panadapters=4 "
+    "available_panadapters=3 max_slices=4 available_slices=3 "
+    "gui_client_ips=192.168.1.20,192.168.1.20 gui_client_hosts=SHACK-PC "
+    "gui_client_programs=SmartSDR-Win gui_client_stations=SHACK-PC gui_client_handles=0x1234ABCD";
+
+static uint8_t pkt[1024];
+
+static void put32(uint8_t *p, uint32_t v)
+{
+    p[0] = v >> 24;
+    p[1] = v >> 16;
+    p[2] = v >> 8;
+    p[3] = v;
+}
+
+// VITA-49 header (type 3 + class id, TSI other, TSF sample count), stream
+// 0x800, FlexRadio OUI, class 0xFFFF, timestamps, payload NUL padded to a word
+static size_t buildPacket(const char *payload, uint32_t streamId = 0x00000800, uint16_t packetClass = 0xFFFF)
+{
+    size_t len = strlen(payload);
+    size_t words = 7 + (len + 4) / 4; // header words + payload incl. at least one NUL
+    memset(pkt, 0, sizeof(pkt));
+    put32(pkt, 0x38D00000 | (uint32_t)words);
+    put32(pkt + 4, streamId);
+    put32(pkt + 8, 0x00001C2D);
+    put32(pkt + 12, 0x534C0000 | packetClass);
+    put32(pkt + 16, 0x64A1B2C3);             // integer timestamp
+    put32(pkt + 20, 0);                      // fractional timestamp (64 bit)
+    put32(pkt + 24, 0x00001234);
+    memcpy(pkt + 28, payload, len);
+    return words * 4;
+}
+
+static void test_decodes_radio_and_clients()
+{
+    FlexRadioInfo r;
+    TEST_ASSERT_TRUE(FlexDiscovery::decode(pkt, buildPacket(PAYLOAD), r));
+    TEST_ASSERT_TRUE(r.ip == IPAddress(192, 168, 1, 50));
+    TEST_ASSERT_EQUAL_UINT16(4992, r.port);
+    TEST_ASSERT_EQUAL_STRING("FLEX-6600", r.model);
+    TEST_ASSERT_EQUAL_STRING("1019-1234-6600-5678", r.serial);
+    TEST_ASSERT_EQUAL_STRING("HB9IIU", r.nickname);
+    TEST_ASSERT_EQUAL_STRING("In_Use", r.status);
+    TEST_ASSERT_EQUAL_INT8(3, r.availableSlices);
+    TEST_ASSERT_EQUAL_INT8(1, r.availableClients);
+    TEST_ASSERT_EQUAL_UINT8(1, r.clientCount); // inuse_ip and both gui_client_ips are one PC
+    TEST_ASSERT_TRUE(r.clients[0] == IPAddress(192, 168, 1, 20));
+}
+
+static void test_rejects_other_packets()
+{
+    FlexRadioInfo r;
+    TEST_ASSERT_FALSE(FlexDiscovery::decode(pkt, buildPacket(PAYLOAD, 0x00000801), r)); // not the discovery stream
+    TEST_ASSERT_FALSE(FlexDiscovery::decode(pkt, buildPacket(PAYLOAD, 0x00000800, 0x8003), r)); // meter data class
+    size_t size = buildPacket(PAYLOAD);
+    TEST_ASSERT_FALSE(FlexDiscovery::decode(pkt, size - 4, r)); // header says more than arrived
+    TEST_ASSERT_FALSE(FlexDiscovery::decode(pkt, buildPacket("model=FLEX-6400 port=4992"), r)); // no ip
+}
+
+static void test_bounds_long_values()
+{
+    FlexRadioInfo r;
+    TEST_ASSERT_TRUE(FlexDiscovery::decode(
+        pkt, buildPacket("ip=10.0.0.2 nickname=AVeryLongNicknameThatDoesNotFit port=99999"), r));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(r.nickname) - 1, strlen(r.nickname));
+    TEST_ASSERT_EQUAL_UINT16(4992, r.port); // out of range: default kept
+    TEST_ASSERT_EQUAL_INT8(-1, r.availableSlices);
+}
+
+void setup()
+{
+    delay(2000); // let the test runner open the serial port
+    UNITY_BEGIN();
+    RUN_TEST(test_decodes_radio_and_clients);
+    RUN_TEST(test_rejects_other_packets);
+    RUN_TEST(test_bounds_long_values);
+    UNITY_END();
+}
+
+void loop()
+{
+}
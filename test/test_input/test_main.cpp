@@ -0,0 +1,300 @@
+// InputEngine gesture timing (press/release, click, long press, double
+// tap, debounce) and InputBindings' NVS blob round-trips, with the
+// firmware's default map.
+// Runs on the board: pio test -e esp32dev-serial -f test_input
+#include <Arduino.h>
+#include <unity.h>
+#include <Preferences.h>
+#include <string.h>
+#include "HB9IIUInputEngine.h"
+#include "HB9IIUInputBindings.h"
+
+// A pad (active high), a button to GND, a pad without long/double gestures
+static const InputPin TABLE[] = {
+    {"pad", 4, true, 100, 800, 300},
+    {"btn", 40, false, 50, 800, 300},
+    {"plain", 5, true, 100, 0, 0},
+};
+static const uint8_t PAD = 0, BTN = 1, PLAIN = 2;
+
+// Idle levels: pads low, the button's pull-up high
+static const uint64_t IDLE = 1ULL << 40;
+
+static InputEngine engine;
+static char got[128];
+
+static uint64_t pressed(uint8_t input, uint64_t levels = IDLE)
+{
+    uint64_t bit = 1ULL << TABLE[input].pin;
+    return TABLE[input].activeHigh ? levels | bit : levels & ~bit;
+}
+
+// One scan; the events as "input:gesture ..." (empty if none)
+static const char *scan(uint64_t levels, uint32_t ms)
+{
+    InputEvent ev[8];
+    uint8_t n = engine.scan(levels, ms, ev, 8);
+    got[0] = '\0';
+    for (uint8_t i = 0; i < n; i++)
+    {
+        size_t len = strlen(got);
+        snprintf(got + len, sizeof(got) - len, "%s%s:%s", len ? " " : "", TABLE[ev[i].input].name,
+                 InputEngine::gestureName(ev[i].gesture));
+    }
+    return got;
+}
+
+void setUp()
+{
+    engine.begin(TABLE, 3, IDLE, 0);
+}
+
+void tearDown()
+{
+}
+
+static void test_press_and_release_come_at_once()
+{
+    TEST_ASSERT_EQUAL_STRING("plain:press", scan(pressed(PLAIN), 1000));
+    TEST_ASSERT_EQUAL_STRING("", scan(pressed(PLAIN), 1200));
+    TEST_ASSERT_FALSE(engine.busy()); // no long press to wait for
+    // no double-tap configured: the click comes with the release
+    TEST_ASSERT_EQUAL_STRING("plain:release plain:click", scan(IDLE, 1300));
+    TEST_ASSERT_FALSE(engine.busy());
+}
+
+static void test_active_low_button()
+{
+    TEST_ASSERT_EQUAL_STRING("btn:press", scan(pressed(BTN), 1000));
+    TEST_ASSERT_TRUE(engine.active(BTN));
+    TEST_ASSERT_EQUAL_STRING("btn:release", scan(IDLE, 1100));
+    TEST_ASSERT_FALSE(engine.active(BTN));
+}
+
+static void test_debounce_ignores_chatter()
+{
+    // leading edge counts, bounces inside 100 ms do not
+    TEST_ASSERT_EQUAL_STRING("pad:press", scan(pressed(PAD), 1000));
+    TEST_ASSERT_EQUAL_STRING("", scan(IDLE, 1010));
+    TEST_ASSERT_TRUE(engine.busy()); // sample again once the window is over
+    TEST_ASSERT_EQUAL_STRING("", scan(pressed(PAD), 1030));
+    TEST_ASSERT_EQUAL_STRING("", scan(IDLE, 1060));
+    TEST_ASSERT_EQUAL_STRING("", scan(pressed(PAD), 1090));
+    TEST_ASSERT_TRUE(engine.active(PAD));
+
+    // a real release after the window, then bounces on the release
+    TEST_ASSERT_EQUAL_STRING("pad:release", scan(IDLE, 1200));
+    TEST_ASSERT_EQUAL_STRING("", scan(pressed(PAD), 1220));
+    TEST_ASSERT_EQUAL_STRING("", scan(IDLE, 1240));
+    TEST_ASSERT_EQUAL_STRING("pad:click", scan(IDLE, 1600));
+
+    // the shorter window of the button
+    TEST_ASSERT_EQUAL_STRING("btn:press", scan(pressed(BTN), 2000));
+    TEST_ASSERT_EQUAL_STRING("", scan(IDLE, 2040));
+    TEST_ASSERT_EQUAL_STRING("btn:release", scan(IDLE, 2050));
+}
+
+static void test_click_waits_for_a_second_tap()
+{
+    TEST_ASSERT_EQUAL_STRING("pad:press", scan(pressed(PAD), 1000));
+    TEST_ASSERT_EQUAL_STRING("pad:release", scan(IDLE, 1150));
+    TEST_ASSERT_TRUE(engine.busy());
+    TEST_ASSERT_EQUAL_STRING("", scan(IDLE, 1450)); // exactly doubleMs: still open
+    TEST_ASSERT_EQUAL_STRING("pad:click", scan(IDLE, 1451));
+    TEST_ASSERT_FALSE(engine.busy());
+}
+
+static void test_double_tap()
+{
+    TEST_ASSERT_EQUAL_STRING("pad:press", scan(pressed(PAD), 1000));
+    TEST_ASSERT_EQUAL_STRING("pad:release", scan(IDLE, 1150));
+    TEST_ASSERT_EQUAL_STRING("pad:press pad:double", scan(pressed(PAD), 1400));
+    // the second release is no click, and nothing is left pending
+    TEST_ASSERT_EQUAL_STRING("pad:release", scan(IDLE, 1550));
+    TEST_ASSERT_EQUAL_STRING("", scan(IDLE, 2000));
+    TEST_ASSERT_FALSE(engine.busy());
+
+    // too slow for a double: two clicks
+    TEST_ASSERT_EQUAL_STRING("pad:press", scan(pressed(PAD), 3000));
+    TEST_ASSERT_EQUAL_STRING("pad:release", scan(IDLE, 3150));
+    TEST_ASSERT_EQUAL_STRING("pad:click", scan(IDLE, 3500));
+    TEST_ASSERT_EQUAL_STRING("pad:press", scan(pressed(PAD), 3600));
+}
+
+static void test_long_press_fires_once()
+{
+    TEST_ASSERT_EQUAL_STRING("pad:press", scan(pressed(PAD), 1000));
+    TEST_ASSERT_EQUAL_STRING("", scan(pressed(PAD), 1799));
+    TEST_ASSERT_TRUE(engine.busy());
+    TEST_ASSERT_EQUAL_STRING("pad:long", scan(pressed(PAD), 1800));
+    TEST_ASSERT_EQUAL_STRING("", scan(pressed(PAD), 3000));
+    TEST_ASSERT_FALSE(engine.busy());
+    // released after a long press: no click
+    TEST_ASSERT_EQUAL_STRING("pad:release", scan(IDLE, 3100));
+    TEST_ASSERT_EQUAL_STRING("", scan(IDLE, 3500));
+}
+
+static void test_held_at_boot_is_ignored()
+{
+    engine.begin(TABLE, 3, pressed(PAD), 0);
+    TEST_ASSERT_EQUAL_STRING("", scan(pressed(PAD), 2000)); // no long press
+    TEST_ASSERT_EQUAL_STRING("pad:release", scan(IDLE, 2100));
+    TEST_ASSERT_EQUAL_STRING("", scan(IDLE, 2500)); // and no click
+}
+
+static void test_simultaneous_inputs()
+{
+    TEST_ASSERT_EQUAL_STRING("pad:press btn:press", scan(pressed(BTN, pressed(PAD)), 1000));
+    TEST_ASSERT_EQUAL_STRING("pad:long btn:long", scan(pressed(BTN, pressed(PAD)), 1800));
+}
+
+// ---------------- bindings ----------------
+
+// The firmware's default map (DEFAULT_BINDINGS in src/main.cpp; the
+// action ids are stored in NVS and never renumbered)
+static const InputBinding DEFAULTS[] = {
+    {0, GESTURE_PRESS, 1},   // pad1 -> ft8_40m
+    {1, GESTURE_PRESS, 2},   // pad2 -> ft8_20m
+    {2, GESTURE_PRESS, 3},   // pad3 -> ptt_on
+    {2, GESTURE_RELEASE, 4}, // pad3 -> ptt_off
+    {3, GESTURE_PRESS, 5},   // pad4 -> tune
+    {4, GESTURE_PRESS, 6},   // pad5 -> mode_cycle
+    {5, GESTURE_PRESS, 8},   // bw -> reboot
+    {6, GESTURE_PRESS, 7},   // vol -> mute
+};
+static const uint8_t NUM_DEFAULTS = sizeof(DEFAULTS) / sizeof(DEFAULTS[0]);
+
+static const char *NVS_NS = "test_input";
+static const char *KEY = "inbind";
+
+static void assertSameMap(const InputBindings &a, const InputBindings &b)
+{
+    TEST_ASSERT_EQUAL_UINT8(a.count(), b.count());
+    for (uint8_t i = 0; i < a.count(); i++)
+    {
+        TEST_ASSERT_EQUAL_UINT8(a.at(i).input, b.at(i).input);
+        TEST_ASSERT_EQUAL_UINT8(a.at(i).gesture, b.at(i).gesture);
+        TEST_ASSERT_EQUAL_UINT8(a.at(i).action, b.at(i).action);
+    }
+}
+
+static void test_defaults_round_trip()
+{
+    Preferences prefs;
+    TEST_ASSERT_TRUE(prefs.begin(NVS_NS, false));
+    prefs.remove(KEY);
+
+    InputBindings saved;
+    saved.setDefaults(DEFAULTS, NUM_DEFAULTS);
+    saved.load(prefs, KEY); // nothing saved: the defaults stay
+    TEST_ASSERT_EQUAL_UINT8(NUM_DEFAULTS, saved.count());
+    TEST_ASSERT_EQUAL_UINT8(3, saved.action(2, GESTURE_PRESS));
+    TEST_ASSERT_EQUAL_UINT8(4, saved.action(2, GESTURE_RELEASE));
+    TEST_ASSERT_TRUE(saved.save(prefs));
+
+    InputBindings loaded;
+    loaded.setDefaults(DEFAULTS, 1); // different, so the blob has to win
+    loaded.load(prefs, KEY);
+    assertSameMap(saved, loaded);
+    prefs.end();
+}
+
+static void test_changed_map_round_trip_and_reset()
+{
+    Preferences prefs;
+    TEST_ASSERT_TRUE(prefs.begin(NVS_NS, false));
+    prefs.remove(KEY);
+
+    InputBindings b;
+    b.setDefaults(DEFAULTS, NUM_DEFAULTS);
+    b.load(prefs, KEY);
+    TEST_ASSERT_TRUE(b.bind(5, GESTURE_PRESS, 0));  // bw press: unbound
+    TEST_ASSERT_TRUE(b.bind(5, GESTURE_LONG, 8));   // reboot on long press instead
+    TEST_ASSERT_TRUE(b.bind(0, GESTURE_DOUBLE, 5)); // new gesture
+    TEST_ASSERT_TRUE(b.bind(6, GESTURE_PRESS, 6));  // rebind in place
+    TEST_ASSERT_TRUE(b.save(prefs));
+
+    InputBindings loaded;
+    loaded.setDefaults(DEFAULTS, NUM_DEFAULTS);
+    loaded.load(prefs, KEY);
+    assertSameMap(b, loaded);
+    TEST_ASSERT_EQUAL_UINT8(0, loaded.action(5, GESTURE_PRESS));
+    TEST_ASSERT_EQUAL_UINT8(8, loaded.action(5, GESTURE_LONG));
+    TEST_ASSERT_EQUAL_UINT8(5, loaded.action(0, GESTURE_DOUBLE));
+    TEST_ASSERT_EQUAL_UINT8(6, loaded.action(6, GESTURE_PRESS));
+
+    // reset: defaults back, and the saved blob is gone
+    loaded.reset(prefs);
+    TEST_ASSERT_EQUAL_UINT8(8, loaded.action(5, GESTURE_PRESS));
+    TEST_ASSERT_EQUAL_UINT32(0, prefs.getBytesLength(KEY));
+    prefs.end();
+}
+
+static void test_bad_blob_keeps_defaults()
+{
+    Preferences prefs;
+    TEST_ASSERT_TRUE(prefs.begin(NVS_NS, false));
+
+    uint8_t junk[5] = {1, 2, 0, 0, 3}; // wrong size (an older layout)
+    prefs.putBytes(KEY, junk, sizeof(junk));
+    InputBindings b;
+    b.setDefaults(DEFAULTS, NUM_DEFAULTS);
+    b.load(prefs, KEY);
+    TEST_ASSERT_EQUAL_UINT8(NUM_DEFAULTS, b.count());
+
+    // right size, unknown version
+    TEST_ASSERT_TRUE(b.save(prefs));
+    size_t len = prefs.getBytesLength(KEY);
+    uint8_t blob[128];
+    TEST_ASSERT_TRUE(len <= sizeof(blob));
+    prefs.getBytes(KEY, blob, len);
+    blob[0] = 99;
+    blob[1] = 1;
+    prefs.putBytes(KEY, blob, len);
+    InputBindings c;
+    c.setDefaults(DEFAULTS, NUM_DEFAULTS);
+    c.load(prefs, KEY);
+    TEST_ASSERT_EQUAL_UINT8(NUM_DEFAULTS, c.count());
+
+    prefs.remove(KEY);
+    prefs.end();
+}
+
+static void test_map_full()
+{
+    InputBindings b;
+    b.setDefaults(DEFAULTS, NUM_DEFAULTS);
+    for (uint8_t input = 0; input < 8; input++)
+        for (uint8_t g = 0; g < GESTURE_COUNT; g++)
+            b.bind(input, (InputGesture)g, 1);
+    TEST_ASSERT_EQUAL_UINT8(InputBindings::MAX_BINDINGS, b.count());
+    TEST_ASSERT_FALSE(b.bind(15, GESTURE_LONG, 2));
+    TEST_ASSERT_TRUE(b.bind(15, GESTURE_LONG, 0)); // removing what is not there is fine
+    TEST_ASSERT_TRUE(b.bind(0, GESTURE_PRESS, 2)); // rebinding needs no room
+    // removing one makes room again
+    TEST_ASSERT_TRUE(b.bind(0, GESTURE_PRESS, 0));
+    TEST_ASSERT_EQUAL_UINT8(InputBindings::MAX_BINDINGS - 1, b.count());
+}
+
+void setup()
+{
+    delay(2000); // let the test runner open the serial port
+    UNITY_BEGIN();
+    RUN_TEST(test_press_and_release_come_at_once);
+    RUN_TEST(test_active_low_button);
+    RUN_TEST(test_debounce_ignores_chatter);
+    RUN_TEST(test_click_waits_for_a_second_tap);
+    RUN_TEST(test_double_tap);
+    RUN_TEST(test_long_press_fires_once);
+    RUN_TEST(test_held_at_boot_is_ignored);
+    RUN_TEST(test_simultaneous_inputs);
+    RUN_TEST(test_defaults_round_trip);
+    RUN_TEST(test_changed_map_round_trip_and_reset);
+    RUN_TEST(test_bad_blob_keeps_defaults);
+    RUN_TEST(test_map_full);
+    UNITY_END();
+}
+
+void loop()
+{
+}
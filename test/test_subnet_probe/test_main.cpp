@@ -0,0 +1,185 @@
+// SubnetProbe: the candidate list (likely hosts, neighbours, ARP copy,
+// subnet sweep) in the order probes go out, then real probes against a
+// stand-in listener on the loopback interface.
+// Runs on the board: pio test -e esp32dev-serial -f test_subnet_probe
+#include <Arduino.h>
+#include <unity.h>
+#include <WiFi.h>
+#include "HB9IIUSubnetProbe.h"
+
+static const IPAddress SELF(192, 168, 1, 20);
+static const uint16_t PORT = 15002;
+
+static SubnetProbe probe;
+
+// Every candidate left, in probe order; returns how many
+static uint16_t drain(IPAddress *out, uint16_t max)
+{
+    uint16_t n = 0;
+    IPAddress ip;
+    while (probe.nextCandidate(ip))
+    {
+        if (n < max)
+            out[n] = ip;
+        n++;
+    }
+    return n;
+}
+
+static void test_likely_hosts_first_then_sweep()
+{
+    probe.begin(SELF, PORT, 200);
+    probe.add(IPAddress(192, 168, 1, 50));
+    probe.add(IPAddress(0, 0, 0, 0));       // no address: skipped
+    probe.add(SELF);                        // ourselves: skipped
+    probe.add(IPAddress(192, 168, 1, 50));  // duplicate: skipped
+    probe.addNeighbours(IPAddress(192, 168, 1, 1), 3); // gateway .1: .2 .3 .4
+    probe.sweep(IPAddress(255, 255, 255, 0), false);
+
+    IPAddress c[300];
+    uint16_t n = drain(c, 300);
+    TEST_ASSERT_TRUE(c[0] == IPAddress(192, 168, 1, 50));
+    TEST_ASSERT_TRUE(c[1] == IPAddress(192, 168, 1, 2));
+    TEST_ASSERT_TRUE(c[2] == IPAddress(192, 168, 1, 3));
+    TEST_ASSERT_TRUE(c[3] == IPAddress(192, 168, 1, 4));
+    // sweep .1 .. .254 without us and the four already tried
+    TEST_ASSERT_TRUE(c[4] == IPAddress(192, 168, 1, 1));
+    TEST_ASSERT_TRUE(c[5] == IPAddress(192, 168, 1, 5));
+    TEST_ASSERT_TRUE(c[n - 1] == IPAddress(192, 168, 1, 254));
+    TEST_ASSERT_EQUAL_UINT16(4 + 254 - 1 - 4, n);
+    for (uint16_t i = 0; i < n; i++)
+        TEST_ASSERT_FALSE(c[i] == SELF);
+    TEST_ASSERT_TRUE(probe.exhausted());
+}
+
+static void test_neighbours_stay_inside_the_last_octet()
+{
+    probe.begin(SELF, PORT, 200);
+    probe.addNeighbours(IPAddress(192, 168, 1, 254), 2);
+    IPAddress c[8];
+    TEST_ASSERT_EQUAL_UINT16(2, drain(c, 8)); // no .255, no .0 of the next net
+    TEST_ASSERT_TRUE(c[0] == IPAddress(192, 168, 1, 253));
+    TEST_ASSERT_TRUE(c[1] == IPAddress(192, 168, 1, 252));
+
+    probe.begin(SELF, PORT, 200);
+    probe.addNeighbours(IPAddress(10, 0, 0, 2), 3);
+    TEST_ASSERT_EQUAL_UINT16(4, drain(c, 8)); // .3 .1 .4 .5, never .0
+    TEST_ASSERT_TRUE(c[0] == IPAddress(10, 0, 0, 3));
+    TEST_ASSERT_TRUE(c[1] == IPAddress(10, 0, 0, 1));
+}
+
+static void test_priority_list_is_capped()
+{
+    probe.begin(SELF, PORT, 200);
+    for (uint8_t i = 0; i < 40; i++)
+        probe.add(IPAddress(10, 1, 0, 100 + i));
+    IPAddress c[64];
+    TEST_ASSERT_EQUAL_UINT16(SubnetProbe::MAX_PRIORITY, drain(c, 64));
+}
+
+static void test_sweep_widths()
+{
+    IPAddress none[1];
+
+    // a /16 is swept as our /24 unless wide sweeps are allowed
+    probe.begin(SELF, PORT, 200);
+    probe.sweep(IPAddress(255, 255, 0, 0), false);
+    TEST_ASSERT_EQUAL_UINT16(253, drain(none, 0));
+
+    // allowed: still no wider than MIN_PREFIX (/20 = 4094 hosts)
+    probe.begin(SELF, PORT, 200);
+    probe.sweep(IPAddress(255, 255, 0, 0), true);
+    TEST_ASSERT_EQUAL_UINT16(4094 - 1, drain(none, 0));
+
+    // /30: the two hosts, one of them us
+    probe.begin(IPAddress(10, 0, 0, 1), PORT, 200);
+    probe.sweep(IPAddress(255, 255, 255, 252), false);
+    IPAddress c[4];
+    TEST_ASSERT_EQUAL_UINT16(1, drain(c, 4));
+    TEST_ASSERT_TRUE(c[0] == IPAddress(10, 0, 0, 2));
+
+    // /31: nothing to sweep
+    probe.begin(SELF, PORT, 200);
+    probe.sweep(IPAddress(255, 255, 255, 254), true);
+    TEST_ASSERT_EQUAL_UINT16(0, drain(none, 0));
+}
+
+static void test_arp_copy()
+{
+    // the copy runs under the lwIP core lock (or on the tcpip thread);
+    // with no traffic yet the table holds nothing we would probe
+    probe.begin(SELF, PORT, 200);
+    probe.add(IPAddress(192, 168, 1, 50));
+    probe.addArpTable();
+    IPAddress c[SubnetProbe::MAX_PRIORITY];
+    uint16_t n = drain(c, SubnetProbe::MAX_PRIORITY);
+    TEST_ASSERT_TRUE(n >= 1);
+    TEST_ASSERT_TRUE(c[0] == IPAddress(192, 168, 1, 50)); // added hosts keep their place
+    for (uint16_t i = 1; i < n; i++)
+    {
+        TEST_ASSERT_FALSE(c[i] == SELF);
+        TEST_ASSERT_FALSE((uint32_t)c[i] == 0);
+    }
+}
+
+// ---------------- stand-in listener on 127.0.0.1 ----------------
+
+static void test_finds_the_listener()
+{
+    WiFiServer listener(PORT);
+    listener.begin();
+
+    probe.begin(SELF, PORT, 500);
+    probe.add(IPAddress(127, 0, 0, 1));
+    IPAddress found;
+    TEST_ASSERT_TRUE(probe.run(found, 2000));
+    TEST_ASSERT_TRUE(found == IPAddress(127, 0, 0, 1));
+    TEST_ASSERT_EQUAL_UINT16(1, probe.probed());
+    listener.end();
+}
+
+static void test_gives_up_when_nobody_listens()
+{
+    probe.begin(SELF, PORT + 1, 300);
+    probe.add(IPAddress(127, 0, 0, 1));
+    IPAddress found;
+    TEST_ASSERT_FALSE(probe.run(found, 2000));
+    TEST_ASSERT_TRUE(probe.exhausted());
+    TEST_ASSERT_EQUAL_UINT16(1, probe.probed());
+}
+
+static void test_runs_in_slices()
+{
+    // as serviceLink() does it: short slices from loop() until something answers
+    WiFiServer listener(PORT);
+    listener.begin();
+    probe.begin(SELF, PORT, 500);
+    probe.add(IPAddress(127, 0, 0, 1));
+    IPAddress found;
+    bool ok = probe.run(found, 0);
+    for (uint8_t i = 0; i < 50 && !ok && !probe.exhausted(); i++)
+        ok = probe.run(found, 20);
+    TEST_ASSERT_TRUE(ok);
+    TEST_ASSERT_TRUE(found == IPAddress(127, 0, 0, 1));
+    listener.end();
+}
+
+void setup()
+{
+    delay(2000); // let the test runner open the serial port
+    WiFi.mode(WIFI_STA); // brings up lwIP (loopback only, no AP needed)
+    UNITY_BEGIN();
+    RUN_TEST(test_likely_hosts_first_then_sweep);
+    RUN_TEST(test_neighbours_stay_inside_the_last_octet);
+    RUN_TEST(test_priority_list_is_capped);
+    RUN_TEST(test_sweep_widths);
+    RUN_TEST(test_arp_copy);
+    RUN_TEST(test_finds_the_listener);
+    RUN_TEST(test_gives_up_when_nobody_listens);
+    RUN_TEST(test_runs_in_slices);
+    UNITY_END();
+}
+
+void loop()
+{
+}
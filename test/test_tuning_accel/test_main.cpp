@@ -0,0 +1,146 @@
+// TuningAccel replayed over detent timing traces in the shape the VFO knob
+// produces (one entry per encoder scan: detents seen, time per detent):
+// step sizes along a slow turn, a spin-up and a slow-down, grid snapping
+// in both directions, range clamping.
+// Runs on the board: pio test -e esp32dev-serial -f test_tuning_accel
+#include <Arduino.h>
+#include <unity.h>
+#include "HB9IIUTuningAccel.h"
+
+struct TraceStep
+{
+    int8_t detents;      // detents in this scan
+    uint32_t intervalUs; // time per detent (0xFFFFFFFF: first after a pause)
+};
+
+static const uint32_t PAUSE = 0xFFFFFFFFUL;
+
+// Slow, deliberate tuning onto a signal: 4..12 detents/s with a pause
+static const TraceStep SLOW_TURN[] = {
+    {1, PAUSE}, {1, 240000}, {1, 180000}, {1, 150000}, {1, 120000}, {1, 110000},
+    {1, 95000}, {1, 100000}, {1, 130000}, {1, 170000}, {1, 250000}, {-1, PAUSE},
+    {-1, 210000}, {-1, 160000}};
+
+// A flick across the band: 50 -> ~1250 detents/s, several detents per scan
+static const TraceStep SPIN_UP[] = {
+    {1, PAUSE}, {1, 20000}, {2, 9000}, {3, 5000}, {4, 3000}, {6, 2000},
+    {8, 1400}, {10, 1000}, {12, 900}, {12, 800}, {12, 800}};
+
+// The same flick running out: rates fall back to a slow turn
+static const TraceStep SLOW_DOWN[] = {
+    {10, 1000}, {8, 1500}, {6, 2500}, {4, 4000}, {3, 6000}, {2, 9000},
+    {1, 14000}, {1, 20000}, {1, 35000}, {1, 60000}, {1, 90000}, {1, 120000},
+    {1, 150000}};
+
+#define TRACE_LEN(t) (sizeof(t) / sizeof(t[0]))
+
+// Replays a trace and checks every step: the frequency moved by exactly
+// detents x step x multiplier and stayed on the grid. Multipliers go to mults.
+static uint32_t replay(TuningAccel &accel, uint32_t hz, const TraceStep *trace, size_t n,
+                       uint32_t stepHz, uint16_t *mults)
+{
+    for (size_t i = 0; i < n; i++)
+    {
+        uint32_t next = accel.apply(hz, trace[i].detents, trace[i].intervalUs, stepHz);
+        int32_t moved = (int32_t)(next - hz);
+        TEST_ASSERT_EQUAL_INT32(trace[i].detents * (int32_t)stepHz * accel.multiplier(), moved);
+        TEST_ASSERT_EQUAL_UINT32(0, next % stepHz);
+        mults[i] = accel.multiplier();
+        hz = next;
+    }
+    return hz;
+}
+
+static void test_slow_turn_moves_one_step_per_detent()
+{
+    TuningAccel accel;
+    uint16_t mults[TRACE_LEN(SLOW_TURN)];
+    uint32_t hz = replay(accel, 14074000, SLOW_TURN, TRACE_LEN(SLOW_TURN), 10, mults);
+
+    for (size_t i = 0; i < TRACE_LEN(SLOW_TURN); i++)
+        TEST_ASSERT_EQUAL_UINT16(1, mults[i]);
+    TEST_ASSERT_EQUAL_UINT32(14074000 + 11 * 10 - 3 * 10, hz);
+}
+
+static void test_spin_up_ramps_the_step()
+{
+    TuningAccel accel;
+    uint16_t mults[TRACE_LEN(SPIN_UP)];
+    replay(accel, 7000000, SPIN_UP, TRACE_LEN(SPIN_UP), 10, mults);
+
+    // first detent of a flick is still exact; the step never shrinks while
+    // the knob speeds up, and a full flick reaches the steep end of the curve
+    TEST_ASSERT_EQUAL_UINT16(1, mults[0]);
+    for (size_t i = 1; i < TRACE_LEN(SPIN_UP); i++)
+        TEST_ASSERT_TRUE(mults[i] >= mults[i - 1]);
+    TEST_ASSERT_TRUE(mults[TRACE_LEN(SPIN_UP) - 1] >= 30);
+    TEST_ASSERT_TRUE(accel.velocity() > 800);
+}
+
+static void test_slow_down_returns_to_fine_steps()
+{
+    TuningAccel accel;
+    uint16_t up[TRACE_LEN(SPIN_UP)];
+    uint32_t hz = replay(accel, 7000000, SPIN_UP, TRACE_LEN(SPIN_UP), 10, up);
+
+    uint16_t mults[TRACE_LEN(SLOW_DOWN)];
+    replay(accel, hz, SLOW_DOWN, TRACE_LEN(SLOW_DOWN), 10, mults);
+
+    // decelerates without jumps back up, and ends exact again
+    for (size_t i = 1; i < TRACE_LEN(SLOW_DOWN); i++)
+        TEST_ASSERT_TRUE(mults[i] <= mults[i - 1]);
+    TEST_ASSERT_TRUE(mults[0] > 1);
+    TEST_ASSERT_EQUAL_UINT16(1, mults[TRACE_LEN(SLOW_DOWN) - 1]);
+
+    // and a pause drops the speed at once: the next detent is one step
+    TuningAccel fast;
+    replay(fast, 7000000, SPIN_UP, TRACE_LEN(SPIN_UP), 10, up);
+    TEST_ASSERT_EQUAL_UINT32(7000010, fast.apply(7000000, 1, PAUSE, 10));
+    TEST_ASSERT_EQUAL_UINT16(1, fast.multiplier());
+}
+
+static void test_snaps_in_the_direction_of_travel()
+{
+    TuningAccel accel;
+    // off the 10 Hz grid (came from a CW step): next line up / down
+    TEST_ASSERT_EQUAL_UINT32(14074010, accel.apply(14074003, 1, PAUSE, 10));
+    TEST_ASSERT_EQUAL_UINT32(14074000, accel.apply(14074003, -1, PAUSE, 10));
+    // on the grid: exactly one step
+    TEST_ASSERT_EQUAL_UINT32(14074010, accel.apply(14074000, 1, PAUSE, 10));
+    TEST_ASSERT_EQUAL_UINT32(14073990, accel.apply(14074000, -1, PAUSE, 10));
+    // AM's 1 kHz grid and the 1 Hz CW/digital grid
+    TEST_ASSERT_EQUAL_UINT32(7124000, accel.apply(7123456, 1, PAUSE, 1000));
+    TEST_ASSERT_EQUAL_UINT32(7123000, accel.apply(7123456, -1, PAUSE, 1000));
+    TEST_ASSERT_EQUAL_UINT32(7123457, accel.apply(7123456, 1, PAUSE, 1));
+    TEST_ASSERT_EQUAL_UINT32(7123455, accel.apply(7123456, -1, PAUSE, 1));
+}
+
+static void test_range_clamps_a_fast_spin()
+{
+    TuningAccel accel;
+    accel.setRange(30000, 54000000);
+    uint32_t hz = 53990000;
+    for (size_t i = 0; i < TRACE_LEN(SPIN_UP); i++)
+    {
+        hz = accel.apply(hz, SPIN_UP[i].detents, SPIN_UP[i].intervalUs, 10);
+        TEST_ASSERT_TRUE(hz <= 54000000);
+    }
+    TEST_ASSERT_EQUAL_UINT32(54000000, hz);
+    TEST_ASSERT_EQUAL_UINT32(30000, accel.apply(40000, -12, 800, 10));
+}
+
+void setup()
+{
+    delay(2000); // let the test runner open the serial port
+    UNITY_BEGIN();
+    RUN_TEST(test_slow_turn_moves_one_step_per_detent);
+    RUN_TEST(test_spin_up_ramps_the_step);
+    RUN_TEST(test_slow_down_returns_to_fine_steps);
+    RUN_TEST(test_snaps_in_the_direction_of_travel);
+    RUN_TEST(test_range_clamps_a_fast_spin);
+    UNITY_END();
+}
+
+void loop()
+{
+}
@@ -0,0 +1,164 @@
+#!/usr/bin/env python3
+"""Knob latency under web and OTA load, read from the controller's /stats.
+
+    python3 tools/latency_stress.py flexcontroller.local \\
+        --firmware .pio/build/esp32dev/firmware.bin
+
+Runs one phase per load (none, /logs polling, an OTA upload, both). Each
+phase resets the input latency figures (/stats?reset=1), starts the load,
+and asks you to turn the VFO knob steadily until the phase ends; then it
+reads "input->sent" (edge -> scheduler write), loop idle time and dropped
+log lines back from /stats and prints one row per phase.
+
+The OTA phase streams the firmware with espota.py and kills the upload
+when the phase ends, so the update is aborted and the controller keeps
+running. If the upload finishes first the controller reboots: use a
+shorter --seconds.
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+import threading
+import time
+import urllib.request
+
+PHASES = ("idle", "logs", "ota", "logs+ota")
+
+STATS = {
+    "avg_us": re.compile(r"input->sent avg=(\d+)us"),
+    "max_us": re.compile(r"input->sent avg=\d+us max=(\d+)us"),
+    "inputs": re.compile(r"input->sent .*? inputs=(\d+)"),
+    "idle_pct": re.compile(r"idle=([\d.]+)%"),
+    "log_dropped": re.compile(r"log_dropped=(\d+)"),
+}
+
+
+def fetch(url, timeout=5):
+    with urllib.request.urlopen(url, timeout=timeout) as r:
+        return r.read().decode("utf-8", "replace")
+
+
+def parse_stats(text):
+    out = {}
+    for key, rx in STATS.items():
+        m = rx.search(text)
+        out[key] = m.group(1) if m else "?"
+    return out
+
+
+class LogsPoller:
+    """clients threads, each GETting /logs rate times a second."""
+
+    def __init__(self, host, clients, rate):
+        self.url = "http://%s/logs" % host
+        self.clients = clients
+        self.period = 1.0 / rate
+        self.stop_flag = threading.Event()
+        self.requests = 0
+        self.errors = 0
+        self.threads = []
+
+    def run(self):
+        while not self.stop_flag.is_set():
+            t0 = time.monotonic()
+            try:
+                fetch(self.url)
+                self.requests += 1
+            except OSError:
+                self.errors += 1
+            self.stop_flag.wait(max(0.0, self.period - (time.monotonic() - t0)))
+
+    def start(self):
+        self.threads = [threading.Thread(target=self.run, daemon=True) for _ in range(self.clients)]
+        for t in self.threads:
+            t.start()
+
+    def stop(self):
+        self.stop_flag.set()
+        for t in self.threads:
+            t.join()
+
+
+def find_espota():
+    pio = os.path.expanduser("~/.platformio/packages/framework-arduinoespressif32/tools/espota.py")
+    return pio if os.path.exists(pio) else None
+
+
+def start_ota(opts):
+    cmd = [sys.executable, opts.espota, "-i", opts.host, "-p", str(opts.ota_port), "-f", opts.firmware]
+    return subprocess.Popen(cmd, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+def run_phase(opts, phase):
+    base = "http://%s" % opts.host
+    fetch(base + "/stats?reset=1")
+
+    poller = ota = None
+    if "logs" in phase:
+        poller = LogsPoller(opts.host, opts.clients, opts.rate)
+        poller.start()
+    if "ota" in phase:
+        ota = start_ota(opts)
+
+    print("[%s] turn the VFO knob steadily for %d s ..." % (phase, opts.seconds), flush=True)
+    deadline = time.monotonic() + opts.seconds
+    finished = False
+    while time.monotonic() < deadline:
+        if ota and ota.poll() is not None:
+            finished = True
+            break
+        time.sleep(0.2)
+
+    stats = parse_stats(fetch(base + "/stats")) if not finished else None
+
+    if ota and ota.poll() is None:
+        ota.kill()  # abort the transfer: the controller drops the update
+        ota.wait()
+    if poller:
+        poller.stop()
+
+    if finished:
+        sys.exit("latency_stress: the OTA upload finished and the controller reboots; "
+                 "use a shorter --seconds")
+    row = dict(stats, phase=phase)
+    row["logs_req"] = str(poller.requests) if poller else "-"
+    return row
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("host", help="controller address or mDNS name")
+    ap.add_argument("--seconds", type=int, default=20, help="length of each phase")
+    ap.add_argument("--clients", type=int, default=2, help="parallel /logs pollers")
+    ap.add_argument("--rate", type=float, default=5.0, help="/logs requests per second per poller")
+    ap.add_argument("--firmware", help="firmware.bin to stream in the OTA phases")
+    ap.add_argument("--espota", default=find_espota(), help="path to espota.py")
+    ap.add_argument("--ota-port", type=int, default=3232)
+    ap.add_argument("--phases", default=",".join(PHASES), help="comma separated, from: " + ", ".join(PHASES))
+    opts = ap.parse_args()
+
+    phases = [p for p in opts.phases.split(",") if p]
+    for p in phases:
+        if p not in PHASES:
+            sys.exit("latency_stress: unknown phase %r" % p)
+        if "ota" in p and not (opts.firmware and opts.espota):
+            sys.exit("latency_stress: the OTA phases need --firmware (and espota.py, --espota)")
+
+    rows = []
+    for p in phases:
+        rows.append(run_phase(opts, p))
+        time.sleep(2)  # let the previous load drain
+
+    cols = ("phase", "inputs", "avg_us", "max_us", "idle_pct", "log_dropped", "logs_req")
+    print()
+    print("| " + " | ".join(cols) + " |")
+    print("|" + "---|" * len(cols))
+    for r in rows:
+        print("| " + " | ".join(r[c] for c in cols) + " |")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""Decode a binary trace dump from the controller's /trace page.
+
+    curl -s http://flexcontroller.local/trace -o trace.bin
+    python3 tools/trace_decode.py trace.bin
+
+Format strings are read from lib/HB9IIUTrace/HB9IIUTraceMessages.h, so the
+dump must come from firmware built from the same catalogue.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+DEFAULT_CATALOGUE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "lib",
+                                 "HB9IIUTrace", "HB9IIUTraceMessages.h")
+
+HEADER = struct.Struct("<4sBBHII")   # magic, version, record size, count, lost, now_us
+RECORD = struct.Struct("<IHBB40s")   # us, id, len, flags, payload
+FLAG_TEXT = 0x01
+FLAG_CONT = 0x02   # more text of the record before
+SPEC = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?([diuxXcs%])")
+
+
+def load_catalogue(path):
+    """Message formats in id order (the X() order of the header)."""
+    with open(path, encoding="utf-8") as f:
+        text = re.sub(r"//[^\n]*", "", f.read())
+    return [bytes(m, "ascii").decode("unicode_escape")
+            for m in re.findall(r'X\(\s*\w+\s*,\s*"((?:[^"\\]|\\.)*)"\s*\)', text)]
+
+
+def render(fmt, args=None, text=None):
+    """printf-style formatting of 32-bit args, as the firmware's snprintf does."""
+    values = iter(args or [])
+
+    def one(m):
+        flags, width, prec, conv = m.groups()
+        if conv == "%":
+            return "%"
+        spec = "%" + flags + width + ("." + prec if prec else "")
+        if conv == "s":
+            return (spec + "s") % (text if text is not None else "")
+        v = next(values, 0)
+        if conv in "di":
+            v = v - (1 << 32) if v & 0x80000000 else v
+            return (spec + "d") % v
+        if conv == "c":
+            return (spec + "c") % chr(v & 0xFF)
+        return (spec + ("d" if conv == "u" else conv)) % v
+
+    return SPEC.sub(one, fmt)
+
+
+def decode(data, formats):
+    if len(data) < HEADER.size:
+        raise ValueError("dump too short")
+    magic, version, rec_size, count, lost, now_us = HEADER.unpack_from(data)
+    if magic != b"HBTR" or version != 1 or rec_size != RECORD.size:
+        raise ValueError("not a version 1 trace dump")
+    if len(data) < HEADER.size + count * rec_size:
+        raise ValueError("dump truncated")
+
+    yield "# %d records, %d lost before the log task read them, dumped at %.6f s" % (
+        count, lost, now_us / 1e6)
+    yield "#     time s   delta ms  message"
+    records = [RECORD.unpack_from(data, HEADER.size + i * rec_size) for i in range(count)]
+    prev = None
+    i = 0
+    while i < count:
+        us, mid, length, flags, payload = records[i]
+        i += 1
+        fmt = formats[mid] if mid < len(formats) else None
+        if fmt is None:
+            line = "[TRACE] unknown id %d" % mid
+        elif flags & FLAG_TEXT:
+            # a long %s was stored in pieces: join the ones that follow
+            text = payload[:length]
+            while i < count and records[i][3] & FLAG_CONT:
+                text += records[i][4][:records[i][2]]
+                i += 1
+            line = render(fmt, text=text.decode("latin-1"))
+        else:
+            line = render(fmt, args=struct.unpack_from("<%dI" % min(length, 4), payload))
+        # micros() wraps every ~71 min: deltas stay right, absolute times don't
+        delta = "" if prev is None else "+%.3f" % (((us - prev) & 0xFFFFFFFF) / 1e3)
+        prev = us
+        yield "%12.6f %10s  %s" % (us / 1e6, delta, line)
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("dump", help="file saved from /trace ('-' for stdin)")
+    ap.add_argument("--catalogue", default=DEFAULT_CATALOGUE, help="HB9IIUTraceMessages.h")
+    opts = ap.parse_args()
+
+    data = sys.stdin.buffer.read() if opts.dump == "-" else open(opts.dump, "rb").read()
+    try:
+        for line in decode(data, load_catalogue(opts.catalogue)):
+            print(line)
+    except ValueError as e:
+        sys.exit("trace_decode: %s" % e)
+
+
+if __name__ == "__main__":
+    main()